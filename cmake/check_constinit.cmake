@@ -0,0 +1,48 @@
+# Fails if an object file needs dynamic initialization.
+#
+# Compiles SOURCE with CXX and the flags of the response file FLAGS into
+# OBJECT, then fails if NM lists a `_GLOBAL__sub_I_` initializer in it or if
+# OBJDUMP shows an `.init_array` section. LIBRARY, if set, is checked for
+# initializers as well. Its `.init_array` sections are not checked, since
+# sanitizers add their own constructors to the objects of the library.
+
+execute_process(
+  COMMAND "${CXX}" "@${FLAGS}" -c "${SOURCE}" -o "${OBJECT}"
+  RESULT_VARIABLE result
+  ERROR_VARIABLE error
+)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "cannot compile ${SOURCE}:\n${error}")
+endif()
+
+function(check_initializers file)
+  execute_process(
+    COMMAND "${NM}" "${file}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE symbols
+  )
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "cannot list the symbols of ${file}")
+  endif()
+  string(REGEX MATCHALL "_GLOBAL__sub_I_[^\n]*" initializers "${symbols}")
+  if(initializers)
+    message(FATAL_ERROR "dynamic initializers in ${file}: ${initializers}")
+  endif()
+endfunction()
+
+check_initializers("${OBJECT}")
+execute_process(
+  COMMAND "${OBJDUMP}" -h "${OBJECT}"
+  RESULT_VARIABLE result
+  OUTPUT_VARIABLE sections
+)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "cannot list the sections of ${OBJECT}")
+endif()
+if(sections MATCHES "\\.init_array")
+  message(FATAL_ERROR "${OBJECT} has an .init_array section:\n${sections}")
+endif()
+
+if(LIBRARY)
+  check_initializers("${LIBRARY}")
+endif()
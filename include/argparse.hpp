@@ -12,10 +12,28 @@
 
 #include <cstdint>
 #include <cstddef>
-#include <type_traits>
+#include <cstdlib>
 #include <function_ref.hpp>
 #include <iosfwd>
 
+#if __cplusplus >= 201703L
+#define ARGPARSE_INLINE_VAR inline
+#else
+#define ARGPARSE_INLINE_VAR static
+#endif
+
+// marks a variable that must be constant-initialized, compilation fails if it
+// would require a dynamic initializer
+#if defined(__cpp_constinit)
+#define ARGPARSE_CONSTINIT constinit
+#elif defined(__clang__)
+#define ARGPARSE_CONSTINIT [[clang::require_constant_initialization]]
+#elif defined(__GNUC__) && __GNUC__ >= 10
+#define ARGPARSE_CONSTINIT __constinit
+#else
+#define ARGPARSE_CONSTINIT
+#endif
+
 namespace veg {
 
 struct ternary {
@@ -60,8 +78,58 @@ private:
 
 struct argparse;
 struct argparse_option;
+struct argparse_command;
+struct argparse_deferred;
 using argparse_callback = function_ref<int(argparse*, argparse_option const*)>;
 
+// parses `arg` into `*value`, or only checks it if `value` is nullptr.
+// returns nullptr on success, or the reason of the failure
+using argparse_parse_fn = auto (*)(void* value, char const* arg)
+    -> char const*;
+
+// parses the `size` bytes at `arg`, not null-terminated, into `*value`, with
+// the same contract as `argparse_parse_fn`
+using argparse_parse_view_fn =
+    auto (*)(void* value, char const* arg, std::size_t size) -> char const*;
+
+// writes `*value` as text into `buf`, of `size` bytes, null-terminated if
+// `size` is not 0. returns the length of the whole text, as `snprintf`
+using argparse_format_fn =
+    auto (*)(void const* value, char* buf, std::size_t size) -> std::size_t;
+
+/**
+ *  option traits
+ *
+ *  extension point for user-defined value types, specialize it with
+ *
+ *  `placeholder`:
+ *    shown after `=` in the usage, e.g. "<host:port>".
+ *    nullptr if the option takes no value, in which case it is parsed as a
+ *    flag, with `arg` set to "1", or "0" when negated with `--no-`.
+ *
+ *  `parse`:
+ *    `static auto parse(T& out, char const* arg) -> char const*`, with the same
+ *    contract as `argparse_parse_fn`.
+ *
+ *  `format` (optional):
+ *    `static auto format(T const& value, char* buf, std::size_t size)
+ *        -> std::size_t`, with the same contract as `argparse_format_fn`.
+ *    used to report the current value, e.g. by `argparse_format_value`.
+ *
+ *  `parse_view` (optional):
+ *    `static auto parse_view(T& out, char const* arg, std::size_t size)
+ *        -> char const*`, with the same contract as `argparse_parse_view_fn`.
+ *    used by `parse_span`, to parse arguments without a null terminator.
+ *    `parse_span` rejects the values of types without it, as `parse` may
+ *    keep a pointer to its argument.
+ *
+ *  the option stores a pointer to `parse` directly, so parsing a user-defined
+ *  type costs a single indirect call.
+ *  the built-in value types can not be specialized.
+ */
+template <typename T>
+struct option_traits {};
+
 namespace _argparse {
 template <bool Cond>
 struct enable_if {
@@ -70,33 +138,7 @@ struct enable_if {
 template <>
 struct enable_if<false> {};
 
-template <typename T>
-using is_supported = typename enable_if<           //
-    std::is_same<std::nullptr_t, T>::value ||      //
-    std::is_same<char const**, T>::value ||        //
-    std::is_same<ternary*, T>::value ||            //
-    std::is_same<bool*, T>::value ||               //
-                                                   //
-    std::is_same<char*, T>::value ||               //
-                                                   //
-    std::is_same<char signed*, T>::value ||        //
-    std::is_same<short signed*, T>::value ||       //
-    std::is_same<int signed*, T>::value ||         //
-    std::is_same<long signed*, T>::value ||        //
-    std::is_same<long long signed*, T>::value ||   //
-                                                   //
-    std::is_same<char unsigned*, T>::value ||      //
-    std::is_same<short unsigned*, T>::value ||     //
-    std::is_same<int unsigned*, T>::value ||       //
-    std::is_same<long unsigned*, T>::value ||      //
-    std::is_same<long long unsigned*, T>::value || //
-                                                   //
-    std::is_same<float*, T>::value ||              //
-    std::is_same<double*, T>::value ||             //
-    std::is_same<long double*, T>::value           //
-    >::type;
-
-enum struct argparse_option_type {
+enum struct argparse_option_type : unsigned char {
   /* special */
   ARGPARSE_OPT_GROUP,
   /* options with no arguments */
@@ -120,105 +162,194 @@ enum struct argparse_option_type {
   ARGPARSE_OPT_DOUBLE,
   ARGPARSE_OPT_LONG_DOUBLE,
   ARGPARSE_OPT_STRING,
+  /* options parsed through `option_traits` */
+  ARGPARSE_OPT_CUSTOM,
 };
-template <typename T>
-struct to_option_type {};
 
-template <>
-struct to_option_type<std::nullptr_t> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_BOOLEAN; // unused
+template <argparse_option_type Type>
+struct option_type_tag {
+  static constexpr argparse_option_type value = Type;
 };
 
-template <>
-struct to_option_type<char> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_CHAR;
-};
+// maps each supported value pointer type to its option type through overload
+// resolution, which is cheaper to compile than a chain of type traits.
+// declarations only, used in unevaluated contexts
+auto option_type_of(std::nullptr_t)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_BOOLEAN>; // unused
+auto option_type_of(bool*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_BOOLEAN>;
+auto option_type_of(ternary*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_TERNARY>;
+auto option_type_of(char*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_CHAR>;
+auto option_type_of(char unsigned*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_UCHAR>;
+auto option_type_of(short unsigned*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_USHORT>;
+auto option_type_of(int unsigned*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_UINT>;
+auto option_type_of(long unsigned*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_ULONG>;
+auto option_type_of(long long unsigned*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_ULONG_LONG>;
+auto option_type_of(char signed*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_SCHAR>;
+auto option_type_of(short signed*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_SSHORT>;
+auto option_type_of(int signed*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_SINT>;
+auto option_type_of(long signed*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_SLONG>;
+auto option_type_of(long long signed*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_SLONG_LONG>;
+auto option_type_of(float*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_FLOAT>;
+auto option_type_of(double*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_DOUBLE>;
+auto option_type_of(long double*)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_LONG_DOUBLE>;
+auto option_type_of(char const**)
+    -> option_type_tag<argparse_option_type::ARGPARSE_OPT_STRING>;
+// any other type, which keeps a pointer to a class derived from `ternary` or
+// a type converting to one of the pointers above from being accepted. the
+// non-template overloads win on an exact match
+template <typename T>
+auto option_type_of(T) -> void = delete;
 
-template <>
-struct to_option_type<char unsigned> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_UCHAR;
-};
-template <>
-struct to_option_type<short unsigned> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_USHORT;
-};
-template <>
-struct to_option_type<int unsigned> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_UINT;
-};
-template <>
-struct to_option_type<long unsigned> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_ULONG;
-};
-template <>
-struct to_option_type<long long unsigned> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_ULONG_LONG;
-};
+template <typename T>
+using to_option_type = decltype(option_type_of(static_cast<T*>(nullptr)));
 
-template <>
-struct to_option_type<signed char> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_SCHAR;
-};
-template <>
-struct to_option_type<short> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_SSHORT;
-};
-template <>
-struct to_option_type<int> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_SINT;
-};
-template <>
-struct to_option_type<long> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_SLONG;
-};
-template <>
-struct to_option_type<long long> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_SLONG_LONG;
-};
+template <typename T>
+using is_supported = decltype(void(option_type_of(static_cast<T>(nullptr))));
 
-template <>
-struct to_option_type<bool> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_BOOLEAN;
-};
-template <>
-struct to_option_type<ternary> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_TERNARY;
-};
-template <>
-struct to_option_type<float> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_FLOAT;
-};
-template <>
-struct to_option_type<double> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_DOUBLE;
-};
-template <>
-struct to_option_type<long double> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_LONG_DOUBLE;
-};
-template <>
-struct to_option_type<char const*> {
-  static constexpr _argparse::argparse_option_type value =
-      _argparse::argparse_option_type::ARGPARSE_OPT_STRING;
+template <typename T>
+using has_option_traits = decltype(void(&option_traits<T>::parse));
+
+// parses `arg` into a scratch `T`, if `T` is default constructible
+template <typename T>
+auto check_custom(char const* arg, decltype(T())* /*unused*/) -> char const* {
+  T scratch{};
+  return option_traits<T>::parse(scratch, arg);
+}
+template <typename T>
+auto check_custom(char const* /*arg*/, ...) -> char const* {
+  return nullptr;
+}
+
+template <typename T>
+auto parse_custom(void* value, char const* arg) -> char const* {
+  if (value == nullptr) {
+    return check_custom<T>(arg, nullptr);
+  }
+  return option_traits<T>::parse(*static_cast<T*>(value), arg);
+}
+
+template <typename T>
+auto format_custom(void const* value, char* buf, std::size_t size)
+    -> std::size_t {
+  return option_traits<T>::format(*static_cast<T const*>(value), buf, size);
+}
+
+template <typename T>
+auto parse_view_custom(void* value, char const* arg, std::size_t size)
+    -> char const* {
+  return option_traits<T>::parse_view(*static_cast<T*>(value), arg, size);
+}
+
+// `parse_view_custom<T>` if `option_traits<T>` has a `parse_view` function,
+// nullptr otherwise
+template <typename T>
+constexpr auto parse_view_of(decltype(&option_traits<T>::parse_view) /*unused*/)
+    -> argparse_parse_view_fn {
+  return &parse_view_custom<T>;
+}
+template <typename T>
+constexpr auto parse_view_of(...) -> argparse_parse_view_fn {
+  return nullptr;
+}
+
+// `format_custom<T>` if `option_traits<T>` has a `format` function, nullptr
+// otherwise
+template <typename T>
+constexpr auto format_of(decltype(&option_traits<T>::format) /*unused*/)
+    -> argparse_format_fn {
+  return &format_custom<T>;
+}
+template <typename T>
+constexpr auto format_of(...) -> argparse_format_fn {
+  return nullptr;
+}
+
+constexpr auto builtin_placeholder(argparse_option_type type) -> char const* {
+  switch (type) {
+  case argparse_option_type::ARGPARSE_OPT_GROUP:
+  case argparse_option_type::ARGPARSE_OPT_BOOLEAN:
+  case argparse_option_type::ARGPARSE_OPT_TERNARY:
+  case argparse_option_type::ARGPARSE_OPT_CUSTOM:
+    return nullptr;
+  case argparse_option_type::ARGPARSE_OPT_CHAR:
+    return "<char>";
+  case argparse_option_type::ARGPARSE_OPT_STRING:
+    return "<str>";
+  case argparse_option_type::ARGPARSE_OPT_FLOAT:
+  case argparse_option_type::ARGPARSE_OPT_DOUBLE:
+  case argparse_option_type::ARGPARSE_OPT_LONG_DOUBLE:
+    return "<flt>";
+  default:
+    return "<int>";
+  }
+}
+
+// parses `arg` into a value of a built-in type, with the same contract as
+// `argparse_parse_fn`. flags expect "1" or "0"
+auto parse_builtin(argparse_option_type type, void* value, char const* arg)
+    -> char const*;
+
+// values of built-in types parsed from sized arguments are copied to a stack
+// buffer of this size, to be null-terminated
+constexpr std::size_t max_value_size = 256;
+
+// parses the `size` bytes at `arg` into a value of a built-in type, with the
+// same contract as `argparse_parse_view_fn`. `char const*` values are
+// rejected, as they would not be null-terminated
+auto parse_builtin_view(
+    argparse_option_type type, void* value, char const* arg, std::size_t size)
+    -> char const*;
+
+// formats a value of a built-in type, with the same contract as
+// `argparse_format_fn`
+auto format_builtin(
+    argparse_option_type type, void const* value, char* buf, std::size_t size)
+    -> std::size_t;
+
+// `option_traits` interface over both built-in and user-defined types, used
+// to build traits of wrapper types
+template <typename T, typename = void>
+struct value_traits : option_traits<T> {};
+
+template <typename T>
+struct value_traits<T, is_supported<T*>> {
+  static constexpr char const* placeholder =
+      builtin_placeholder(to_option_type<T>::value);
+  static auto parse(T& out, char const* arg) -> char const* {
+    return parse_builtin(to_option_type<T>::value, &out, arg);
+  }
+  static auto parse_view(T& out, char const* arg, std::size_t size)
+      -> char const* {
+    return parse_builtin_view(to_option_type<T>::value, &out, arg, size);
+  }
+  static auto format(T const& value, char* buf, std::size_t size)
+      -> std::size_t {
+    return format_builtin(to_option_type<T>::value, &value, buf, size);
+  }
 };
 
+template <typename T>
+using has_format = decltype(void(&value_traits<T>::format));
+
+template <typename T>
+using has_parse_view = decltype(void(&value_traits<T>::parse_view));
+
 struct layout {
   _argparse::argparse_option_type type{};
   const char short_name{};
@@ -227,16 +358,62 @@ struct layout {
   char const* help{};
   argparse_callback callback = {};
   int flags{};
+  argparse_parse_fn parse{};
+  char const* placeholder{};
+  argparse_format_fn format{};
+  argparse_parse_view_fn parse_view{};
 };
 
+// 32-bit FNV-1a, used to hash long option names
+constexpr auto hash_name(char const* str, std::size_t len) noexcept
+    -> std::uint32_t {
+  std::uint32_t h = 2166136261U;
+  for (std::size_t i = 0; i < len; ++i) {
+    h ^= static_cast<unsigned char>(str[i]);
+    h *= 16777619U;
+  }
+  return h;
+}
+
 auto argparse_parse(argparse* self, int argc, char** argv) -> int;
+
+[[noreturn]] void unknown_command(
+    argparse_command const* commands, std::size_t n_commands, char const* name);
+
+// first argument of a `__complete` query, and of the words handed over to
+// `run_command` while completing
+constexpr char const* complete_marker = "__complete";
+
+// whether `argv`, given to `run_command`, starts with `__complete`
+auto completing_command(int argc, char const* const* argv) noexcept -> bool;
+
+// completes the command name, and exits, or returns the command named by
+// `argv[1]` with `argv[0]` and `argv[1]` swapped. exits if there is no such
+// command
+auto complete_command(
+    argparse_command const* commands,
+    std::uint32_t const* slots,
+    std::size_t n_slots,
+    std::size_t n_commands,
+    int argc,
+    char** argv) -> argparse_command const*;
 } // namespace _argparse
 enum argparse_option_flags {
-  OPT_NONEG = 1, /* disable negation */
+  OPT_NONEG = 1,      /* disable negation */
+  OPT_HELP = 1 << 1, /* print usage and exit, without going through callback */
+  /* deferred callback may run concurrently, see argparse_deferred.hpp. as
+   * any deferred callback, it is given a nullptr parser */
+  OPT_INDEPENDENT = 1 << 2,
+  /* set once per occurrence by the modules replaying the command line, e.g.
+   * argparse_incremental.hpp, instead of once with the last one. set by
+   * `counter` */
+  OPT_REPEATED = 1 << 3,
 };
 
 enum argparse_flag {
   ARGPARSE_STOP_AT_NON_OPTION = 1,
+  ARGPARSE_KEEP_UNKNOWN = 1 << 1, /* pass unknown options through, in order */
+  ARGPARSE_COMPLETE = 1 << 2, /* answer `__complete` and `__completion` */
 };
 
 /**
@@ -263,8 +440,33 @@ enum argparse_flag {
  *
  *  `flags`:
  *    option flags.
+ *
+ *  `parse`:
+ *    parse function of options with a user-defined type, nullptr otherwise.
+ *
+ *  `placeholder`:
+ *    value placeholder of options with a user-defined type.
+ *
+ *  `format`:
+ *    format function of options with a user-defined type, nullptr if none or
+ *    for built-in types.
+ *
+ *  `parse_view`:
+ *    parse function of sized arguments, of options with a user-defined type,
+ *    nullptr if none or for built-in types.
  */
 
+/**
+ *  option tables without callbacks can be constant-initialized, e.g.
+ *
+ *    ARGPARSE_CONSTINIT static veg::argparse_option const options[] = {
+ *        veg::help,
+ *        {&force, 'f', "force", "force to do"},
+ *    };
+ *
+ *  callbacks are stored in a `function_ref`, which is not guaranteed to be
+ *  usable in constant expressions.
+ */
 struct argparse_option : _argparse::layout {
 
   constexpr argparse_option /* NOLINT(hicpp-explicit-conversions) */ (
@@ -285,8 +487,7 @@ struct argparse_option : _argparse::layout {
       char const* help = "",
       argparse_callback callback = {}) noexcept
       : argparse_option{{
-            _argparse::to_option_type<
-                typename std::remove_pointer<T>::type>::value,
+            decltype(_argparse::option_type_of(value_ptr))::value,
             '\0',
             long_name,
             value_ptr,
@@ -303,8 +504,7 @@ struct argparse_option : _argparse::layout {
       char const* help = "",
       argparse_callback callback = {}) noexcept
       : argparse_option{{
-            _argparse::to_option_type<
-                typename std::remove_pointer<T>::type>::value,
+            decltype(_argparse::option_type_of(value_ptr))::value,
             short_name,
             long_name,
             value_ptr,
@@ -313,11 +513,692 @@ struct argparse_option : _argparse::layout {
             0,
         }} {}
 
+  template <typename T, _argparse::has_option_traits<T>* = nullptr>
+  constexpr argparse_option(
+      T* value_ptr,
+      char const* long_name,
+      char const* help = "",
+      argparse_callback callback = {}) noexcept
+      : argparse_option{{
+            _argparse::argparse_option_type::ARGPARSE_OPT_CUSTOM,
+            '\0',
+            long_name,
+            value_ptr,
+            help,
+            callback,
+            0,
+            &_argparse::parse_custom<T>,
+            option_traits<T>::placeholder,
+            _argparse::format_of<T>(nullptr),
+            _argparse::parse_view_of<T>(nullptr),
+        }} {}
+
+  template <typename T, _argparse::has_option_traits<T>* = nullptr>
+  constexpr argparse_option(
+      T* value_ptr,
+      char short_name,
+      char const* long_name = nullptr,
+      char const* help = "",
+      argparse_callback callback = {}) noexcept
+      : argparse_option{{
+            _argparse::argparse_option_type::ARGPARSE_OPT_CUSTOM,
+            short_name,
+            long_name,
+            value_ptr,
+            help,
+            callback,
+            0,
+            &_argparse::parse_custom<T>,
+            option_traits<T>::placeholder,
+            _argparse::format_of<T>(nullptr),
+            _argparse::parse_view_of<T>(nullptr),
+        }} {}
+
   explicit constexpr argparse_option(layout l) noexcept : layout{l} {}
 };
 
+/**
+ * returns `option` with the option flags `flags` added, e.g.
+ *
+ *   veg::with_flags({&cert, "cert", "", load_cert}, veg::OPT_INDEPENDENT)
+ */
+constexpr auto with_flags(argparse_option option, int flags) noexcept
+    -> argparse_option {
+  option.flags |= flags;
+  return option;
+}
+
+namespace _argparse {
+// integer type of the words of bit options, `Word`, or `T` for atomics of `T`.
+// declarations only, used in unevaluated contexts
+template <typename Word>
+auto word_type_of(Word* word, int) -> decltype(word->load());
+template <typename Word>
+auto word_type_of(Word* word, ...) -> Word;
+
+template <typename Word>
+using word_type = decltype(word_type_of(static_cast<Word*>(nullptr), 0));
+
+template <typename Word, std::uint64_t mask>
+auto parse_bit(void* value, char const* arg) -> char const* {
+  using T = word_type<Word>;
+  if (value == nullptr) {
+    return nullptr;
+  }
+  auto& word = *static_cast<Word*>(value);
+  if (arg[0] != '0') {
+    word |= static_cast<T>(mask);
+  } else {
+    word &= static_cast<T>(~mask);
+  }
+  return nullptr;
+}
+
+template <typename Word, std::uint64_t mask>
+auto format_bit(void const* value, char* buf, std::size_t size)
+    -> std::size_t {
+  auto const& word = *static_cast<Word const*>(value);
+  bool set = (word & mask) != 0;
+  return format_builtin(to_option_type<bool>::value, &set, buf, size);
+}
+
+template <typename Count>
+auto parse_counter(void* value, char const* arg) -> char const* {
+  if (value == nullptr) {
+    return nullptr;
+  }
+  auto& count = *static_cast<Count*>(value);
+  if (arg[0] != '0') {
+    ++count;
+  } else {
+    count = 0;
+  }
+  return nullptr;
+}
+
+template <typename Count>
+auto format_counter(void const* value, char* buf, std::size_t size)
+    -> std::size_t {
+  auto count = static_cast<long long>(*static_cast<Count const*>(value));
+  return format_builtin(to_option_type<long long>::value, &count, buf, size);
+}
+
+// flag option of a user-defined type, parsed with `parse`
+constexpr auto make_flag(
+    void* value,
+    char short_name,
+    char const* long_name,
+    char const* help,
+    argparse_callback callback,
+    argparse_parse_fn parse,
+    argparse_format_fn format,
+    int flags = 0) noexcept -> argparse_option {
+  return argparse_option{layout{
+      argparse_option_type::ARGPARSE_OPT_CUSTOM,
+      short_name,
+      long_name,
+      value,
+      help,
+      callback,
+      flags,
+      parse,
+      nullptr,
+      format,
+      nullptr,
+  }};
+}
+} // namespace _argparse
+
+/**
+ * returns a flag setting the bits of `mask` in `*word`, or clearing them when
+ * negated with `--no-`, e.g.
+ *
+ *   static std::uint64_t features;
+ *   static veg::argparse_option const options[] = {
+ *       veg::bit<FEATURE_JIT>(&features, "jit", "enable the jit"),
+ *       veg::bit<FEATURE_GC>(&features, 'g', "gc", "enable the gc"),
+ *   };
+ *
+ * so that many flags are read with a single load. `Word` is an unsigned
+ * integer type holding `mask`, or `std::atomic` of one, updated with atomic
+ * read-modify-write operations then.
+ */
+template <std::uint64_t mask, typename Word>
+constexpr auto bit(
+    Word* word,
+    char const* long_name,
+    char const* help = "",
+    argparse_callback callback = {}) noexcept -> argparse_option {
+  using T = _argparse::word_type<Word>;
+  static_assert(
+      std::uint64_t(T(mask)) == mask && mask != 0,
+      "mask does not fit in a word");
+  return _argparse::make_flag(
+      word,
+      '\0',
+      long_name,
+      help,
+      callback,
+      &_argparse::parse_bit<Word, mask>,
+      &_argparse::format_bit<Word, mask>);
+}
+
+template <std::uint64_t mask, typename Word>
+constexpr auto bit(
+    Word* word,
+    char short_name,
+    char const* long_name = nullptr,
+    char const* help = "",
+    argparse_callback callback = {}) noexcept -> argparse_option {
+  using T = _argparse::word_type<Word>;
+  static_assert(
+      std::uint64_t(T(mask)) == mask && mask != 0,
+      "mask does not fit in a word");
+  return _argparse::make_flag(
+      word,
+      short_name,
+      long_name,
+      help,
+      callback,
+      &_argparse::parse_bit<Word, mask>,
+      &_argparse::format_bit<Word, mask>);
+}
+
+/**
+ * returns a flag incrementing `*count` each time it is given, e.g. `-vvv`
+ * counts 3, and resetting it to 0 when negated with `--no-`. `Count` is an
+ * integer type, or `std::atomic` of one. the flag has OPT_REPEATED, so that
+ * `-vvv -v` counts 4 wherever the command line is replayed.
+ */
+template <typename Count>
+constexpr auto counter(
+    Count* count,
+    char const* long_name,
+    char const* help = "",
+    argparse_callback callback = {}) noexcept -> argparse_option {
+  return _argparse::make_flag(
+      count,
+      '\0',
+      long_name,
+      help,
+      callback,
+      &_argparse::parse_counter<Count>,
+      &_argparse::format_counter<Count>,
+      OPT_REPEATED);
+}
+
+template <typename Count>
+constexpr auto counter(
+    Count* count,
+    char short_name,
+    char const* long_name = nullptr,
+    char const* help = "",
+    argparse_callback callback = {}) noexcept -> argparse_option {
+  return _argparse::make_flag(
+      count,
+      short_name,
+      long_name,
+      help,
+      callback,
+      &_argparse::parse_counter<Count>,
+      &_argparse::format_counter<Count>,
+      OPT_REPEATED);
+}
+
+/**
+ *  argparse index entry
+ *
+ *  hot fields of a single option, packed so that option matching only walks
+ *  a dense array. the remaining (cold) fields stay in the option table, at the
+ *  same position.
+ *
+ *  `hash`:
+ *    FNV-1a hash of the long name, 0 if none.
+ *
+ *  `name_offset`:
+ *    offset of the long name in the index string pool.
+ *
+ *  `name_len`:
+ *    length of the long name, 0 if none.
+ *
+ *  `short_name`:
+ *    same as `argparse_option::short_name`.
+ *
+ *  `type`:
+ *    same as `argparse_option::type`.
+ */
+struct argparse_index_entry {
+  std::uint32_t hash;
+  std::uint32_t name_offset;
+  std::uint16_t name_len;
+  char short_name;
+  _argparse::argparse_option_type type;
+};
+
+struct argparse_index_constraint;
+struct argparse_dfa;
+
+/**
+ *  argparse index
+ *
+ *  compiled representation of an option table, built once with
+ *  `argparse_index_build` into caller-provided storage.
+ *  an empty index is constant-initialized, so a namespace scope index and its
+ *  storage can be declared `ARGPARSE_CONSTINIT` and built on first use.
+ *
+ *  `options`:
+ *    the original option table, used as the cold array.
+ *
+ *  `entries`:
+ *    hot array, `entries[i]` describes `options[i]`.
+ *
+ *  `slots`:
+ *    open addressing table over long name hashes, holds entry index + 1, or 0
+ *    if the slot is empty.
+ *
+ *  `short_slots`:
+ *    entry index + 1 of each short name, or 0 if none.
+ *
+ *  `pool`:
+ *    long names, stored contiguously without null terminators.
+ *
+ *  `constraints`, `constraint_bits`, `constrained`:
+ *    compiled constraints, see `argparse_index_constrain`. the bit + 1 of
+ *    each option in the masks of the constraints, 0 if none, and the option
+ *    of each bit.
+ *
+ *  `patterns`:
+ *    compiled pattern of each option, nullptr if none, see
+ *    `argparse_index_match` in argparse_pattern.hpp.
+ */
+struct argparse_index {
+  argparse_option const* options = nullptr;
+  std::size_t len = 0;
+  argparse_index_entry const* entries = nullptr;
+  std::uint32_t const* slots = nullptr;
+  std::uint32_t slots_mask = 0;
+  std::uint32_t const* short_slots = nullptr;
+  char const* pool = nullptr;
+  argparse_index_constraint const* constraints = nullptr;
+  std::size_t n_constraints = 0;
+  std::uint8_t const* constraint_bits = nullptr;
+  std::uint32_t const* constrained = nullptr;
+  argparse_dfa const* const* patterns = nullptr;
+};
+
+/**
+ * returns the number of bytes of storage required to build an index over the
+ * given options.
+ */
+auto argparse_index_storage_size(
+    argparse_option const* options, std::size_t n_options) noexcept
+    -> std::size_t;
+
+/**
+ * builds an index over the given options into `storage`, which must be
+ * suitably aligned for `std::uint32_t` and at least
+ * `argparse_index_storage_size(options, n_options)` bytes long.
+ * the option table and the storage must outlive the index.
+ *
+ * if two options share a name, the first one wins, as with the linear lookup.
+ * returns false if the storage is too small, or a long name is longer than
+ * 65535 characters.
+ */
+auto argparse_index_build(
+    argparse_index* index,
+    argparse_option const* options,
+    std::size_t n_options,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool;
+
+/**
+ * same as above, with the storage obtained from `resource`, typically a
+ * `std::pmr::memory_resource`. the storage starts at `index->entries` and can
+ * be returned with
+ *
+ *    resource->deallocate(
+ *        const_cast<argparse_index_entry*>(index->entries),
+ *        size,
+ *        alignof(std::uint32_t));
+ *
+ * where `size` is `argparse_index_storage_size(options, n_options)`.
+ */
+template <typename MemoryResource>
+auto argparse_index_build(
+    argparse_index* index,
+    argparse_option const* options,
+    std::size_t n_options,
+    MemoryResource* resource) -> bool {
+  std::size_t size = argparse_index_storage_size(options, n_options);
+  void* storage = resource->allocate(size, alignof(std::uint32_t));
+  if (!argparse_index_build(index, options, n_options, storage, size)) {
+    resource->deallocate(storage, size, alignof(std::uint32_t));
+    return false;
+  }
+  return true;
+}
+
+enum argparse_constraint_kind : unsigned char {
+  ARGPARSE_REQUIRED, /* every option is given */
+  ARGPARSE_AT_MOST_ONE, /* at most one of the options is given */
+  ARGPARSE_ALL_OR_NONE, /* every option or none of them is given */
+  ARGPARSE_IMPLIES, /* the first option requires all the others */
+};
+
+/**
+ *  argparse constraint
+ *
+ *  rule over options named by their long name, e.g.
+ *
+ *    static constexpr veg::argparse_constraint constraints[] = {
+ *        veg::required("input"),
+ *        veg::at_most_one("json", "yaml"),
+ *        veg::implies("user", "password"),
+ *    };
+ *
+ *  an option is given if it appears on the command line, and its last
+ *  occurrence is not negated: `--json --no-yaml` only gives `--json`.
+ */
+struct argparse_constraint {
+  static constexpr std::size_t max_names = 8;
+
+  argparse_constraint_kind kind;
+  std::size_t n_names;
+  char const* names[max_names];
+};
+
+namespace _argparse {
+template <typename... Names>
+constexpr auto make_constraint(argparse_constraint_kind kind, Names... names)
+    -> argparse_constraint {
+  static_assert(
+      sizeof...(Names) <= argparse_constraint::max_names,
+      "too many options in a single constraint");
+  return {kind, sizeof...(Names), {names...}};
+}
+} // namespace _argparse
+
+template <typename... Names>
+constexpr auto required(Names... names) -> argparse_constraint {
+  return _argparse::make_constraint(ARGPARSE_REQUIRED, names...);
+}
+template <typename... Names>
+constexpr auto at_most_one(Names... names) -> argparse_constraint {
+  return _argparse::make_constraint(ARGPARSE_AT_MOST_ONE, names...);
+}
+template <typename... Names>
+constexpr auto all_or_none(Names... names) -> argparse_constraint {
+  return _argparse::make_constraint(ARGPARSE_ALL_OR_NONE, names...);
+}
+template <typename... Names>
+constexpr auto implies(char const* name, Names... implied)
+    -> argparse_constraint {
+  return _argparse::make_constraint(ARGPARSE_IMPLIES, name, implied...);
+}
+
+/**
+ *  argparse index constraint
+ *
+ *  a constraint compiled to masks over the bits of the constrained options,
+ *  checked in a few word operations once the arguments are parsed.
+ *
+ *  `mask`:
+ *    constrained options, the first one only for ARGPARSE_IMPLIES.
+ *
+ *  `implied`:
+ *    options implied by the first one, for ARGPARSE_IMPLIES.
+ */
+struct argparse_index_constraint {
+  std::uint64_t mask;
+  std::uint64_t implied;
+  argparse_constraint_kind kind;
+};
+
+/**
+ * returns the number of bytes of storage required to compile `n_constraints`
+ * constraints over `n_options` options.
+ */
+auto argparse_constraints_storage_size(
+    std::size_t n_options, std::size_t n_constraints) noexcept -> std::size_t;
+
+/**
+ * compiles `constraints` into `storage`, which must be suitably aligned for
+ * `std::uint64_t` and at least `argparse_constraints_storage_size` bytes long,
+ * and attaches them to `index`, to be checked by `parse_args`, `parse_span`
+ * and `argparse_incremental_error` after the arguments are parsed. a
+ * violation is reported as an error.
+ * up to 64 distinct options can be constrained, as the options given are
+ * tracked in a single word.
+ * returns false if the storage is too small, or prints an error and returns
+ * false if an option is unknown or there are too many.
+ */
+auto argparse_index_constrain(
+    argparse_index* index,
+    argparse_constraint const* constraints,
+    std::size_t n_constraints,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool;
+
+/**
+ * returns `given`, the bits of the constrained options of `index` given so
+ * far, updated with an occurrence of `option`, one of its options.
+ */
+inline auto argparse_index_give(
+    argparse_index const* index,
+    argparse_option const* option,
+    bool negated,
+    std::uint64_t given) noexcept -> std::uint64_t {
+  if (index == nullptr || index->constraint_bits == nullptr) {
+    return given;
+  }
+  std::uint8_t bit = index->constraint_bits[option - index->options];
+  if (bit == 0) {
+    return given;
+  }
+  std::uint64_t mask = std::uint64_t(1) << (bit - 1);
+  return negated ? given & ~mask : given | mask;
+}
+
+/**
+ *  argparse violation
+ *
+ *  first constraint of an index violated by the options given.
+ *
+ *  `reason`:
+ *    description of the violation, nullptr if none.
+ *
+ *  `option`:
+ *    option missing, or the first of the exclusive options given.
+ *
+ *  `other`:
+ *    option requiring `option`, or the second of the exclusive options
+ *    given, nullptr for ARGPARSE_REQUIRED.
+ */
+struct argparse_violation {
+  char const* reason;
+  argparse_constraint_kind kind;
+  argparse_option const* option;
+  argparse_option const* other;
+};
+
+/**
+ * returns the first constraint of `index`, if any, violated by the options
+ * of `given`, as built by `argparse_index_give`.
+ */
+auto argparse_index_violation(
+    argparse_index const* index, std::uint64_t given) noexcept
+    -> argparse_violation;
+
+/**
+ *  argparse table
+ *
+ *  named option table, merged with others by `argparse_tables_build`.
+ */
+struct argparse_table {
+  char const* name;
+  argparse_option const* options;
+  std::size_t n_options;
+
+  constexpr argparse_table(
+      char const* table_name,
+      argparse_option const* table_options,
+      std::size_t n) noexcept
+      : name{table_name}, options{table_options}, n_options{n} {}
+
+  template <std::size_t n>
+  constexpr argparse_table(
+      char const* table_name,
+      argparse_option const (&table_options)[n]) noexcept
+      : argparse_table{table_name, table_options, n} {}
+};
+
+/**
+ * returns the number of bytes of storage required to merge `tables` with
+ * `argparse_tables_build`.
+ */
+auto argparse_tables_storage_size(
+    argparse_table const* tables, std::size_t n_tables) noexcept
+    -> std::size_t;
+
+/**
+ * merges `tables`, in order, into a single table in `storage`, and builds
+ * `index` over it, so that a single pass over the arguments dispatches each
+ * of them to the table that owns it, e.g. with layered libraries
+ *
+ *    veg::argparse_table const tables[] = {
+ *        {"app", app_options},
+ *        {"net", net::options},
+ *        {"log", log::options},
+ *    };
+ *    veg::argparse_index index;
+ *    veg::argparse_tables_build(&index, tables, 3, storage, size);
+ *    veg::parse_known_args(&argc, argv, index, usages);
+ *
+ * `storage` must be suitably aligned for `argparse_option` and at least
+ * `argparse_tables_storage_size(tables, n_tables)` bytes long. the tables and
+ * the storage must outlive the index.
+ * returns false if the storage is too small, or if two options share a name,
+ * in which case each conflict is reported on stderr.
+ */
+auto argparse_tables_build(
+    argparse_index* index,
+    argparse_table const* tables,
+    std::size_t n_tables,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool;
+
+/**
+ *  argparse module
+ *
+ *  option table declared next to the code that uses it, and registered
+ *  before `main` with `ARGPARSE_MODULE`, e.g.
+ *
+ *    static long cache_size = 64;
+ *    static veg::argparse_option const cache_options[] = {
+ *        "Cache options",
+ *        {&cache_size, "cache-size", "cache size in MiB"},
+ *    };
+ *    ARGPARSE_MODULE(cache, cache_options);
+ *
+ *  registration does not run any code where the linker collects the modules
+ *  in a section, with GCC and Clang on ELF platforms: each module is a
+ *  constant-initialized table, pointed to from the `argparse_modules`
+ *  section.
+ *  elsewhere, the module links itself into a list from a dynamic
+ *  initializer. the tables of all modules are merged once by
+ *  `argparse_registry_build`.
+ *  a module in a static library is only registered if its object file is
+ *  linked in, e.g. with an object library or `--whole-archive`. with the
+ *  section, only the modules of the executable or shared library that links
+ *  the argparse library are registered.
+ */
+#if defined(__ELF__) && defined(__GNUC__)
+#define ARGPARSE_MODULE_SECTION 1
+
+// the section holds pointers, as the compiler may pad larger objects
+#define ARGPARSE_MODULE(name, options)                                         \
+  static constexpr ::veg::argparse_table argparse_module_##name{               \
+      #name, options};                                                         \
+  __attribute__((used, section("argparse_modules"))) static constexpr         \
+      ::veg::argparse_table const* argparse_module_entry_##name =              \
+          &argparse_module_##name
+#else
+#define ARGPARSE_MODULE_SECTION 0
+
+struct argparse_module;
+
+namespace _argparse {
+// pushes `module` on the list of registered modules, returns the previous head
+auto register_module(argparse_module* module) noexcept -> argparse_module*;
+} // namespace _argparse
+
+struct argparse_module {
+  argparse_table table;
+  argparse_module* next;
+
+  template <std::size_t n>
+  argparse_module(
+      char const* module_name,
+      argparse_option const (&module_options)[n]) noexcept
+      : table{module_name, module_options},
+        next{_argparse::register_module(this)} {}
+};
+
+#define ARGPARSE_MODULE(name, options)                                         \
+  static ::veg::argparse_module argparse_module_##name{#name, options}
+#endif
+
+/**
+ * returns the number of bytes of storage required to merge the registered
+ * modules with `argparse_registry_build`.
+ */
+auto argparse_registry_storage_size() noexcept -> std::size_t;
+
+/**
+ * merges the option tables of the registered modules, sorted by module name,
+ * into a single table in `storage`, and builds `index` over it.
+ * `storage` must be suitably aligned for `argparse_option` and at least
+ * `argparse_registry_storage_size()` bytes long. parse with
+ * `parse_args(&argc, argv, index, usages)`, so that lookups cost the same
+ * regardless of the number of modules.
+ *
+ * modules registered after the build, e.g. by a shared library loaded later,
+ * are ignored until the next build.
+ * returns false if the storage is too small, or if two options share a name,
+ * in which case each conflict is reported on stderr.
+ */
+auto argparse_registry_build(
+    argparse_index* index, void* storage, std::size_t storage_size) noexcept
+    -> bool;
+
+/**
+ * same as above, with the storage obtained from `resource`, which it is
+ * returned to if the build fails.
+ */
+template <typename MemoryResource>
+auto argparse_registry_build(argparse_index* index, MemoryResource* resource)
+    -> bool {
+  std::size_t size = argparse_registry_storage_size();
+  void* storage = resource->allocate(size, alignof(argparse_option));
+  if (!argparse_registry_build(index, storage, size)) {
+    resource->deallocate(storage, size, alignof(argparse_option));
+    return false;
+  }
+  return true;
+}
+
 /**
  * argpparse
+ *
+ * allocation:
+ *   parsing never allocates. all the state lives in this struct, on the stack
+ *   of `parse_args`, and arguments are rearranged in place in `argv`.
+ *   any additional storage, such as the one of an `argparse_index`, is
+ *   provided by the caller, either as a buffer or as a memory resource.
+ *   the only exception is the C stdio buffer of `stdout`/`stderr`, which may
+ *   be allocated on first use when printing usage or errors, right before the
+ *   process exits.
+ *   new entry points are expected to keep this contract.
  */
 
 struct argparse {
@@ -333,6 +1214,9 @@ struct argparse {
   char** out;
   int cpidx;
   char const* optvalue; // current option value
+  argparse_index const* const index; // nullptr for linear lookup
+  argparse_deferred* const deferred; // nullptr to run callbacks inline
+  std::uint64_t seen; // constrained options given, see `argparse_index`
 };
 
 inline void parse_args(
@@ -357,7 +1241,10 @@ inline void parse_args(
       epilogue,
       nullptr,
       0,
-      nullptr};
+      nullptr,
+      nullptr,
+      nullptr,
+      0};
   *argc = _argparse::argparse_parse(&ap, *argc, argv);
 }
 
@@ -382,19 +1269,420 @@ void parse_args(
       flags);
 }
 
+inline void parse_args(
+    int* argc,
+    char** argv,
+    argparse_index const& index,
+    char const* const* usages,
+    std::size_t n_usages,
+    char const* description = "",
+    char const* epilogue = "",
+    int flags = 0) noexcept {
+  argparse ap = {
+      *argc,
+      argv,
+      index.options,
+      index.len,
+      usages,
+      n_usages,
+      flags,
+      description,
+      epilogue,
+      nullptr,
+      0,
+      nullptr,
+      &index,
+      nullptr,
+      0};
+  *argc = _argparse::argparse_parse(&ap, *argc, argv);
+}
+
+template <std::size_t n_usages>
+void parse_args(
+    int* argc,
+    char** argv,
+    argparse_index const& index,
+    char const* const (&usages)[n_usages],
+    char const* description = "",
+    char const* epilogue = "",
+    int flags = 0) noexcept {
+  parse_args(
+      argc, argv, index, usages, n_usages, description, epilogue, flags);
+}
+
+/**
+ * same as `parse_args` with `ARGPARSE_KEEP_UNKNOWN`: unknown options are left
+ * in `argv`, in order with the non-option arguments, for the next consumer.
+ * a short option cluster with an unknown letter is passed through whole and
+ * unchanged, e.g. `-vxf` for an unknown `x`. the known letters before the
+ * unknown one, `v`, are applied nonetheless, and so seen again by the next
+ * consumer, those after it, `f`, are not. the argument strings are never
+ * written.
+ */
+template <std::size_t n_usages>
+void parse_known_args(
+    int* argc,
+    char** argv,
+    argparse_index const& index,
+    char const* const (&usages)[n_usages],
+    char const* description = "",
+    char const* epilogue = "",
+    int flags = 0) noexcept {
+  parse_args(
+      argc,
+      argv,
+      index,
+      usages,
+      n_usages,
+      description,
+      epilogue,
+      flags | ARGPARSE_KEEP_UNKNOWN);
+}
+
+template <std::size_t n_options, std::size_t n_usages>
+void parse_known_args(
+    int* argc,
+    char** argv,
+    argparse_option const (&options)[n_options],
+    char const* const (&usages)[n_usages],
+    char const* description = "",
+    char const* epilogue = "",
+    int flags = 0) noexcept {
+  parse_args(
+      argc,
+      argv,
+      options,
+      n_options,
+      usages,
+      n_usages,
+      description,
+      epilogue,
+      flags | ARGPARSE_KEEP_UNKNOWN);
+}
+
+/**
+ *  argparse command
+ *
+ *  subcommand of a git-style tool.
+ *
+ *  `name`:
+ *    name of the command on the command line.
+ *
+ *  `run`:
+ *    called with the arguments following the command, `argv[0]` being the
+ *    command name. it declares and parses the options of the command, so that
+ *    only the invoked command pays for its option table, and may dispatch to
+ *    nested commands. its result is returned by `run_command`.
+ *
+ *  `help`:
+ *    the short help message associated to the command.
+ */
+using argparse_command_fn = auto (*)(int argc, char** argv) -> int;
+
+struct argparse_command {
+  char const* name = nullptr;
+  argparse_command_fn run = nullptr;
+  char const* help = "";
+};
+
+namespace _argparse {
+constexpr auto command_slots(std::size_t n_commands) -> std::size_t {
+  std::size_t n_slots = 8;
+  while (n_slots < 2 * n_commands) {
+    n_slots *= 2;
+  }
+  return n_slots;
+}
+} // namespace _argparse
+
+/**
+ *  argparse commands
+ *
+ *  set of commands with a hash table over their names, built at compile
+ *  time, e.g.
+ *
+ *    constexpr veg::argparse_command commands_[] = {
+ *        {"commit", cmd_commit, "record changes"},
+ *        {"push", cmd_push, "update remote refs"},
+ *    };
+ *    ARGPARSE_CONSTINIT static auto const commands =
+ *        veg::argparse_commands<2>{commands_};
+ *
+ *    auto main(int argc, char** argv) -> int {
+ *      veg::parse_args(
+ *          &argc, argv, options, usages, "", "",
+ *          veg::ARGPARSE_STOP_AT_NON_OPTION);
+ *      return veg::run_command(commands, argc, argv);
+ *    }
+ *
+ *  `slots`:
+ *    open addressing table over name hashes, holds command index + 1, or 0 if
+ *    the slot is empty. if two commands share a name, the first one wins.
+ */
+template <std::size_t n_commands>
+struct argparse_commands {
+  static constexpr std::size_t n_slots = _argparse::command_slots(n_commands);
+
+  argparse_command commands[n_commands];
+  std::uint32_t slots[n_slots];
+
+  constexpr explicit argparse_commands(
+      argparse_command const (&cmds)[n_commands]) noexcept
+      : commands{}, slots{} {
+    for (std::size_t i = 0; i < n_commands; ++i) {
+      commands[i] = cmds[i];
+      std::size_t len = 0;
+      while (cmds[i].name[len] != '\0') {
+        ++len;
+      }
+      std::size_t pos = _argparse::hash_name(cmds[i].name, len) & (n_slots - 1);
+      while (slots[pos] != 0) {
+        pos = (pos + 1) & (n_slots - 1);
+      }
+      slots[pos] = static_cast<std::uint32_t>(i + 1);
+    }
+  }
+};
+
+/**
+ * returns the command named `name`, nullptr if none.
+ */
+auto argparse_find_command(
+    argparse_command const* commands,
+    std::uint32_t const* slots,
+    std::size_t n_slots,
+    char const* name) noexcept -> argparse_command const*;
+
+/**
+ * prints the list of commands, as part of the usage.
+ */
+void argparse_commands_usage(
+    argparse_command const* commands, std::size_t n_commands);
+
+/**
+ * prints the commands whose name starts with `prefix`, for `__complete`.
+ */
+void argparse_complete_commands(
+    argparse_command const* commands,
+    std::size_t n_commands,
+    char const* prefix);
+
+/**
+ * runs the command named `argv[0]` with `argc` and `argv`, and returns its
+ * result. if `argc` is 0 or the command is unknown, prints an error and the
+ * list of commands and exits.
+ * while completing, `argv` starts with `__complete`, as handed over by
+ * `parse_args`: the command is given `argv` with both swapped, so that its
+ * own parser, with ARGPARSE_COMPLETE, keeps completing.
+ */
+template <std::size_t n_commands>
+auto run_command(
+    argparse_commands<n_commands> const& commands, int argc, char** argv)
+    -> int {
+  if (_argparse::completing_command(argc, argv)) {
+    return _argparse::complete_command(
+               commands.commands,
+               commands.slots,
+               commands.n_slots,
+               n_commands,
+               argc,
+               argv)
+        ->run(argc, argv);
+  }
+  argparse_command const* command =
+      argc == 0 ? nullptr
+                : argparse_find_command(
+                      commands.commands,
+                      commands.slots,
+                      commands.n_slots,
+                      argv[0]);
+  if (command == nullptr) {
+    _argparse::unknown_command(
+        commands.commands, n_commands, argc == 0 ? nullptr : argv[0]);
+  }
+  return command->run(argc, argv);
+}
+
 // built-in callbacks
 auto argparse_help_cb(argparse* self, argparse_option const* option) -> int;
 
-static const argparse_option help = argparse_option{
+ARGPARSE_INLINE_VAR constexpr argparse_option help = argparse_option{
     {_argparse::argparse_option_type::ARGPARSE_OPT_BOOLEAN,
      'h',
      "help",
      nullptr,
      "show this help message and exit",
-     argparse_help_cb,
-     OPT_NONEG}};
+     {},
+     OPT_NONEG | OPT_HELP}};
 
 void argparse_usage(argparse const* self);
+
+/**
+ *  shell completion
+ *
+ *  with ARGPARSE_COMPLETE, `<program> __complete <words...>` answers the
+ *  completion of the last word, given the preceding words of the command
+ *  line, and exits without parsing. one candidate is printed per line,
+ *  followed by a tab and its help:
+ *    - long options, and the `--no-` form of negatable ones, for `--<prefix>`.
+ *    - short and long options for `-`.
+ *    - the choices of a `{a|b|c}` placeholder, for `--<name>=<prefix>` or
+ *      the word following the option.
+ *    - commands, for a non-option word handed to `run_command`.
+ *  options are matched on the index entries when there is an index, and the
+ *  help is never rendered.
+ *  parsers using ARGPARSE_STOP_AT_NON_OPTION hand the words following the
+ *  first non-option word over to the caller, expected to be `run_command`,
+ *  behind `__complete`. commands complete their own options if their parser
+ *  uses ARGPARSE_COMPLETE as well. without the flag, both words are parsed
+ *  as any other argument.
+ *
+ *  `<program> __completion <shell>` prints the script calling `__complete`
+ *  for bash, zsh or fish, e.g. `source <(tool __completion bash)`.
+ */
+
+/**
+ * prints the completion script of `program` for `shell`, one of "bash",
+ * "zsh" or "fish". returns false if the shell is not supported.
+ */
+auto argparse_completion_script(char const* shell, char const* program)
+    -> bool;
+
+/**
+ * returns the value placeholder of `option`, e.g. "<int>", or nullptr if the
+ * option is a flag.
+ */
+auto argparse_placeholder(argparse_option const* option) -> char const*;
+
+/**
+ * writes the current value of `option` into `buf`, with the same contract as
+ * `argparse_format_fn`. values of user-defined types without `format` are
+ * written as "?".
+ */
+auto argparse_format_value(
+    argparse_option const* option, char* buf, std::size_t size) -> std::size_t;
+
+/**
+ * finds the option whose long name is the `len` first characters of `name`,
+ * through `index` if not nullptr, or by walking `options` otherwise.
+ * `no-<name>` resolves to the negatable option `<name>`, in which case
+ * `*negated` is set to true, unless an option is named `no-<name>`: exact
+ * names are matched first, with or without an index.
+ * returns nullptr if no option matches.
+ */
+auto argparse_find_long(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    char const* name,
+    std::size_t len,
+    bool* negated) -> argparse_option const*;
+
+/**
+ * finds the option whose short name is `c`, through `index` if not nullptr,
+ * or by walking `options` otherwise.
+ * returns nullptr if no option matches.
+ */
+auto argparse_find_short(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    char c) -> argparse_option const*;
+
+/**
+ *  kinds of command line arguments
+ *
+ *  every parser splits its arguments through `argparse_arg_kind_of`,
+ *  `argparse_read_long` and `argparse_read_short`, so that they all agree.
+ *  the arguments given to these are `size` bytes long, or end at their first
+ *  null character: null-terminated arguments leave `size` out.
+ */
+enum argparse_arg_kind : unsigned char {
+  ARGPARSE_ARG_POSITIONAL, // not an option, or `-`
+  ARGPARSE_ARG_SEPARATOR, // `--`
+  ARGPARSE_ARG_LONG, // `--name` or `--name=value`
+  ARGPARSE_ARG_SHORT, // cluster of short options, e.g. `-fv` or `-n3`
+};
+
+/**
+ *  option read from an option argument by `argparse_read_long` or
+ *  `argparse_read_short`
+ *
+ *  `option`:
+ *    matched option, nullptr if unknown.
+ *
+ *  `value`:
+ *    value of the option as accepted by `argparse_set_value`, "1" or "0" for
+ *    flags, or nullptr if the value is the next argument.
+ *
+ *  `next`:
+ *    next option of the short option cluster, or nullptr.
+ *
+ *  `error`:
+ *    "unknown option", "takes no value" for a flag given a value, or nullptr.
+ *
+ *  `negated`:
+ *    whether the option is named as `no-<name>`.
+ */
+struct argparse_read {
+  argparse_option const* option;
+  char const* value;
+  char const* next;
+  char const* error;
+  bool negated;
+};
+
+/**
+ * returns the kind of the argument `arg`.
+ */
+auto argparse_arg_kind_of(char const* arg, std::size_t size = std::size_t(-1))
+    -> argparse_arg_kind;
+
+/**
+ * reads the long option `name`, `name=value` or `no-name`, following the
+ * `--` of its argument.
+ */
+auto argparse_read_long(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    char const* name,
+    std::size_t size = std::size_t(-1)) -> argparse_read;
+
+/**
+ * reads the short option at `c`, in a cluster following the `-` of its
+ * argument. an unknown option ends the cluster, the rest of which is
+ * unknown as a whole.
+ */
+auto argparse_read_short(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    char const* c,
+    std::size_t size = std::size_t(-1)) -> argparse_read;
+
+/**
+ * parses `arg` into the target of `option`, through the same conversion as
+ * `parse_args`. flags expect "1" to be set, or "0" to be unset.
+ * if `index` is not nullptr, `option` must be one of its options, and `arg`
+ * is checked against the pattern attached to it, if any, beforehand.
+ * returns nullptr on success, or the reason of the failure.
+ */
+auto argparse_set_value(
+    argparse_option const* option,
+    char const* arg,
+    argparse_index const* index = nullptr) -> char const*;
+
+/**
+ * returns what `argparse_set_value` would return for `arg`, without setting
+ * the target of `option`, nor keeping a pointer to `arg`. values of
+ * user-defined types are parsed into a scratch object, and accepted without
+ * a check if the type is not default constructible.
+ */
+auto argparse_check_value(
+    argparse_option const* option,
+    char const* arg,
+    argparse_index const* index = nullptr) -> char const*;
 } // namespace veg
 
 #endif /* end of include guard ARGPARSE_CXX_ARGPARSE_HPP_ZI0LXA5GS */
@@ -0,0 +1,293 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_CHOICES_HPP_Q7KD3VX5N
+#define ARGPARSE_CXX_ARGPARSE_CHOICES_HPP_Q7KD3VX5N
+
+#include "argparse.hpp"
+#include <cstdio>
+#include <cstring>
+
+/**
+ *  choice options, mapping a fixed set of names to enum values, e.g.
+ *
+ *    enum struct mode { fast, safe, debug };
+ *    constexpr veg::argparse_choice<mode> mode_names[] = {
+ *        {"fast", mode::fast}, {"safe", mode::safe}, {"debug", mode::debug}};
+ *    constexpr auto modes = veg::make_choices(mode_names);
+ *
+ *    namespace veg {
+ *    template <>
+ *    struct option_traits<mode> : choice_traits<decltype(modes), modes> {};
+ *    } // namespace veg
+ *
+ *  after which `mode` values are options like any other, shown as
+ *  `--mode={fast|safe|debug}` in the usage. invalid values fail with
+ *  "expects one of fast, safe or debug".
+ *
+ *  in a header, the table must be the same object in every translation unit
+ *  instantiating the traits, as it is their template argument: declare it
+ *  `inline constexpr auto modes = ...` with C++17, or keep both the table and
+ *  the specialization in a single source file otherwise.
+ *
+ *  the names are resolved with a perfect hash built at compile time: one hash
+ *  of the argument, one slot, and a single comparison with the only candidate.
+ *  `make_choices(names, true)` folds ASCII case, in both the hash and the
+ *  comparison. duplicate names fail the compilation, as do names for which no
+ *  seed is found.
+ *  choices are parsed in place by `parse_span`.
+ */
+
+namespace veg {
+
+template <typename E>
+struct argparse_choice {
+  char const* name;
+  E value;
+};
+
+namespace _argparse {
+constexpr auto fold_ascii(char c, bool fold) -> char {
+  return fold && c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+}
+
+constexpr auto choice_len(char const* name) -> std::size_t {
+  std::size_t len = 0;
+  while (name[len] != '\0') {
+    ++len;
+  }
+  return len;
+}
+
+// FNV-1a of the `size` bytes at `name`, started from `seed`, with the high
+// bits mixed into the low ones, which select the slot
+constexpr auto choice_hash(
+    char const* name, std::size_t size, std::uint32_t seed, bool fold)
+    -> std::uint32_t {
+  std::uint32_t h = 2166136261U ^ (seed * 0x9E3779B9U);
+  for (std::size_t i = 0; i < size; ++i) {
+    h ^= static_cast<unsigned char>(fold_ascii(name[i], fold));
+    h *= 16777619U;
+  }
+  return h ^ (h >> 16U);
+}
+
+// whether `name` is made of the `size` bytes at `arg`
+constexpr auto same_choice(
+    char const* name, char const* arg, std::size_t size, bool fold) -> bool {
+  for (std::size_t i = 0; i < size; ++i) {
+    if (name[i] == '\0' ||
+        fold_ascii(name[i], fold) != fold_ascii(arg[i], fold)) {
+      return false;
+    }
+  }
+  return name[size] == '\0';
+}
+
+// power of two, large enough for a random seed to be a perfect hash with a
+// good probability
+constexpr auto choice_slots(std::size_t n) -> std::size_t {
+  std::size_t slots = 1;
+  while (slots < 2 * n || slots < n * n / 4) {
+    slots *= 2;
+  }
+  return slots;
+}
+
+// not constexpr: reaching them fails the constant evaluation of
+// `make_choices`, with their name in the diagnostic
+inline void duplicate_choice_names() { std::abort(); }
+inline void no_perfect_hash_found() { std::abort(); }
+} // namespace _argparse
+
+/**
+ *  argparse choices
+ *
+ *  `slots`:
+ *    1 + position in `choices` of the name hashed to each slot, 0 if none.
+ *
+ *  `seed`:
+ *    seed of the hash, found by `make_choices` so that no two names share a
+ *    slot.
+ */
+template <typename E, std::size_t n>
+struct argparse_choices {
+  static_assert(n > 0 && n < 256, "choices are limited to 255 names");
+  using value_type = E;
+  static constexpr std::size_t size = n;
+  static constexpr std::size_t n_slots = _argparse::choice_slots(n);
+
+  argparse_choice<E> choices[n];
+  std::uint8_t slots[n_slots];
+  std::uint32_t seed;
+  bool fold_case;
+
+  /**
+   * returns the choice named by the `len` bytes at `arg`, or nullptr.
+   */
+  constexpr auto find(char const* arg, std::size_t len) const noexcept
+      -> argparse_choice<E> const* {
+    std::uint32_t h = _argparse::choice_hash(arg, len, seed, fold_case);
+    std::size_t i = slots[h & (n_slots - 1)];
+    if (i == 0 ||
+        !_argparse::same_choice(choices[i - 1].name, arg, len, fold_case)) {
+      return nullptr;
+    }
+    return choices + (i - 1);
+  }
+};
+
+/**
+ * builds the perfect hash table of `names`, at compile time when used to
+ * initialize a constexpr variable, trying the seeds below `n_seeds`.
+ */
+template <typename E, std::size_t n>
+constexpr auto make_choices(
+    argparse_choice<E> const (&names)[n],
+    bool fold_case = false,
+    std::uint32_t n_seeds = 1024) -> argparse_choices<E, n> {
+  argparse_choices<E, n> table{};
+  table.fold_case = fold_case;
+  for (std::size_t i = 0; i < n; ++i) {
+    table.choices[i] = names[i];
+    for (std::size_t j = 0; j < i; ++j) {
+      if (_argparse::same_choice(
+              names[j].name,
+              names[i].name,
+              _argparse::choice_len(names[i].name),
+              fold_case)) {
+        _argparse::duplicate_choice_names();
+      }
+    }
+  }
+
+  constexpr std::size_t mask = argparse_choices<E, n>::n_slots - 1;
+  for (std::uint32_t seed = 0; seed < n_seeds; ++seed) {
+    for (auto& slot : table.slots) {
+      slot = 0;
+    }
+    bool perfect = true;
+    for (std::size_t i = 0; perfect && i < n; ++i) {
+      char const* name = names[i].name;
+      std::uint32_t h = _argparse::choice_hash(
+          name, _argparse::choice_len(name), seed, fold_case);
+      perfect = table.slots[h & mask] == 0;
+      table.slots[h & mask] = std::uint8_t(i + 1);
+    }
+    if (perfect) {
+      table.seed = seed;
+      return table;
+    }
+  }
+  _argparse::no_perfect_hash_found();
+  return table;
+}
+
+namespace _argparse {
+template <std::size_t reason_size, std::size_t placeholder_size>
+struct choice_text {
+  char reason[reason_size];
+  char placeholder[placeholder_size];
+};
+
+// copies `str` to `out + pos` if `out` is not nullptr, returns the position
+// following it
+constexpr auto put_text(char* out, std::size_t pos, char const* str)
+    -> std::size_t {
+  for (; *str != '\0'; ++str, ++pos) {
+    if (out != nullptr) {
+      out[pos] = *str;
+    }
+  }
+  return pos;
+}
+
+// writes "expects one of a, b or c", null-terminated, to `out` if not
+// nullptr, and returns its size
+template <typename Choices>
+constexpr auto write_choice_reason(Choices const& table, char* out)
+    -> std::size_t {
+  std::size_t pos = put_text(out, 0, "expects one of ");
+  for (std::size_t i = 0; i < Choices::size; ++i) {
+    bool last = i + 1 == Choices::size;
+    pos = put_text(out, pos, i == 0 ? "" : last ? " or " : ", ");
+    pos = put_text(out, pos, table.choices[i].name);
+  }
+  return pos + 1;
+}
+
+// same for "{a|b|c}"
+template <typename Choices>
+constexpr auto write_choice_placeholder(Choices const& table, char* out)
+    -> std::size_t {
+  std::size_t pos = put_text(out, 0, "{");
+  for (std::size_t i = 0; i < Choices::size; ++i) {
+    pos = put_text(out, pos, i == 0 ? "" : "|");
+    pos = put_text(out, pos, table.choices[i].name);
+  }
+  return put_text(out, pos, "}") + 1;
+}
+
+template <typename Text, typename Choices>
+constexpr auto make_choice_text(Choices const& table) -> Text {
+  Text text{};
+  write_choice_reason(table, text.reason);
+  write_choice_placeholder(table, text.placeholder);
+  return text;
+}
+} // namespace _argparse
+
+/**
+ *  option traits of the values of `table`, see above
+ */
+template <typename Choices, Choices const& table>
+struct choice_traits {
+  using E = typename Choices::value_type;
+
+  using text_type = _argparse::choice_text<
+      _argparse::write_choice_reason(table, nullptr),
+      _argparse::write_choice_placeholder(table, nullptr)>;
+
+  static constexpr text_type text =
+      _argparse::make_choice_text<text_type>(table);
+  static constexpr char const* placeholder = text.placeholder;
+
+  static auto parse_view(E& out, char const* arg, std::size_t size)
+      -> char const* {
+    auto const* choice = table.find(arg, size);
+    if (choice == nullptr) {
+      return text.reason;
+    }
+    out = choice->value;
+    return nullptr;
+  }
+
+  static auto parse(E& out, char const* arg) -> char const* {
+    return parse_view(out, arg, std::strlen(arg));
+  }
+
+  static auto format(E const& value, char* buf, std::size_t size)
+      -> std::size_t {
+    for (auto const& choice : table.choices) {
+      if (choice.value == value) {
+        return std::size_t(std::snprintf(buf, size, "%s", choice.name));
+      }
+    }
+    return std::size_t(std::snprintf(buf, size, "%s", "?"));
+  }
+};
+
+#if __cplusplus < 201703L
+template <typename Choices, Choices const& table>
+constexpr typename choice_traits<Choices, table>::text_type
+    choice_traits<Choices, table>::text;
+#endif
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_CHOICES_HPP_Q7KD3VX5N */
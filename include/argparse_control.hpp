@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_CONTROL_HPP_C5XH0PL3E
+#define ARGPARSE_CXX_ARGPARSE_CONTROL_HPP_C5XH0PL3E
+
+#include "argparse.hpp"
+
+/**
+ *  control endpoint, to query and set options of a live process over a Unix
+ *  domain socket, e.g.
+ *
+ *    $ echo 'set --num=16' | nc -U /run/app.sock
+ *    ok
+ *    $ echo 'get num verbose' | nc -U /run/app.sock
+ *    num=16 control
+ *    verbose=0 default
+ *
+ *  requests are a single line of whitespace separated words:
+ *
+ *    `get [name...]`:
+ *      value and source of the named options, or of every option with a
+ *      value if none is named.
+ *
+ *    `set <args...>`:
+ *      command line options, e.g. `--num=16`, `-n 16` or `--no-verbose`,
+ *      matched and converted as by `parse_args`. every value is checked with
+ *      `argparse_check_value` before any is applied, in order, so that a
+ *      request setting several options applies all of them or none.
+ *      values of string and user-defined options, which may point into their
+ *      argument, are first copied to the slot of the option in the values
+ *      storage. a later `set` of the same option overwrites its slot.
+ *
+ *  the endpoint runs on the thread calling `argparse_control_serve`, and never
+ *  allocates: a request is read into a fixed buffer of `request_size` bytes,
+ *  and the response is sent in chunks of `response_size` bytes.
+ *  options set at runtime while other threads read them must have
+ *  `std::atomic` targets, see argparse_std.hpp.
+ *
+ *  POSIX only.
+ */
+
+namespace veg {
+
+enum argparse_source : unsigned char {
+  ARGPARSE_SOURCE_DEFAULT,
+  ARGPARSE_SOURCE_COMMAND_LINE,
+  ARGPARSE_SOURCE_CONTROL,
+};
+
+/**
+ *  argparse control
+ *
+ *  `sources`:
+ *    where the current value of each option comes from, caller-provided,
+ *    one entry per option.
+ *
+ *  `values`:
+ *    values storage, caller-provided, split into one slot of `value_size`
+ *    bytes per option. string and user-defined options whose value, with its
+ *    null terminator, does not fit in their slot cannot be set.
+ *
+ *  `fd`:
+ *    listening socket, -1 if not listening.
+ */
+struct argparse_control {
+  static constexpr std::size_t request_size = 1024;
+  static constexpr std::size_t response_size = 1024;
+  static constexpr std::size_t max_words = 64;
+
+  argparse_option const* options = nullptr;
+  std::size_t n_options = 0;
+  argparse_index const* index = nullptr;
+  argparse_source* sources = nullptr;
+  char* values = nullptr;
+  std::size_t value_size = 0;
+  int fd = -1;
+};
+
+/**
+ * initializes `self` over the given options, with `sources` holding
+ * `n_options` entries, and `values` of `values_size` bytes, possibly nullptr
+ * if only options of built-in types other than strings are set.
+ * `argc` and `argv` are the command line, before `parse_args` rearranges it,
+ * used to mark the options it sets.
+ * the option table, the index, the sources and the values must outlive
+ * `self`, and the options it sets.
+ */
+void argparse_control_init(
+    argparse_control* self,
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    argparse_source* sources,
+    char* values,
+    std::size_t values_size,
+    int argc,
+    char const* const* argv) noexcept;
+
+/**
+ * listens on the Unix domain socket at `path`, replacing any existing file.
+ * returns false and sets `errno` on failure.
+ */
+auto argparse_control_listen(argparse_control* self, char const* path) noexcept
+    -> bool;
+
+/**
+ * waits up to `timeout_ms` milliseconds for a connection, and serves a
+ * single request. a client is given the same timeout to send its request,
+ * and to make room for each chunk of the response, which is dropped
+ * otherwise.
+ * returns 1 if a request was served, 0 on timeout, -1 on error.
+ */
+auto argparse_control_serve(argparse_control* self, int timeout_ms) noexcept
+    -> int;
+
+/**
+ * closes the listening socket.
+ */
+void argparse_control_close(argparse_control* self) noexcept;
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_CONTROL_HPP_C5XH0PL3E */
@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_DEFERRED_HPP_W1PF6MZ8Q
+#define ARGPARSE_CXX_ARGPARSE_DEFERRED_HPP_W1PF6MZ8Q
+
+#include "argparse.hpp"
+
+/**
+ *  deferred callbacks, to take slow callbacks (opening files, loading
+ *  certificates...) off the parse and run them in parallel, e.g.
+ *
+ *    argparse_deferred_call calls[16];
+ *    argparse_deferred deferred = {calls, 16, 0};
+ *    veg::parse_args_deferred(&deferred, &argc, argv, options, usages);
+ *    if (veg::argparse_run_deferred(&deferred, 4) != 0) { ... }
+ *
+ *  the parser records the callbacks in argv order instead of running them,
+ *  once the value of their option is set. they are then run in that order,
+ *  except that consecutive callbacks of options flagged with OPT_INDEPENDENT
+ *  run concurrently, see `with_flags`. any other callback waits for the
+ *  previous ones to return, and the next ones wait for it: it depends on all
+ *  the callbacks recorded before it.
+ *
+ *  deferred callbacks see the final values of the options, and are given a
+ *  nullptr parser. their results are kept in the calls, non-zero results
+ *  being counted as failures, and never stop the other callbacks.
+ */
+
+namespace veg {
+
+struct argparse_deferred_call {
+  argparse_option const* option;
+  int result;
+};
+
+/**
+ *  argparse deferred
+ *
+ *  `calls`:
+ *    caller-provided, with room for `capacity` calls. exceeding it is an
+ *    error of the parse.
+ */
+struct argparse_deferred {
+  argparse_deferred_call* calls;
+  std::size_t capacity;
+  std::size_t len;
+};
+
+/**
+ *  argparse executor
+ *
+ *  `submit`:
+ *    runs `fn(arg)`, possibly concurrently with the previously submitted
+ *    functions.
+ *
+ *  `wait`:
+ *    returns once all the submitted functions returned.
+ */
+struct argparse_executor {
+  void* context;
+  void (*submit)(void* context, void (*fn)(void* arg), void* arg);
+  void (*wait)(void* context);
+};
+
+/**
+ * runs the recorded callbacks, independent ones through `executor`, and
+ * returns the number of failures.
+ */
+auto argparse_run_deferred(
+    argparse_deferred* deferred, argparse_executor const& executor)
+    -> std::size_t;
+
+/**
+ * runs the recorded callbacks, independent ones on up to `n_threads`
+ * threads, the calling one included. returns the number of failures.
+ * threads are started for each run of independent callbacks, and capped to
+ * 64. the callbacks of the threads that fail to start run on the others.
+ */
+auto argparse_run_deferred(argparse_deferred* deferred, unsigned n_threads)
+    -> std::size_t;
+
+/**
+ * same as `parse_args`, recording the callbacks in `deferred` instead of
+ * running them.
+ */
+inline void parse_args_deferred(
+    argparse_deferred* deferred,
+    int* argc,
+    char** argv,
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    char const* const* usages,
+    std::size_t n_usages,
+    char const* description = "",
+    char const* epilogue = "",
+    int flags = 0) noexcept {
+  argparse ap = {
+      *argc,
+      argv,
+      options,
+      n_options,
+      usages,
+      n_usages,
+      flags,
+      description,
+      epilogue,
+      nullptr,
+      0,
+      nullptr,
+      index,
+      deferred,
+      0};
+  *argc = _argparse::argparse_parse(&ap, *argc, argv);
+}
+
+template <std::size_t n_options, std::size_t n_usages>
+void parse_args_deferred(
+    argparse_deferred* deferred,
+    int* argc,
+    char** argv,
+    argparse_option const (&options)[n_options],
+    char const* const (&usages)[n_usages],
+    char const* description = "",
+    char const* epilogue = "",
+    int flags = 0) noexcept {
+  parse_args_deferred(
+      deferred,
+      argc,
+      argv,
+      options,
+      n_options,
+      nullptr,
+      usages,
+      n_usages,
+      description,
+      epilogue,
+      flags);
+}
+
+template <std::size_t n_usages>
+void parse_args_deferred(
+    argparse_deferred* deferred,
+    int* argc,
+    char** argv,
+    argparse_index const& index,
+    char const* const (&usages)[n_usages],
+    char const* description = "",
+    char const* epilogue = "",
+    int flags = 0) noexcept {
+  parse_args_deferred(
+      deferred,
+      argc,
+      argv,
+      index.options,
+      index.len,
+      &index,
+      usages,
+      n_usages,
+      description,
+      epilogue,
+      flags);
+}
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_DEFERRED_HPP_W1PF6MZ8Q */
@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_EVENTS_HPP_J4TB7NW2C
+#define ARGPARSE_CXX_ARGPARSE_EVENTS_HPP_J4TB7NW2C
+
+#include "argparse.hpp"
+
+/**
+ *  pull parsing, yielding the events of a command line lazily, e.g.
+ *
+ *    for (veg::argparse_event const& e : veg::argparse_events(options, argc,
+ *                                                             argv)) {
+ *      if (e.kind == veg::ARGPARSE_EVENT_POSITIONAL) {
+ *        return run_command(argc - e.index, argv + e.index); // stop early
+ *      }
+ *      ...
+ *    }
+ *
+ *  arguments are matched as by `parse_args`, but nothing is written, no
+ *  callback is run, and errors are events instead of exiting: the consumer
+ *  decides what to convert, forward or reject. the cursor is the only
+ *  state, and arguments are never modified.
+ */
+
+namespace veg {
+
+enum argparse_event_kind : unsigned char {
+  ARGPARSE_EVENT_OPTION,
+  ARGPARSE_EVENT_POSITIONAL,
+  ARGPARSE_EVENT_SEPARATOR, // `--`
+  ARGPARSE_EVENT_ERROR,
+};
+
+/**
+ *  argparse event
+ *
+ *  `option`:
+ *    matched option, nullptr for positional arguments, separators and
+ *    unknown options.
+ *
+ *  `value`:
+ *    value of the option as accepted by `argparse_set_value`, "1" or "0" for
+ *    flags. the argument itself for positional arguments, and the offending
+ *    option, without its leading dash(es), for errors.
+ *
+ *  `error`:
+ *    reason of the failure, for errors.
+ *
+ *  `index`, `n_args`:
+ *    position in `argv` of the argument the event comes from, and number of
+ *    arguments ended by the event. each option of a short option cluster but
+ *    the last ends none, so that the events cover `argv` exactly once.
+ */
+struct argparse_event {
+  argparse_event_kind kind;
+  argparse_option const* option;
+  char const* value;
+  char const* error;
+  int index;
+  int n_args;
+};
+
+/**
+ *  argparse cursor
+ *
+ *  `pos`:
+ *    position in `argv` of the next argument.
+ *
+ *  `cluster`:
+ *    rest of the short option cluster at `pos`, or nullptr.
+ *
+ *  `literal`:
+ *    whether the next arguments are positional, after `--`, or after a
+ *    positional argument with ARGPARSE_STOP_AT_NON_OPTION.
+ */
+struct argparse_cursor {
+  argparse_option const* options;
+  std::size_t n_options;
+  argparse_index const* index;
+  int flags;
+  int argc;
+  char const* const* argv;
+  int pos;
+  char const* cluster;
+  bool literal;
+};
+
+/**
+ * initializes `self` over the arguments of `argv` following the program
+ * name, as given to `parse_args`.
+ */
+void argparse_cursor_init(
+    argparse_cursor* self,
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    int flags,
+    int argc,
+    char const* const* argv) noexcept;
+
+/**
+ * reads the next event into `*event`. returns false at the end of `argv`.
+ */
+auto argparse_cursor_next(argparse_cursor* self, argparse_event* event) noexcept
+    -> bool;
+
+/**
+ *  range over the events of a cursor, for range-based for loops
+ */
+class argparse_events {
+public:
+  class iterator {
+  public:
+    auto operator*() const noexcept -> argparse_event const& { return event_; }
+    auto operator->() const noexcept -> argparse_event const* {
+      return &event_;
+    }
+    auto operator++() noexcept -> iterator& {
+      if (!argparse_cursor_next(cursor_, &event_)) {
+        cursor_ = nullptr;
+      }
+      return *this;
+    }
+    friend auto operator==(iterator const& a, iterator const& b) noexcept
+        -> bool {
+      return a.cursor_ == b.cursor_;
+    }
+    friend auto operator!=(iterator const& a, iterator const& b) noexcept
+        -> bool {
+      return a.cursor_ != b.cursor_;
+    }
+
+  private:
+    friend class argparse_events;
+    explicit iterator(argparse_cursor* cursor) noexcept : cursor_(cursor) {}
+
+    argparse_cursor* cursor_;
+    argparse_event event_{};
+  };
+
+  argparse_events(
+      argparse_option const* options,
+      std::size_t n_options,
+      int argc,
+      char const* const* argv,
+      int flags = 0) noexcept {
+    argparse_cursor_init(
+        &cursor_, options, n_options, nullptr, flags, argc, argv);
+  }
+
+  template <std::size_t n_options>
+  argparse_events(
+      argparse_option const (&options)[n_options],
+      int argc,
+      char const* const* argv,
+      int flags = 0) noexcept
+      : argparse_events(options, n_options, argc, argv, flags) {}
+
+  argparse_events(
+      argparse_index const& index,
+      int argc,
+      char const* const* argv,
+      int flags = 0) noexcept {
+    argparse_cursor_init(
+        &cursor_, index.options, index.len, &index, flags, argc, argv);
+  }
+
+  argparse_events(argparse_events const&) = delete;
+  auto operator=(argparse_events const&) -> argparse_events& = delete;
+
+  /**
+   * reads the first event. the range is single-pass.
+   */
+  auto begin() noexcept -> iterator { return ++iterator(&cursor_); }
+  auto end() noexcept -> iterator { return iterator(nullptr); }
+
+  /**
+   * cursor, positioned after the last event read.
+   */
+  auto cursor() noexcept -> argparse_cursor& { return cursor_; }
+
+private:
+  argparse_cursor cursor_;
+};
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_EVENTS_HPP_J4TB7NW2C */
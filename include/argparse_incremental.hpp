@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_INCREMENTAL_HPP_R8MW3Q
+#define ARGPARSE_CXX_ARGPARSE_INCREMENTAL_HPP_R8MW3Q
+
+#include "argparse.hpp"
+
+/**
+ *  incremental parsing, for editors and completion daemons validating a
+ *  command line after each change, e.g.
+ *
+ *    argparse_incremental_edit(&inc, 0, 0, words, n_words); // initial line
+ *    argparse_incremental_edit(&inc, 2, 3, &word, 1);       // word 2 changed
+ *    if (argparse_incremental_error(&inc, &token) != nullptr) { ... }
+ *
+ *  the parser keeps the classification of each token, and the token of the
+ *  last occurrence of each option. an edit replaces a range of tokens and
+ *  classifies the new tokens, then the following ones until their
+ *  classification is known to be unchanged: a `--` or a new non-option word
+ *  with ARGPARSE_STOP_AT_NON_OPTION reclassifies the rest of the line, a
+ *  changed option its value only.
+ *
+ *  tokens are matched as by `parse_args`, and never modified: the words must
+ *  outlive the parser. values are checked while classifying, as by
+ *  `argparse_check_value`, against their pattern as well. option values
+ *  are not written until `argparse_incremental_apply`, which converts the
+ *  winning value of each option as a full parse of the current line would.
+ *
+ *  the parser never allocates, the tokens and the last occurrences are
+ *  provided by the caller. only the checks of user-defined types may, as
+ *  they run the parse function of the type.
+ */
+
+namespace veg {
+
+enum argparse_token_kind : unsigned char {
+  ARGPARSE_TOKEN_OPTION,
+  ARGPARSE_TOKEN_VALUE, // separate value of the option in the previous token
+  ARGPARSE_TOKEN_POSITIONAL,
+  ARGPARSE_TOKEN_SEPARATOR, // `--`
+  ARGPARSE_TOKEN_UNKNOWN, // contains an unknown option
+};
+
+/**
+ *  argparse token
+ *
+ *  `option`:
+ *    index of the last option of the token, or of the option owning the
+ *    value, in the option table.
+ *
+ *  `error`:
+ *    reason of the failure of the token, or nullptr.
+ *
+ *  `state`:
+ *    parser state before the token, private.
+ */
+struct argparse_token {
+  char const* arg;
+  char const* error;
+  std::uint32_t option;
+  argparse_token_kind kind;
+  unsigned char state;
+};
+
+struct argparse_incremental {
+  argparse_option const* options;
+  std::size_t n_options;
+  argparse_index const* index;
+  int flags;
+  argparse_token* tokens;
+  std::size_t len;
+  std::size_t capacity;
+  std::uint32_t* last; // token of the last occurrence + 1, per option
+  unsigned char state; // parser state after the last token, private
+};
+
+/**
+ * initializes `self` over the given options, with room for `capacity`
+ * tokens in `tokens`, and `last` holding `n_options` entries.
+ * `flags` are the ones given to `parse_args`.
+ */
+void argparse_incremental_init(
+    argparse_incremental* self,
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    int flags,
+    argparse_token* tokens,
+    std::size_t capacity,
+    std::uint32_t* last) noexcept;
+
+/**
+ * replaces the tokens in [`begin`, `end`) with the `n_args` words of
+ * `args`. returns false, leaving `self` unchanged, if the range is invalid
+ * or the tokens do not fit.
+ */
+auto argparse_incremental_edit(
+    argparse_incremental* self,
+    std::size_t begin,
+    std::size_t end,
+    char const* const* args,
+    std::size_t n_args) -> bool;
+
+/**
+ * returns the reason of the first failing token, and sets `*token` to its
+ * position, or nullptr if the line parses. if the line violates a
+ * constraint of the index, `*token` is set to the number of tokens, see
+ * `argparse_index_violation`.
+ */
+auto argparse_incremental_error(
+    argparse_incremental const* self, std::size_t* token) noexcept
+    -> char const*;
+
+/**
+ * returns the value given to the option at `i` in the option table by the
+ * line, as accepted by `argparse_set_value`, or nullptr if it is not given.
+ */
+auto argparse_incremental_value(
+    argparse_incremental const* self, std::size_t i) noexcept -> char const*;
+
+/**
+ * sets the options given by the line to their value, the last one given, or
+ * every one in order for options with OPT_REPEATED. callbacks are not run.
+ * returns nullptr on success, or the reason of the first failure, in which
+ * case `*failed` is set to the offending option.
+ */
+auto argparse_incremental_apply(
+    argparse_incremental const* self, argparse_option const** failed)
+    -> char const*;
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_INCREMENTAL_HPP_R8MW3Q */
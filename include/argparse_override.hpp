@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_OVERRIDE_HPP_V2K9ZD4NB
+#define ARGPARSE_CXX_ARGPARSE_OVERRIDE_HPP_V2K9ZD4NB
+
+#include "argparse.hpp"
+#include <cstring>
+
+/**
+ *  thread-local overrides of option values, for tests and experiments, e.g.
+ *
+ *    {
+ *      veg::argparse_override<long> num(options, "num", "16");
+ *      handle_request(); // sees 16 through `veg::argparse_get(num_value)`
+ *    }
+ *    // restored
+ *
+ *  an override shadows the value of an option on the thread that created it,
+ *  until it goes out of scope. overrides nest, the innermost one wins, and
+ *  must be destroyed in reverse order of creation, on the same thread.
+ *  threads started within a scope do not inherit its overrides.
+ *
+ *  only reads through `argparse_get` see overrides. while the thread has none,
+ *  `argparse_get` costs a thread-local load and a branch on top of the read.
+ */
+
+namespace veg {
+namespace _argparse {
+struct override_node {
+  void const* target;
+  void const* value;
+  override_node* prev;
+};
+
+// known to be constant-initialized, so that `argparse_get` reads it directly
+// rather than through a TLS wrapper function. `__thread` keeps a single
+// definition, in the library, whatever the standard of the includer
+#if defined(__GNUC__)
+extern __thread override_node* override_top;
+#elif __cplusplus >= 201703L
+inline thread_local override_node* override_top = nullptr;
+#else
+extern thread_local override_node* override_top;
+#endif
+
+// value shadowing `target` in the override stack starting at `node`, or
+// `target` itself if none
+auto find_override(override_node const* node, void const* target) noexcept
+    -> void const*;
+
+template <typename T, is_supported<T*>* = nullptr>
+auto holds(argparse_option const* option) -> bool {
+  return option->type == to_option_type<T>::value;
+}
+
+template <typename T, has_option_traits<T>* = nullptr>
+auto holds(argparse_option const* option) -> bool {
+  return option->type == argparse_option_type::ARGPARSE_OPT_CUSTOM &&
+         option->parse == &parse_custom<T>;
+}
+} // namespace _argparse
+
+/**
+ * returns the value of `value` as seen by the current thread, which is the
+ * innermost override of `value` if any.
+ */
+template <typename T>
+auto argparse_get(T const& value) noexcept -> T const& {
+  _argparse::override_node const* node = _argparse::override_top;
+  if (node == nullptr) {
+    return value;
+  }
+  return *static_cast<T const*>(_argparse::find_override(node, &value));
+}
+
+template <typename T>
+class argparse_override {
+public:
+  /**
+   * overrides the option named `name` in `options`, without leading dashes,
+   * with `arg`, converted as by `parse_args`. flags take "1" or "0", or
+   * nullptr to be set, or unset if named `no-<name>`.
+   * `T` must be the type of the option value. on failure, `error()` returns
+   * the reason and nothing is overridden.
+   * as with `parse_args`, string and string view overrides point into `arg`,
+   * which must outlive the override.
+   */
+  argparse_override(
+      argparse_option const* options,
+      std::size_t n_options,
+      char const* name,
+      char const* arg) noexcept {
+    bool negated = false;
+    auto const* option = argparse_find_long(
+        options, n_options, nullptr, name, std::strlen(name), &negated);
+    if (option == nullptr) {
+      error_ = "unknown option";
+    } else if (!_argparse::holds<T>(option)) {
+      error_ = "does not hold a value of the given type";
+    } else if (arg == nullptr && argparse_placeholder(option) != nullptr) {
+      error_ = "requires a value";
+    } else if (arg != nullptr && negated) {
+      error_ = "takes no value";
+    } else {
+      argparse_option shadow = *option;
+      shadow.value = &value_;
+      error_ = argparse_set_value(
+          &shadow, arg != nullptr ? arg : negated ? "0" : "1");
+    }
+    if (error_ == nullptr) {
+      push(option->value);
+    }
+  }
+
+  template <std::size_t n_options>
+  argparse_override(
+      argparse_option const (&options)[n_options],
+      char const* name,
+      char const* arg) noexcept
+      : argparse_override(options, n_options, name, arg) {}
+
+  argparse_override(
+      argparse_index const& index, char const* name, char const* arg) noexcept
+      : argparse_override(index.options, index.len, name, arg) {}
+
+  /**
+   * overrides `*target` with `value`.
+   */
+  argparse_override(T const* target, T value) noexcept
+      : value_(static_cast<T&&>(value)) {
+    push(target);
+  }
+
+  argparse_override(argparse_override const&) = delete;
+  auto operator=(argparse_override const&) -> argparse_override& = delete;
+
+  ~argparse_override() {
+    if (error_ == nullptr) {
+      _argparse::override_top = node_.prev;
+    }
+  }
+
+  auto error() const noexcept -> char const* { return error_; }
+
+private:
+  void push(void const* target) noexcept {
+    node_ = {target, &value_, _argparse::override_top};
+    _argparse::override_top = &node_;
+  }
+
+  T value_{};
+  _argparse::override_node node_{};
+  char const* error_ = nullptr;
+};
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_OVERRIDE_HPP_V2K9ZD4NB */
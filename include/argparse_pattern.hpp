@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_PATTERN_HPP_C2NW8RT4J
+#define ARGPARSE_CXX_ARGPARSE_PATTERN_HPP_C2NW8RT4J
+
+#include "argparse.hpp"
+
+/**
+ *  patterns constraining the values of options, e.g.
+ *
+ *    static constexpr veg::argparse_pattern patterns[] = {
+ *        {"tenant", "[a-z][a-z0-9-]{2,62}"},
+ *        {"bucket", "[a-z0-9]([a-z0-9.-]*[a-z0-9])?"},
+ *    };
+ *
+ *  patterns are compiled once per option table into deterministic automata,
+ *  attached to its index, and checked by the parse in a single pass over the
+ *  bytes of the value, before it is converted. a mismatch is reported as any
+ *  other invalid value, e.g. "error: option `--tenant` does not match
+ *  `[a-z][a-z0-9-]{2,62}`".
+ *
+ *  the whole value must match. the syntax is a subset of the POSIX extended
+ *  one, over bytes:
+ *    `x`, `\x`   literal, for any other byte
+ *    `.`         any byte
+ *    `[a-z_]`    byte of a set, `[^...]` for the complement. POSIX classes
+ *                such as `[:alpha:]` are rejected, use `\w` or ranges
+ *    `\d`, `\w`, `\s`  digits, word bytes, white space
+ *    `(r)`, `r|s`, `r*`, `r+`, `r?`, `r{m}`, `r{m,}`, `r{m,n}`
+ *  `^` and `$` are accepted at the start and end of the pattern.
+ *  the automata are limited to 255 states, counted repetitions to 255.
+ */
+
+namespace veg {
+
+/**
+ *  argparse pattern
+ *
+ *  `name`:
+ *    long name of a string option, or of an option of a user-defined type
+ *    taking a value.
+ *
+ *  `regex`:
+ *    pattern its values must match.
+ */
+struct argparse_pattern {
+  char const* name;
+  char const* regex;
+};
+
+/**
+ *  argparse dfa
+ *
+ *  a compiled pattern.
+ *
+ *  `classes`:
+ *    class of each byte, bytes of the same class lead to the same states.
+ *
+ *  `next`:
+ *    `n_states` rows of `n_classes` states, state 0 rejects every value, and
+ *    matching starts from state 1.
+ *
+ *  `accepting`:
+ *    whether each state ends a match.
+ *
+ *  `error`:
+ *    reason of the failure of a mismatch, as returned by
+ *    `argparse_index_check`.
+ */
+struct argparse_dfa {
+  std::uint8_t classes[256];
+  std::size_t n_classes;
+  std::size_t n_states;
+  std::uint8_t const* next;
+  std::uint8_t const* accepting;
+  char const* error;
+};
+
+/**
+ * returns whether the `size` bytes at `arg` match `dfa`.
+ */
+inline auto
+argparse_dfa_match(argparse_dfa const* dfa, char const* arg, std::size_t size)
+    -> bool {
+  std::size_t state = 1;
+  for (std::size_t i = 0; i < size && state != 0; ++i) {
+    std::uint8_t c = dfa->classes[static_cast<unsigned char>(arg[i])];
+    state = dfa->next[state * dfa->n_classes + c];
+  }
+  return dfa->accepting[state] != 0;
+}
+
+/**
+ * returns the number of bytes of storage required to compile `patterns` for
+ * an index over `n_options` options. invalid patterns are not counted.
+ */
+auto argparse_patterns_storage_size(
+    std::size_t n_options,
+    argparse_pattern const* patterns,
+    std::size_t n_patterns) noexcept -> std::size_t;
+
+/**
+ * compiles `patterns` into `storage`, which must be suitably aligned for
+ * pointers and at least `argparse_patterns_storage_size` bytes long, and
+ * attaches them to `index`, to be checked by `parse_args`, `parse_span`, and
+ * by `argparse_set_value` and the modules setting values through it when
+ * given the index.
+ * returns false if the storage is too small, or prints an error and returns
+ * false if a pattern is invalid or names an unknown option, or an option of
+ * another type.
+ */
+auto argparse_index_match(
+    argparse_index* index,
+    argparse_pattern const* patterns,
+    std::size_t n_patterns,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool;
+
+/**
+ * returns nullptr if the `size` bytes at `arg` match the pattern of `option`
+ * in `index`, if any, or the reason of the failure.
+ */
+inline auto argparse_index_check(
+    argparse_index const* index,
+    argparse_option const* option,
+    char const* arg,
+    std::size_t size) noexcept -> char const* {
+  if (index == nullptr || index->patterns == nullptr) {
+    return nullptr;
+  }
+  argparse_dfa const* dfa = index->patterns[option - index->options];
+  if (dfa == nullptr || argparse_dfa_match(dfa, arg, size)) {
+    return nullptr;
+  }
+  return dfa->error;
+}
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_PATTERN_HPP_C2NW8RT4J */
@@ -0,0 +1,225 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_RELOAD_HPP_J6M1TQ8WD
+#define ARGPARSE_CXX_ARGPARSE_RELOAD_HPP_J6M1TQ8WD
+
+#include "argparse.hpp"
+#include <atomic>
+#include <type_traits>
+
+/**
+ *  runtime reload of option values from a config file, published to reader
+ *  threads as immutable snapshots.
+ *
+ *  the reloadable options point into a single trivially copyable object, the
+ *  prototype, which `parse_args` fills from the command line, e.g.
+ *
+ *    struct tunables {
+ *      long num;
+ *      bool verbose;
+ *    };
+ *    static tunables defaults;
+ *    static veg::argparse_option const options[] = {
+ *        veg::help,
+ *        {&defaults.num, 'n', "num"},
+ *        {&defaults.verbose, 'v', "verbose"},
+ *    };
+ *
+ *  `argparse_reload_init` publishes a copy of the prototype. each reload then
+ *  copies the prototype into a free slot, applies the config file to the copy
+ *  through the option table, with the option targets rebased from the
+ *  prototype to the slot, and publishes the slot with a single pointer store
+ *  if, and only if, every line of the file was accepted. the prototype itself
+ *  is never written after `argparse_reload_init`.
+ *
+ *  readers use quiescent-state based reclamation: a reader thread goes online
+ *  once, loads snapshots with `argparse_reload_snapshot`, a single acquire
+ *  load, and calls `argparse_reload_quiescent` where it holds no snapshot,
+ *  e.g. between two requests. a slot is reused once every online reader went
+ *  through a quiescent state since the slot was unpublished, so reloads never
+ *  wait for readers. they fail instead if no slot is free.
+ *
+ *  reloads must not run concurrently, they are typically driven by a single
+ *  thread calling `argparse_reload_poll` after `argparse_reload_on_signal`.
+ *
+ *  config file:
+ *    one option per line, as `name=value`, `name` to set a flag or `no-name`
+ *    to unset it. leading dashes are optional. empty lines and lines starting
+ *    with `#` are ignored.
+ *    the file is read into the slot, where string values point, and must fit
+ *    in `text_size - 1` bytes.
+ */
+
+namespace veg {
+
+struct argparse_reload_reader {
+  std::atomic<std::uint64_t> epoch{0}; // 0 while offline
+};
+
+/**
+ *  argparse reload
+ *
+ *  `current`:
+ *    published snapshot, points into one of the slots.
+ *
+ *  `epoch`:
+ *    incremented on every publication.
+ *
+ *  `pending`:
+ *    set by `argparse_reload_request`, cleared by `argparse_reload_poll`.
+ *
+ *  `error_line`:
+ *    line of the config file rejected by the last reload, 0 if none.
+ */
+struct argparse_reload {
+  argparse_option const* options = nullptr;
+  std::size_t n_options = 0;
+  argparse_index const* index = nullptr;
+  char const* prototype = nullptr;
+  std::size_t config_size = 0;
+  std::size_t text_size = 0;
+  char* slots = nullptr;
+  std::size_t slot_size = 0;
+  std::size_t n_slots = 0;
+  argparse_reload_reader* readers = nullptr;
+  std::size_t n_readers = 0;
+  std::atomic<void const*> current{nullptr};
+  std::atomic<std::uint64_t> epoch{1};
+  std::atomic<int> pending{0};
+  std::size_t error_line = 0;
+};
+
+/**
+ * returns the number of bytes of storage required for `n_slots` snapshots of
+ * `config_size` bytes, each with `text_size` bytes of config file text.
+ * two slots are enough when readers go through quiescent states faster than
+ * reloads happen.
+ */
+auto argparse_reload_storage_size(
+    std::size_t config_size,
+    std::size_t text_size,
+    std::size_t n_slots) noexcept -> std::size_t;
+
+/**
+ * initializes `self` and publishes a copy of `prototype`, which every option
+ * target must point into. `storage` must be aligned for `std::max_align_t`,
+ * and holds as many slots as fit, at least two.
+ * the option table, the index, the prototype, the readers and the storage
+ * must outlive `self`.
+ * returns false if the storage is too small.
+ */
+auto argparse_reload_init(
+    argparse_reload* self,
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    void const* prototype,
+    std::size_t config_size,
+    std::size_t text_size,
+    argparse_reload_reader* readers,
+    std::size_t n_readers,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool;
+
+template <typename Config, std::size_t n_options, std::size_t n_readers>
+auto argparse_reload_init(
+    argparse_reload* self,
+    argparse_option const (&options)[n_options],
+    argparse_index const* index,
+    Config const* prototype,
+    std::size_t text_size,
+    argparse_reload_reader (&readers)[n_readers],
+    void* storage,
+    std::size_t storage_size) noexcept -> bool {
+  static_assert(
+      alignof(Config) <= alignof(std::max_align_t),
+      "over-aligned config types are not supported");
+  static_assert(
+      std::is_trivially_copyable<Config>::value,
+      "the config is copied into the slots byte by byte");
+  return argparse_reload_init(
+      self,
+      options,
+      n_options,
+      index,
+      prototype,
+      sizeof(Config),
+      text_size,
+      readers,
+      n_readers,
+      storage,
+      storage_size);
+}
+
+/**
+ * reads the config file at `path` into a free slot and publishes it.
+ * returns nullptr on success, or the reason of the failure, in which case
+ * the published snapshot is left untouched.
+ */
+auto argparse_reload_file(argparse_reload* self, char const* path)
+    -> char const*;
+
+/**
+ * same as `argparse_reload_file` if a reload was requested since the last
+ * call, returns nullptr otherwise.
+ */
+auto argparse_reload_poll(argparse_reload* self, char const* path)
+    -> char const*;
+
+/**
+ * requests a reload, async-signal-safe.
+ */
+inline void argparse_reload_request(argparse_reload* self) noexcept {
+  self->pending.store(1, std::memory_order_relaxed);
+}
+
+/**
+ * installs a handler requesting a reload of `self` on `signo`, typically
+ * SIGHUP. a single reload can be bound to signals per process.
+ * returns false if the handler could not be installed.
+ */
+auto argparse_reload_on_signal(argparse_reload* self, int signo) noexcept
+    -> bool;
+
+template <typename Config>
+auto argparse_reload_snapshot(argparse_reload const* self) noexcept
+    -> Config const* {
+  return static_cast<Config const*>(
+      self->current.load(std::memory_order_acquire));
+}
+
+/**
+ * marks a point where `reader` holds no snapshot.
+ */
+inline void argparse_reload_quiescent(
+    argparse_reload const* self, argparse_reload_reader* reader) noexcept {
+  reader->epoch.store(
+      self->epoch.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+/**
+ * registers `reader`, before its first snapshot.
+ */
+inline void argparse_reload_online(
+    argparse_reload const* self, argparse_reload_reader* reader) noexcept {
+  reader->epoch.store(
+      self->epoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+/**
+ * unregisters `reader`, which must not hold a snapshot anymore.
+ */
+inline void argparse_reload_offline(argparse_reload_reader* reader) noexcept {
+  reader->epoch.store(0, std::memory_order_release);
+}
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_RELOAD_HPP_J6M1TQ8WD */
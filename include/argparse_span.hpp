@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_SPAN_HPP_H6QD2KV9E
+#define ARGPARSE_CXX_ARGPARSE_SPAN_HPP_H6QD2KV9E
+
+#include "argparse.hpp"
+
+/**
+ *  parsing of sized arguments, e.g. slices of a network frame or of shared
+ *  memory, without null terminators:
+ *
+ *    std::string_view args[] = {"--name=db", "-n", "16", "input"};
+ *    std::size_t rest[4];
+ *    auto result = veg::parse_span(options, args, 4, rest);
+ *    if (result.error != nullptr) { ... args[result.failed] ... }
+ *
+ *  arguments are any type with `data()` and `size()`, such as
+ *  `std::string_view`, and are matched as by `parse_args`, but never read
+ *  past their size: `--name=value` is split and short option clusters are
+ *  walked with the stored sizes.
+ *  values are viewed in place when the option type supports it, i.e.
+ *  `std::string_view` and the wrappers of argparse_std.hpp, or user-defined
+ *  types with a `parse_view` trait. numbers and characters are copied to the
+ *  stack to be converted, and must be shorter than 256 bytes.
+ *  `char const*` values and user-defined types without `parse_view` can not
+ *  be set, as they would not be null-terminated, or could keep a pointer to
+ *  a copy.
+ *
+ *  unlike `parse_args`, there is no program name, errors are returned instead
+ *  of exiting, and callbacks are not run.
+ */
+
+namespace veg {
+
+/**
+ *  argparse arg
+ *
+ *  a single argument, of `size` bytes at `data`.
+ */
+struct argparse_arg {
+  char const* data;
+  std::size_t size;
+};
+
+// returns the argument at `i` in `args`
+using argparse_arg_fn = auto (*)(void const* args, std::size_t i)
+    -> argparse_arg;
+
+/**
+ *  argparse span result
+ *
+ *  `error`:
+ *    reason of the failure, nullptr on success.
+ *
+ *  `failed`:
+ *    position of the offending argument, on failure, or the number of
+ *    arguments if the arguments violate a constraint of the index, see
+ *    `argparse_index_violation`.
+ *
+ *  `n_rest`:
+ *    number of positions written to `rest`.
+ */
+struct argparse_span_result {
+  char const* error;
+  std::size_t failed;
+  std::size_t n_rest;
+};
+
+namespace _argparse {
+template <typename Arg>
+auto get_arg(void const* args, std::size_t i) -> argparse_arg {
+  auto const& arg = static_cast<Arg const*>(args)[i];
+  return {arg.data(), arg.size()};
+}
+} // namespace _argparse
+
+/**
+ * parses the `n_args` arguments read by `get` from `args`, and writes the
+ * positions of the positional arguments to `rest`, of `n_args` entries.
+ * with ARGPARSE_KEEP_UNKNOWN, the position of arguments holding unknown
+ * options are written to `rest` as well.
+ */
+auto argparse_parse_span(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    void const* args,
+    argparse_arg_fn get,
+    std::size_t n_args,
+    std::size_t* rest,
+    int flags = 0) noexcept -> argparse_span_result;
+
+template <typename Arg>
+auto parse_span(
+    argparse_option const* options,
+    std::size_t n_options,
+    Arg const* args,
+    std::size_t n_args,
+    std::size_t* rest,
+    int flags = 0) noexcept -> argparse_span_result {
+  return argparse_parse_span(
+      options,
+      n_options,
+      nullptr,
+      args,
+      &_argparse::get_arg<Arg>,
+      n_args,
+      rest,
+      flags);
+}
+
+template <typename Arg, std::size_t n_options>
+auto parse_span(
+    argparse_option const (&options)[n_options],
+    Arg const* args,
+    std::size_t n_args,
+    std::size_t* rest,
+    int flags = 0) noexcept -> argparse_span_result {
+  return parse_span(options, n_options, args, n_args, rest, flags);
+}
+
+template <typename Arg>
+auto parse_span(
+    argparse_index const& index,
+    Arg const* args,
+    std::size_t n_args,
+    std::size_t* rest,
+    int flags = 0) noexcept -> argparse_span_result {
+  return argparse_parse_span(
+      index.options,
+      index.len,
+      &index,
+      args,
+      &_argparse::get_arg<Arg>,
+      n_args,
+      rest,
+      flags);
+}
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_SPAN_HPP_H6QD2KV9E */
@@ -0,0 +1,312 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+
+#ifndef ARGPARSE_CXX_ARGPARSE_STD_HPP_R4V8N2QXT
+#define ARGPARSE_CXX_ARGPARSE_STD_HPP_R4V8N2QXT
+
+#include "argparse.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+/**
+ *  option traits of standard library types, requires C++17.
+ *  kept out of argparse.hpp so that only the users of these types pay for the
+ *  standard headers.
+ *
+ *  `std::string_view`:
+ *    views the argument in place, no copy is made, also with `parse_span`.
+ *
+ *  `std::optional<T>`:
+ *    empty until the option is parsed, for any built-in or user-defined `T`.
+ *
+ *  `std::chrono::duration<Rep, Period>`:
+ *    a number followed by one of the `ns`, `us`, `ms`, `s`, `min` or `h`
+ *    units. a number without unit is counted in `Period`. infinite counts
+ *    and counts that do not fit in `Rep` are rejected.
+ *
+ *  `std::atomic<T>`:
+ *    parsed as `T`, then stored with `std::memory_order_release`, so that
+ *    flags read from other threads can be updated at runtime with
+ *    `argparse_set_value`.
+ *
+ *  `ordered_atomic<T, Order>`:
+ *    same as `std::atomic<T>`, stored with `Order` instead, which must be
+ *    valid for a store: relaxed, release or seq_cst.
+ *
+ *  all of them can be formatted, and parsed from sized arguments by
+ *  `parse_span`, as long as `T` can. durations are copied to the stack to be
+ *  converted, as numbers are, and must be shorter than 256 bytes.
+ */
+
+namespace veg {
+namespace _argparse {
+template <typename T, typename = void>
+struct optional_format {};
+
+template <typename T>
+struct optional_format<T, has_format<T>> {
+  static auto format(std::optional<T> const& value, char* buf, std::size_t size)
+      -> std::size_t {
+    if (!value) {
+      return std::size_t(std::snprintf(buf, size, "%s", ""));
+    }
+    return value_traits<T>::format(*value, buf, size);
+  }
+};
+
+template <typename T, typename = void>
+struct optional_parse_view {};
+
+template <typename T>
+struct optional_parse_view<T, has_parse_view<T>> {
+  static auto
+  parse_view(std::optional<T>& out, char const* arg, std::size_t size)
+      -> char const* {
+    T value{};
+    char const* reason = value_traits<T>::parse_view(value, arg, size);
+    if (reason == nullptr) {
+      out = value;
+    }
+    return reason;
+  }
+};
+
+template <typename T, typename = void>
+struct atomic_format {};
+
+template <typename T>
+struct atomic_format<T, has_format<T>> {
+  static auto format(std::atomic<T> const& value, char* buf, std::size_t size)
+      -> std::size_t {
+    return value_traits<T>::format(
+        value.load(std::memory_order_relaxed), buf, size);
+  }
+};
+
+template <
+    typename Atomic,
+    typename T,
+    std::memory_order Order,
+    typename = void>
+struct atomic_parse_view {};
+
+template <typename Atomic, typename T, std::memory_order Order>
+struct atomic_parse_view<Atomic, T, Order, has_parse_view<T>> {
+  static auto parse_view(Atomic& out, char const* arg, std::size_t size)
+      -> char const* {
+    T value{};
+    char const* reason = value_traits<T>::parse_view(value, arg, size);
+    if (reason == nullptr) {
+      out.store(value, Order);
+    }
+    return reason;
+  }
+};
+
+// traits of `Atomic`, an atomic of `T` stored with `Order`
+template <typename Atomic, typename T, std::memory_order Order>
+struct atomic_traits : atomic_format<T>, atomic_parse_view<Atomic, T, Order> {
+  static constexpr char const* placeholder = value_traits<T>::placeholder;
+  static auto parse(Atomic& out, char const* arg) -> char const* {
+    T value{};
+    char const* reason = value_traits<T>::parse(value, arg);
+    if (reason == nullptr) {
+      out.store(value, Order);
+    }
+    return reason;
+  }
+};
+
+// unit suffix accepted by the duration parser for `Period`, nullptr if none
+template <typename Period>
+constexpr auto duration_unit() -> char const* {
+  if (std::is_same<Period, std::nano>::value) {
+    return "ns";
+  }
+  if (std::is_same<Period, std::micro>::value) {
+    return "us";
+  }
+  if (std::is_same<Period, std::milli>::value) {
+    return "ms";
+  }
+  if (std::is_same<Period, std::ratio<1>>::value) {
+    return "s";
+  }
+  if (std::is_same<Period, std::ratio<60>>::value) {
+    return "min";
+  }
+  if (std::is_same<Period, std::ratio<3600>>::value) {
+    return "h";
+  }
+  return nullptr;
+}
+
+// stores `count` units of `Unit` into `out`, truncated toward zero as with
+// `duration_cast`. returns false, leaving `out` unchanged, if the count is not
+// finite or does not fit in `Rep`
+template <typename Unit, typename Rep, typename Period>
+auto to_duration(std::chrono::duration<Rep, Period>& out, long double count)
+    -> bool {
+  using ratio = std::ratio_divide<Unit, Period>;
+  long double value = count * static_cast<long double>(ratio::num) /
+                      static_cast<long double>(ratio::den);
+  if (!std::isfinite(value)) {
+    return false;
+  }
+  if constexpr (std::is_integral_v<Rep>) {
+    // both bounds are powers of two, exact in a long double
+    constexpr auto limit =
+        static_cast<long double>(std::numeric_limits<Rep>::max() / 2 + 1) * 2;
+    constexpr auto lowest =
+        static_cast<long double>(std::numeric_limits<Rep>::lowest());
+    if (!(value >= lowest && value < limit)) {
+      return false;
+    }
+  } else if constexpr (std::is_floating_point_v<Rep>) {
+    if (std::fabs(value) >
+        static_cast<long double>(std::numeric_limits<Rep>::max())) {
+      return false;
+    }
+  }
+  out = std::chrono::duration<Rep, Period>(static_cast<Rep>(value));
+  return true;
+}
+} // namespace _argparse
+
+template <>
+struct option_traits<std::string_view> {
+  static constexpr char const* placeholder = "<str>";
+  static auto parse(std::string_view& out, char const* arg) -> char const* {
+    out = arg;
+    return nullptr;
+  }
+  static auto
+  parse_view(std::string_view& out, char const* arg, std::size_t size)
+      -> char const* {
+    out = std::string_view(arg, size);
+    return nullptr;
+  }
+  static auto format(std::string_view value, char* buf, std::size_t size)
+      -> std::size_t {
+    return std::size_t(std::snprintf(
+        buf, size, "%.*s", int(value.size()), value.data()));
+  }
+};
+
+template <typename T>
+struct option_traits<std::optional<T>> : _argparse::optional_format<T>,
+                                         _argparse::optional_parse_view<T> {
+  static constexpr char const* placeholder =
+      _argparse::value_traits<T>::placeholder;
+  static auto parse(std::optional<T>& out, char const* arg) -> char const* {
+    T value{};
+    char const* reason = _argparse::value_traits<T>::parse(value, arg);
+    if (reason == nullptr) {
+      out = value;
+    }
+    return reason;
+  }
+};
+
+template <typename Rep, typename Period>
+struct option_traits<std::chrono::duration<Rep, Period>> {
+  static constexpr char const* placeholder = "<duration>";
+  static auto parse(std::chrono::duration<Rep, Period>& out, char const* arg)
+      -> char const* {
+    char* unit = nullptr;
+    long double count = std::strtold(arg, &unit);
+    if (unit == arg) {
+      return "expects a duration";
+    }
+    bool in_range = false;
+    if (*unit == '\0') {
+      in_range = _argparse::to_duration<Period>(out, count);
+    } else if (std::strcmp(unit, "ns") == 0) {
+      in_range = _argparse::to_duration<std::nano>(out, count);
+    } else if (std::strcmp(unit, "us") == 0) {
+      in_range = _argparse::to_duration<std::micro>(out, count);
+    } else if (std::strcmp(unit, "ms") == 0) {
+      in_range = _argparse::to_duration<std::milli>(out, count);
+    } else if (std::strcmp(unit, "s") == 0) {
+      in_range = _argparse::to_duration<std::ratio<1>>(out, count);
+    } else if (std::strcmp(unit, "min") == 0) {
+      in_range = _argparse::to_duration<std::ratio<60>>(out, count);
+    } else if (std::strcmp(unit, "h") == 0) {
+      in_range = _argparse::to_duration<std::ratio<3600>>(out, count);
+    } else {
+      return "expects one of the ns, us, ms, s, min or h units";
+    }
+    if (!in_range) {
+      return "expects a finite duration in range";
+    }
+    return nullptr;
+  }
+  static auto parse_view(
+      std::chrono::duration<Rep, Period>& out,
+      char const* arg,
+      std::size_t size) -> char const* {
+    if (size >= _argparse::max_value_size) {
+      return "is too long";
+    }
+    char buf[_argparse::max_value_size];
+    std::memcpy(buf, arg, size);
+    buf[size] = '\0';
+    return parse(out, buf);
+  }
+  static auto format(
+      std::chrono::duration<Rep, Period> value, char* buf, std::size_t size)
+      -> std::size_t {
+    constexpr char const* unit = _argparse::duration_unit<Period>();
+    if (unit != nullptr) {
+      return std::size_t(std::snprintf(
+          buf,
+          size,
+          "%.21Lg%s",
+          static_cast<long double>(value.count()),
+          unit));
+    }
+    return std::size_t(std::snprintf(
+        buf,
+        size,
+        "%.21Lgs",
+        std::chrono::duration<long double>(value).count()));
+  }
+};
+
+template <typename T, std::memory_order Order>
+struct ordered_atomic : std::atomic<T> {
+  static_assert(
+      Order == std::memory_order_relaxed ||
+          Order == std::memory_order_release ||
+          Order == std::memory_order_seq_cst,
+      "ordered_atomic requires an order valid for a store: "
+      "relaxed, release or seq_cst");
+  using std::atomic<T>::atomic;
+  using std::atomic<T>::operator=;
+};
+
+template <typename T, std::memory_order Order>
+struct option_traits<ordered_atomic<T, Order>>
+    : _argparse::atomic_traits<ordered_atomic<T, Order>, T, Order> {};
+
+template <typename T>
+struct option_traits<std::atomic<T>>
+    : _argparse::atomic_traits<std::atomic<T>, T, std::memory_order_release> {
+};
+
+} // namespace veg
+
+#endif /* end of include guard ARGPARSE_CXX_ARGPARSE_STD_HPP_R4V8N2QXT */
@@ -11,8 +11,13 @@
 #include <cstring>
 #include <cerrno>
 #include <exception>
+#include <functional>
 #include <limits>
+#include <new>
+#include <type_traits>
 #include "argparse.hpp"
+#include "argparse_deferred.hpp"
+#include "argparse_pattern.hpp"
 
 namespace veg {
 using namespace _argparse;
@@ -20,10 +25,9 @@ using namespace _argparse;
 #define OPT_UNSET 1
 #define OPT_LONG (1 << 1)
 
-static auto prefix_skip(char const* str, char const* prefix) -> char const* {
-  size_t len = std::strlen(prefix);
-  return std::strncmp(str, prefix, len) != 0 ? nullptr : str + len;
-}
+// `help` must stay usable in constant expressions, so that tables containing
+// it need no dynamic initializer, see the `constinit` test
+static_assert(help.short_name == 'h', "help is not a constant expression");
 
 static auto prefix_cmp(char const* str, char const* prefix) -> int {
   for (;; str++, prefix++) {
@@ -97,33 +101,197 @@ auto parse_fn(char const* in, char** str_end) -> long double {
 }
 
 template <typename T>
-void parse_num(
-    argparse*& self, argparse_option const* opt, int const flags, char*& s) {
+auto parse_number(void* value, char const* arg) -> char const* {
+  char* s = nullptr;
   errno = 0;
+  as_ref<T>(value) = parse_fn<T>(arg, &s);
+  if (errno) {
+    return std::strerror(errno);
+  }
+  if (s[0] != '\0') {
+    return "expects an integer value";
+  }
+  return nullptr;
+}
+
+template <typename T>
+void parse_num(argparse* self, argparse_option const* opt, int const flags) {
+  char const* arg = nullptr;
   if (self->optvalue != nullptr) {
-    as_ref<T>(opt->value) = parse_fn<T>(self->optvalue, &s);
+    arg = self->optvalue;
     self->optvalue = nullptr;
   } else if (self->argc > 1) {
     self->argc--;
-    as_ref<T>(opt->value) = parse_fn<T>(*++self->argv, &s);
+    arg = *++self->argv;
   } else {
     argparse_error(self, opt, "requires a value", flags);
   }
-  if (errno) {
-    argparse_error(self, opt, std::strerror(errno), flags);
+  char const* reason = parse_number<T>(opt->value, arg);
+  if (reason != nullptr) {
+    argparse_error(self, opt, reason, flags);
   }
-  if (s[0] != '\0') {
-    argparse_error(self, opt, "expects an integer value", flags);
+}
+
+auto _argparse::parse_builtin(
+    argparse_option_type type, void* value, char const* arg) -> char const* {
+  switch (type) {
+  case to_option_type<ternary>::value:
+    as_ref<ternary>(value) = arg[0] == '0' ? ternary::no : ternary::yes;
+    return nullptr;
+  case to_option_type<bool>::value:
+    as_ref<bool>(value) = arg[0] != '0';
+    return nullptr;
+  case to_option_type<char const*>::value:
+    as_ref<char const*>(value) = arg;
+    return nullptr;
+  case to_option_type<char>::value:
+    if (arg[0] != '\0' && arg[1] != '\0') {
+      return "requires a single character";
+    }
+    as_ref<char>(value) = arg[0];
+    return nullptr;
+
+#undef PARSE_NUM
+#define PARSE_NUM(T)                                                           \
+  case to_option_type<T>::value:                                               \
+    return parse_number<T>(value, arg)
+
+    PARSE_NUM(char unsigned);
+    PARSE_NUM(short unsigned);
+    PARSE_NUM(int unsigned);
+    PARSE_NUM(long unsigned);
+    PARSE_NUM(long long unsigned);
+    PARSE_NUM(char signed);
+    PARSE_NUM(short);
+    PARSE_NUM(int);
+    PARSE_NUM(long);
+    PARSE_NUM(long long);
+    PARSE_NUM(float);
+    PARSE_NUM(double);
+    PARSE_NUM(long double);
+#undef PARSE_NUM
+
+  default:
+    return "has an unexpected type";
+  }
+}
+
+auto _argparse::parse_builtin_view(
+    argparse_option_type type, void* value, char const* arg, std::size_t size)
+    -> char const* {
+  if (type == to_option_type<char const*>::value) {
+    return "requires a null-terminated argument";
+  }
+  if (size >= max_value_size) {
+    return "is too long";
+  }
+  char buf[max_value_size];
+  std::memcpy(buf, arg, size);
+  buf[size] = '\0';
+  return parse_builtin(type, value, buf);
+}
+
+auto _argparse::format_builtin(
+    argparse_option_type type, void const* value, char* buf, std::size_t size)
+    -> std::size_t {
+  void* ptr = const_cast<void*>(value);
+  int len = 0;
+  switch (type) {
+  case to_option_type<ternary>::value: {
+    ternary t = as_ref<ternary>(ptr);
+    len = std::snprintf(
+        buf,
+        size,
+        "%s",
+        t == ternary::yes ? "yes" : t == ternary::no ? "no" : "none");
+    break;
+  }
+  case to_option_type<bool>::value:
+    len = std::snprintf(buf, size, "%d", int(as_ref<bool>(ptr)));
+    break;
+  case to_option_type<char const*>::value: {
+    char const* str = as_ref<char const*>(ptr);
+    len = std::snprintf(buf, size, "%s", str != nullptr ? str : "");
+    break;
+  }
+  case to_option_type<char>::value:
+    len = std::snprintf(buf, size, "%c", as_ref<char>(ptr));
+    break;
+
+#undef FORMAT_NUM
+#define FORMAT_NUM(T, Fmt, As)                                                 \
+  case to_option_type<T>::value:                                               \
+    len = std::snprintf(buf, size, Fmt, As(as_ref<T>(ptr)));                   \
+    break
+
+    FORMAT_NUM(char unsigned, "%llu", static_cast<long long unsigned>);
+    FORMAT_NUM(short unsigned, "%llu", static_cast<long long unsigned>);
+    FORMAT_NUM(int unsigned, "%llu", static_cast<long long unsigned>);
+    FORMAT_NUM(long unsigned, "%llu", static_cast<long long unsigned>);
+    FORMAT_NUM(long long unsigned, "%llu", static_cast<long long unsigned>);
+    FORMAT_NUM(char signed, "%lld", static_cast<long long>);
+    FORMAT_NUM(short, "%lld", static_cast<long long>);
+    FORMAT_NUM(int, "%lld", static_cast<long long>);
+    FORMAT_NUM(long, "%lld", static_cast<long long>);
+    FORMAT_NUM(long long, "%lld", static_cast<long long>);
+    FORMAT_NUM(float, "%.9g", static_cast<double>);
+    FORMAT_NUM(double, "%.17g", static_cast<double>);
+    FORMAT_NUM(long double, "%.21Lg", static_cast<long double>);
+#undef FORMAT_NUM
+
+  default:
+    len = std::snprintf(buf, size, "?");
+    break;
+  }
+  return len < 0 ? 0 : std::size_t(len);
+}
+
+// runs the callback of `opt`, or records it with a deferred parser
+static auto run_callback(argparse* self, argparse_option const* opt) -> int {
+  argparse_deferred* deferred = self->deferred;
+  if (deferred == nullptr) {
+    return opt->callback(self, opt);
+  }
+  if (deferred->len == deferred->capacity) {
+    std::fprintf(stderr, "error: too many deferred callbacks\n");
+    exit(1);
+  }
+  deferred->calls[deferred->len++] = {opt, 0};
+  return 0;
+}
+
+// returns nullptr if `arg`, the value of `opt`, matches its pattern in
+// `index`, or the reason of the failure. the length of `arg` is only read
+// when the index has patterns
+static auto pattern_error(
+    argparse_index const* index, argparse_option const* opt, char const* arg)
+    -> char const* {
+  if (index == nullptr || index->patterns == nullptr) {
+    return nullptr;
+  }
+  return argparse_index_check(index, opt, arg, std::strlen(arg));
+}
+
+// fails the parse if `arg`, the value of `opt`, does not match its pattern
+static void check_pattern(
+    argparse* self, argparse_option const* opt, char const* arg, int flags) {
+  char const* reason = pattern_error(self->index, opt, arg);
+  if (reason != nullptr) {
+    argparse_error(self, opt, reason, flags);
   }
 }
 
 static auto
 argparse_getvalue(argparse* self, argparse_option const* opt, int const flags)
     -> int {
-  char* s = nullptr;
+  self->seen = argparse_index_give(
+      self->index, opt, (flags & OPT_UNSET) != 0, self->seen);
+  if ((opt->flags & OPT_HELP) != 0) {
+    return argparse_help_cb(self, opt);
+  }
   if (opt->value == nullptr) {
     if (opt->callback) {
-      return opt->callback(self, opt);
+      return run_callback(self, opt);
     }
   }
   switch (opt->type) {
@@ -144,6 +312,7 @@ argparse_getvalue(argparse* self, argparse_option const* opt, int const flags)
     } else {
       argparse_error(self, opt, "requires a value", flags);
     }
+    check_pattern(self, opt, as_ref<char const*>(opt->value), flags);
     break;
 
   case to_option_type<char>::value:
@@ -168,7 +337,7 @@ argparse_getvalue(argparse* self, argparse_option const* opt, int const flags)
 #undef PARSE_NUM
 #define PARSE_NUM(T)                                                           \
   case to_option_type<T>::value:                                               \
-    parse_num<T>(self, opt, flags, s);                                         \
+    parse_num<T>(self, opt, flags);                                            \
     break
 
     PARSE_NUM(char unsigned);
@@ -186,13 +355,36 @@ argparse_getvalue(argparse* self, argparse_option const* opt, int const flags)
     PARSE_NUM(long double);
 #undef PARSE_NUM
 
+  case argparse_option_type::ARGPARSE_OPT_CUSTOM: {
+    char const* arg = nullptr;
+    if (opt->placeholder == nullptr) {
+      arg = ((flags & OPT_UNSET) != 0) ? "0" : "1";
+    } else if (self->optvalue != nullptr) {
+      arg = self->optvalue;
+      self->optvalue = nullptr;
+    } else if (self->argc > 1) {
+      self->argc--;
+      arg = *++self->argv;
+    } else {
+      argparse_error(self, opt, "requires a value", flags);
+    }
+    if (opt->placeholder != nullptr) {
+      check_pattern(self, opt, arg, flags);
+    }
+    char const* reason = opt->parse(opt->value, arg);
+    if (reason != nullptr) {
+      argparse_error(self, opt, reason, flags);
+    }
+    break;
+  }
+
   default:
     std::fputs("unexpected\n", stderr);
     std::terminate();
   }
 
   if (opt->callback) {
-    return opt->callback(self, opt);
+    return run_callback(self, opt);
   }
 
   return 0;
@@ -225,136 +417,806 @@ static void argparse_options_check(
     case to_option_type<char const*>::value:
     case argparse_option_type::ARGPARSE_OPT_GROUP:
       continue;
+    case argparse_option_type::ARGPARSE_OPT_CUSTOM:
+      if (option->parse != nullptr) {
+        continue;
+      }
+      std::fprintf(stderr, "missing parse function: %d\n", int(i));
+      break;
     default:
-      std::fprintf(stderr, "wrong option type: %d\n", option->type);
+      std::fprintf(stderr, "wrong option type: %d\n", int(option->type));
       break;
     }
   }
 }
 
-static auto argparse_short_opt(argparse* self, argparse_option const* options)
-    -> int {
-  for (; options < self->options + self->argparse_options_len; options++) {
-    if (options->short_name == *self->optvalue) {
-      self->optvalue = self->optvalue[1] != 0 ? self->optvalue + 1 : nullptr;
-      return argparse_getvalue(self, options, 0);
+// only booleans, ternaries and user-defined flags, such as bit and counter
+// options, support negation
+static auto argparse_negatable(argparse_option const* option) -> bool {
+  if ((option->flags & OPT_NONEG) != 0) {
+    return false;
+  }
+  switch (option->type) {
+  case to_option_type<ternary>::value:
+  case to_option_type<bool>::value:
+    return true;
+  case argparse_option_type::ARGPARSE_OPT_CUSTOM:
+    return option->placeholder == nullptr;
+  default:
+    return false;
+  }
+}
+
+static auto index_find_long(
+    argparse_index const* index, char const* name, std::size_t len)
+    -> argparse_option const* {
+  std::uint32_t h = hash_name(name, len);
+  for (std::uint32_t pos = h & index->slots_mask;;
+       pos = (pos + 1) & index->slots_mask) {
+    std::uint32_t i = index->slots[pos];
+    if (i == 0) {
+      return nullptr;
+    }
+    auto const& entry = index->entries[i - 1];
+    if (entry.hash == h && entry.name_len == len &&
+        std::memcmp(index->pool + entry.name_offset, name, len) == 0) {
+      return index->options + (i - 1);
     }
   }
-  return -2;
 }
 
-static auto argparse_long_opt(argparse* self, argparse_option const* options)
-    -> int {
-  for (; options < self->options + self->argparse_options_len; options++) {
-    char const* rest = nullptr;
-    int opt_flags = 0;
-    if (options->long_name == nullptr) {
+// applies the option read from the current argument, taking its value from
+// the next argument if needed. `flags` is OPT_LONG for long options
+static void
+argparse_apply(argparse* self, argparse_read const& read, int flags) {
+  if (read.error != nullptr) {
+    argparse_error(self, read.option, read.error, flags);
+  }
+  self->optvalue = read.value;
+  argparse_getvalue(self, read.option, (read.negated ? OPT_UNSET : 0) | flags);
+  self->optvalue = nullptr;
+}
+
+static void argparse_check_constraints(argparse const* self) {
+  argparse_violation violation =
+      argparse_index_violation(self->index, self->seen);
+  if (violation.reason == nullptr) {
+    return;
+  }
+  char const* name = violation.option->long_name;
+  switch (violation.kind) {
+  case ARGPARSE_REQUIRED:
+    std::fprintf(stderr, "error: option `--%s` is required\n", name);
+    break;
+  case ARGPARSE_AT_MOST_ONE:
+    std::fprintf(
+        stderr,
+        "error: options `--%s` and `--%s` are mutually exclusive\n",
+        name,
+        violation.other->long_name);
+    break;
+  case ARGPARSE_ALL_OR_NONE:
+    std::fprintf(
+        stderr,
+        "error: option `--%s` is required with `--%s`\n",
+        name,
+        violation.other->long_name);
+    break;
+  case ARGPARSE_IMPLIES:
+    std::fprintf(
+        stderr,
+        "error: option `--%s` is required by `--%s`\n",
+        name,
+        violation.other->long_name);
+    break;
+  }
+  argparse_usage(self);
+  exit(1);
+}
+
+// option of the option argument `word` taking the next argument as its value,
+// or nullptr
+static auto value_option(argparse const* self, char const* word)
+    -> argparse_option const* {
+  auto const* options = self->options;
+  std::size_t n_options = self->argparse_options_len;
+  bool is_long = argparse_arg_kind_of(word) == ARGPARSE_ARG_LONG;
+  for (char const* c = word + (is_long ? 2 : 1); c != nullptr;) {
+    argparse_read read =
+        is_long ? argparse_read_long(options, n_options, self->index, c)
+                : argparse_read_short(options, n_options, self->index, c);
+    if (read.error != nullptr) {
+      return nullptr;
+    }
+    if (read.value == nullptr) {
+      return read.option;
+    }
+    c = read.next;
+  }
+  return nullptr;
+}
+
+// prints `word` completed with the choices of `option` starting with `value`,
+// the end of `word`, when its placeholder lists them as "{a|b|c}"
+static void complete_choices(
+    argparse_option const* option, char const* word, char const* value) {
+  char const* placeholder = argparse_placeholder(option);
+  std::size_t len = std::strlen(placeholder);
+  if (len < 2 || placeholder[0] != '{' || placeholder[len - 1] != '}') {
+    return;
+  }
+  std::size_t value_len = std::strlen(value);
+  for (char const* choice = placeholder + 1; choice < placeholder + len;) {
+    std::size_t choice_len = std::strcspn(choice, "|}");
+    if (choice_len >= value_len &&
+        std::memcmp(choice, value, value_len) == 0) {
+      std::fprintf(
+          stdout,
+          "%.*s%.*s\n",
+          int(value - word),
+          word,
+          int(choice_len),
+          choice);
+    }
+    choice += choice_len + 1;
+  }
+}
+
+static void complete_option(argparse_option const* option, char const* prefix) {
+  std::fprintf(
+      stdout,
+      "%s%s%s\t%s\n",
+      prefix,
+      option->long_name,
+      argparse_placeholder(option) != nullptr ? "=" : "",
+      option->help);
+}
+
+// prints the long names starting with `prefix`, and their negations, walking
+// the dense index entries when there is an index. `prefix` follows the `--` of
+// the word, and is completed with the choices of its option after a `=`
+static void complete_long(argparse const* self, char const* prefix) {
+  std::size_t len = std::strlen(prefix);
+  char const* eq = std::strchr(prefix, '=');
+  if (eq != nullptr) {
+    bool negated = false;
+    auto const* option = argparse_find_long(
+        self->options,
+        self->argparse_options_len,
+        self->index,
+        prefix,
+        std::size_t(eq - prefix),
+        &negated);
+    if (option != nullptr && !negated &&
+        argparse_placeholder(option) != nullptr) {
+      complete_choices(option, prefix - 2, eq + 1);
+    }
+    return;
+  }
+  bool negated = prefix_cmp(prefix, "no-") == 0;
+  for (std::size_t i = 0; i < self->argparse_options_len; ++i) {
+    char const* name = nullptr;
+    std::size_t name_len = 0;
+    if (self->index != nullptr) {
+      auto const& entry = self->index->entries[i];
+      name = self->index->pool + entry.name_offset;
+      name_len = entry.name_len;
+    } else if (self->options[i].long_name != nullptr) {
+      name = self->options[i].long_name;
+      name_len = std::strlen(name);
+    }
+    auto const* option = self->options + i;
+    if (name_len == 0 ||
+        option->type == argparse_option_type::ARGPARSE_OPT_GROUP) {
       continue;
     }
+    if (name_len >= len && std::memcmp(name, prefix, len) == 0) {
+      complete_option(option, "--");
+    } else if (
+        negated && name_len >= len - 3 &&
+        std::memcmp(name, prefix + 3, len - 3) == 0 &&
+        argparse_negatable(option)) {
+      complete_option(option, "--no-");
+    }
+  }
+}
 
-    rest = prefix_skip(self->argv[0] + 2, options->long_name);
-    if (rest == nullptr) {
-      // negation disabled?
-      if ((options->flags & OPT_NONEG) != 0) {
-        continue;
-      }
-      // only OPT_BOOLEAN/OPT_BIT supports negation
-      if (options->type != to_option_type<ternary>::value &&
-          options->type != to_option_type<bool>::value) {
-        continue;
-      }
+static void complete_options(argparse const* self, char const* prefix) {
+  if (prefix[1] == '-') {
+    complete_long(self, prefix + 2);
+    return;
+  }
+  for (std::size_t i = 0; i < self->argparse_options_len; ++i) {
+    auto const* option = self->options + i;
+    if (option->short_name != '\0' &&
+        (prefix[1] == '\0' || prefix[1] == option->short_name) &&
+        option->type != argparse_option_type::ARGPARSE_OPT_GROUP) {
+      std::fprintf(stdout, "-%c\t%s\n", option->short_name, option->help);
+    }
+  }
+  if (prefix[1] == '\0') {
+    complete_long(self, "");
+  }
+}
 
-      if (prefix_cmp(self->argv[0] + 2, "no-") != 0) {
-        continue;
-      }
-      rest = prefix_skip(self->argv[0] + 2 + 3, options->long_name);
-      if (rest == nullptr) {
-        continue;
-      }
-      opt_flags |= OPT_UNSET;
+// hands the `n` words at `words` over to `run_command`, behind the
+// `__complete` marker so that it keeps completing, and returns their number
+static auto complete_hand_over(argparse* self, char** words, int n) -> int {
+  std::memmove(self->out + 1, words, std::size_t(n) * sizeof(*self->out));
+  self->out[0] = const_cast<char*>(complete_marker);
+  self->out[n + 1] = nullptr;
+  return n + 1;
+}
+
+// answers a `__complete` query: `words` are the words following the command,
+// the last one being completed. exits once answered, or returns the words
+// left to a nested command, with ARGPARSE_STOP_AT_NON_OPTION
+static auto argparse_complete(argparse* self, char** words, int n) -> int {
+  char const* prefix = n > 0 ? words[n - 1] : "";
+  for (int i = 0; i + 1 < n; ++i) {
+    char const* word = words[i];
+    argparse_arg_kind kind = argparse_arg_kind_of(word);
+    if (kind == ARGPARSE_ARG_SEPARATOR) {
+      std::exit(0);
     }
-    if (*rest != 0) {
-      if (*rest != '=') {
-        continue;
+    if (kind == ARGPARSE_ARG_POSITIONAL) {
+      if ((self->flags & ARGPARSE_STOP_AT_NON_OPTION) != 0) {
+        return complete_hand_over(self, words + i, n - i);
       }
-      self->optvalue = rest + 1;
+      continue;
+    }
+    auto const* option = value_option(self, word);
+    if (option != nullptr && ++i == n - 1) {
+      // other values are left to the shell
+      complete_choices(option, prefix, prefix);
+      std::exit(0);
     }
-    return argparse_getvalue(self, options, opt_flags | OPT_LONG);
   }
-  return -2;
+  if (prefix[0] == '-') {
+    complete_options(self, prefix);
+    std::exit(0);
+  }
+  if ((self->flags & ARGPARSE_STOP_AT_NON_OPTION) != 0) {
+    return complete_hand_over(self, words + n - 1, 1);
+  }
+  std::exit(0);
 }
 
 auto _argparse::argparse_parse(argparse* self, int argc, char** argv) -> int {
+  if ((self->flags & ARGPARSE_COMPLETE) != 0 && argc > 1) {
+    if (std::strcmp(argv[1], complete_marker) == 0) {
+      self->out = argv;
+      return argparse_complete(self, argv + 2, argc - 2);
+    }
+    if (argc == 3 && std::strcmp(argv[1], "__completion") == 0) {
+      char const* program = std::strrchr(argv[0], '/');
+      std::exit(
+          argparse_completion_script(
+              argv[2], program != nullptr ? program + 1 : argv[0])
+              ? 0
+              : 1);
+    }
+  }
+
   self->argc = argc - 1;
   self->argv = argv + 1;
   self->out = argv;
 
   auto end = [&] {
+    argparse_check_constraints(self);
     std::memmove(
         self->out + self->cpidx, self->argv, self->argc * sizeof(*self->out));
     self->out[self->cpidx + self->argc] = nullptr;
 
     return self->cpidx + self->argc;
   };
-  auto unknown = [&] {
+  // with ARGPARSE_KEEP_UNKNOWN, unknown options are passed through in order,
+  // as non-option arguments are
+  auto unknown = [&](char const* arg) {
+    if ((self->flags & ARGPARSE_KEEP_UNKNOWN) != 0) {
+      self->out[self->cpidx++] = const_cast<char*>(arg);
+      return;
+    }
     std::fprintf(stderr, "error: unknown option `%s`\n", self->argv[0]);
     argparse_usage(self);
     std::exit(1);
   };
 
-  argparse_options_check(self->options, self->argparse_options_len);
+  // indexed tables are checked once, when the index is built
+  if (self->index == nullptr) {
+    argparse_options_check(self->options, self->argparse_options_len);
+  }
 
   for (; self->argc != 0; self->argc--, self->argv++) {
     char const* arg = self->argv[0];
-    if (arg[0] != '-' || (arg[1] == '\0')) {
+    switch (argparse_arg_kind_of(arg)) {
+    case ARGPARSE_ARG_POSITIONAL:
       if ((self->flags & ARGPARSE_STOP_AT_NON_OPTION) != 0) {
         return end();
       }
       // if it's not option or is a single char '-', copy verbatim
       self->out[self->cpidx++] = self->argv[0];
-      continue;
-    }
-    // short option
-    if (arg[1] != '-') {
-      self->optvalue = arg + 1;
-      switch (argparse_short_opt(self, self->options)) {
-      case -1:
-        break;
-      case -2:
-        unknown();
+      break;
+    case ARGPARSE_ARG_SEPARATOR:
+      self->argc--;
+      self->argv++;
+      return end();
+    case ARGPARSE_ARG_LONG: {
+      argparse_read read = argparse_read_long(
+          self->options, self->argparse_options_len, self->index, arg + 2);
+      if (read.option == nullptr) {
+        unknown(arg);
+      } else {
+        argparse_apply(self, read, OPT_LONG);
       }
-      while (self->optvalue != nullptr) {
-        switch (argparse_short_opt(self, self->options)) {
-        case -1:
+      break;
+    }
+    case ARGPARSE_ARG_SHORT:
+      for (char const* c = arg + 1; c != nullptr;) {
+        argparse_read read = argparse_read_short(
+            self->options, self->argparse_options_len, self->index, c);
+        if (read.option == nullptr) {
+          // the options of the cluster before the unknown letter are already
+          // applied, the argument is passed through unchanged
+          unknown(arg);
           break;
-        case -2:
-          unknown();
         }
+        c = read.next;
+        argparse_apply(self, read, 0);
       }
+      break;
+    }
+  }
+
+  return end();
+}
+
+static auto index_n_slots(std::size_t n_options) -> std::size_t {
+  std::size_t n_slots = 8;
+  while (n_slots < 2 * n_options) {
+    n_slots *= 2;
+  }
+  return n_slots;
+}
+
+static auto long_names_len(
+    argparse_option const* options, std::size_t n_options) -> std::size_t {
+  std::size_t len = 0;
+  for (size_t i = 0; i < n_options; ++i) {
+    if (options[i].long_name != nullptr) {
+      len += std::strlen(options[i].long_name);
+    }
+  }
+  return len;
+}
+
+static auto index_storage_size(std::size_t n_options, std::size_t pool_len)
+    -> std::size_t {
+  return n_options * sizeof(argparse_index_entry) +
+         (index_n_slots(n_options) + 256) * sizeof(std::uint32_t) + pool_len;
+}
+
+auto argparse_index_storage_size(
+    argparse_option const* options, std::size_t n_options) noexcept
+    -> std::size_t {
+  return index_storage_size(n_options, long_names_len(options, n_options));
+}
+
+auto argparse_index_build(
+    argparse_index* index,
+    argparse_option const* options,
+    std::size_t n_options,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool {
+  if (n_options >= std::numeric_limits<std::uint32_t>::max() ||
+      storage_size < argparse_index_storage_size(options, n_options)) {
+    return false;
+  }
+  argparse_options_check(options, n_options);
+
+  std::size_t n_slots = index_n_slots(n_options);
+  auto* entries = static_cast<argparse_index_entry*>(storage);
+  auto* slots = reinterpret_cast<std::uint32_t*>(entries + n_options);
+  auto* short_slots = slots + n_slots;
+  auto* pool = reinterpret_cast<char*>(short_slots + 256);
+  std::memset(slots, 0, (n_slots + 256) * sizeof(std::uint32_t));
+
+  std::size_t offset = 0;
+  for (size_t i = 0; i < n_options; ++i) {
+    auto const* option = options + i;
+    std::size_t len =
+        option->long_name != nullptr ? std::strlen(option->long_name) : 0;
+    if (len > std::numeric_limits<std::uint16_t>::max() ||
+        offset + len > std::numeric_limits<std::uint32_t>::max()) {
+      return false;
+    }
+
+    auto& entry = entries[i];
+    entry.hash = len != 0 ? hash_name(option->long_name, len) : 0;
+    entry.name_offset = static_cast<std::uint32_t>(offset);
+    entry.name_len = static_cast<std::uint16_t>(len);
+    entry.short_name = option->short_name;
+    entry.type = option->type;
+    if (len != 0) {
+      std::memcpy(pool + offset, option->long_name, len);
+    }
+
+    if (option->type == argparse_option_type::ARGPARSE_OPT_GROUP) {
+      entry.short_name = '\0';
       continue;
     }
-    // if '--' presents
-    if (arg[2] == '\0') {
-      self->argc--;
-      self->argv++;
-      break;
+    auto& short_slot =
+        short_slots[static_cast<unsigned char>(entry.short_name)];
+    if (entry.short_name != '\0' && short_slot == 0) {
+      short_slot = static_cast<std::uint32_t>(i + 1);
     }
-    // long option
-    switch (argparse_long_opt(self, self->options)) {
-    case -1:
-      break;
-    case -2:
-      unknown();
+    if (len != 0) {
+      std::size_t pos = entry.hash & (n_slots - 1);
+      for (; slots[pos] != 0; pos = (pos + 1) & (n_slots - 1)) {
+        auto const& other = entries[slots[pos] - 1];
+        if (other.hash == entry.hash && other.name_len == len &&
+            std::memcmp(pool + other.name_offset, pool + offset, len) == 0) {
+          break;
+        }
+      }
+      if (slots[pos] == 0) {
+        slots[pos] = static_cast<std::uint32_t>(i + 1);
+      }
     }
-    continue;
+    offset += len;
+  }
 
-  unknown:
-    std::fprintf(stderr, "error: unknown option `%s`\n", self->argv[0]);
-    argparse_usage(self);
-    std::exit(1);
+  index->options = options;
+  index->len = n_options;
+  index->entries = entries;
+  index->slots = slots;
+  index->slots_mask = static_cast<std::uint32_t>(n_slots - 1);
+  index->short_slots = short_slots;
+  index->pool = pool;
+  index->constraints = nullptr;
+  index->n_constraints = 0;
+  index->constraint_bits = nullptr;
+  index->constrained = nullptr;
+  index->patterns = nullptr;
+  return true;
+}
+
+auto argparse_constraints_storage_size(
+    std::size_t n_options, std::size_t n_constraints) noexcept -> std::size_t {
+  return n_constraints * sizeof(argparse_index_constraint) +
+         64 * sizeof(std::uint32_t) + n_options;
+}
+
+auto argparse_index_constrain(
+    argparse_index* index,
+    argparse_constraint const* constraints,
+    std::size_t n_constraints,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool {
+  if (storage_size <
+      argparse_constraints_storage_size(index->len, n_constraints)) {
+    return false;
   }
+  auto* compiled = static_cast<argparse_index_constraint*>(storage);
+  auto* constrained =
+      reinterpret_cast<std::uint32_t*>(compiled + n_constraints);
+  auto* bits = reinterpret_cast<std::uint8_t*>(constrained + 64);
+  std::memset(bits, 0, index->len);
 
-  return end();
+  std::size_t n_bits = 0;
+  for (std::size_t i = 0; i < n_constraints; ++i) {
+    auto const& constraint = constraints[i];
+    auto& out = compiled[i];
+    out = {0, 0, constraint.kind};
+    for (std::size_t j = 0; j < constraint.n_names; ++j) {
+      char const* name = constraint.names[j];
+      auto const* option = index_find_long(index, name, std::strlen(name));
+      if (option == nullptr) {
+        std::fprintf(
+            stderr, "error: constraint on unknown option `--%s`\n", name);
+        return false;
+      }
+      std::size_t k = std::size_t(option - index->options);
+      if (bits[k] == 0) {
+        if (n_bits == 64) {
+          std::fprintf(stderr, "error: more than 64 constrained options\n");
+          return false;
+        }
+        constrained[n_bits] = static_cast<std::uint32_t>(k);
+        bits[k] = static_cast<std::uint8_t>(++n_bits);
+      }
+      std::uint64_t bit = std::uint64_t(1) << (bits[k] - 1);
+      if (constraint.kind == ARGPARSE_IMPLIES && j > 0) {
+        out.implied |= bit;
+      } else {
+        out.mask |= bit;
+      }
+    }
+  }
+
+  index->constraints = compiled;
+  index->n_constraints = n_constraints;
+  index->constraint_bits = bits;
+  index->constrained = constrained;
+  return true;
+}
+
+// option of the lowest bit of `bits`
+static auto constrained_option(argparse_index const* index, std::uint64_t bits)
+    -> argparse_option const* {
+  std::size_t bit = 0;
+  while ((bits & 1) == 0) {
+    bits >>= 1;
+    ++bit;
+  }
+  return index->options + index->constrained[bit];
+}
+
+auto argparse_index_violation(
+    argparse_index const* index, std::uint64_t given) noexcept
+    -> argparse_violation {
+  argparse_violation violation = {
+      nullptr, ARGPARSE_REQUIRED, nullptr, nullptr};
+  if (index == nullptr) {
+    return violation;
+  }
+  for (std::size_t i = 0; i < index->n_constraints; ++i) {
+    auto const& constraint = index->constraints[i];
+    std::uint64_t found = given & constraint.mask;
+    std::uint64_t missing = constraint.mask & ~found;
+    violation.kind = constraint.kind;
+    switch (constraint.kind) {
+    case ARGPARSE_REQUIRED:
+      if (missing == 0) {
+        continue;
+      }
+      violation.reason = "a required option is missing";
+      violation.option = constrained_option(index, missing);
+      return violation;
+    case ARGPARSE_AT_MOST_ONE:
+      if ((found & (found - 1)) == 0) {
+        continue;
+      }
+      violation.reason = "mutually exclusive options are given";
+      violation.option = constrained_option(index, found);
+      violation.other = constrained_option(index, found & (found - 1));
+      return violation;
+    case ARGPARSE_ALL_OR_NONE:
+      if (found == 0 || missing == 0) {
+        continue;
+      }
+      violation.reason = "options required together are given apart";
+      violation.option = constrained_option(index, missing);
+      violation.other = constrained_option(index, found);
+      return violation;
+    case ARGPARSE_IMPLIES:
+      missing = constraint.implied & ~given;
+      if (found == 0 || missing == 0) {
+        continue;
+      }
+      violation.reason = "an option is given without the ones it requires";
+      violation.option = constrained_option(index, missing);
+      violation.other = constrained_option(index, found);
+      return violation;
+    }
+  }
+  return violation;
+}
+
+#if ARGPARSE_MODULE_SECTION
+// bounds of the `argparse_modules` section, defined by the linker if any
+// module is linked in
+extern "C" {
+extern argparse_table const* const __start_argparse_modules[]
+    __attribute__((weak));
+extern argparse_table const* const __stop_argparse_modules[]
+    __attribute__((weak));
+}
+
+// the section follows the link order, modules are visited by name instead, so
+// that the merged table, and so the usage, is stable
+static auto module_before(argparse_table const* a, argparse_table const* b)
+    -> bool {
+  int cmp = std::strcmp(a->name, b->name);
+  return cmp < 0 || (cmp == 0 && std::less<argparse_table const*>()(a, b));
+}
+
+static auto for_each_module = [](auto f) {
+  argparse_table const* prev = nullptr;
+  for (;;) {
+    argparse_table const* next = nullptr;
+    for (auto const* entry = __start_argparse_modules;
+         entry != __stop_argparse_modules;
+         ++entry) {
+      argparse_table const* table = *entry;
+      if ((prev == nullptr || module_before(prev, table)) &&
+          (next == nullptr || module_before(table, next))) {
+        next = table;
+      }
+    }
+    if (next == nullptr) {
+      return;
+    }
+    f(*next);
+    prev = next;
+  }
+};
+#else
+// constant-initialized, so that modules can register from any dynamic
+// initializer
+static argparse_module* registered_modules = nullptr;
+
+auto _argparse::register_module(argparse_module* module) noexcept
+    -> argparse_module* {
+  argparse_module* next = registered_modules;
+  registered_modules = module;
+  return next;
+}
+
+// the registration order depends on the link order, sorting by name keeps the
+// merged table, and so the usage, stable
+static void sort_modules() {
+  argparse_module* sorted = nullptr;
+  while (registered_modules != nullptr) {
+    argparse_module* module = registered_modules;
+    registered_modules = module->next;
+    argparse_module** pos = &sorted;
+    while (*pos != nullptr &&
+           std::strcmp((*pos)->table.name, module->table.name) <= 0) {
+      pos = &(*pos)->next;
+    }
+    module->next = *pos;
+    *pos = module;
+  }
+  registered_modules = sorted;
+}
+
+static auto for_each_module = [](auto f) {
+  for (auto const* module = registered_modules; module != nullptr;
+       module = module->next) {
+    f(module->table);
+  }
+};
+#endif
+
+// `for_each(f)` calls `f(table)` on each table to merge, in order
+template <typename ForEach>
+static auto merged_storage_size(ForEach for_each) -> std::size_t {
+  std::size_t n_options = 0;
+  std::size_t pool_len = 0;
+  for_each([&](argparse_table const& table) {
+    n_options += table.n_options;
+    pool_len += long_names_len(table.options, table.n_options);
+  });
+  return n_options * sizeof(argparse_option) +
+         index_storage_size(n_options, pool_len);
+}
+
+template <typename ForEach>
+static void report_conflict(
+    ForEach for_each,
+    argparse_index const* index,
+    argparse_option const* first,
+    argparse_option const* option,
+    bool is_long) {
+  auto table_of = [&](argparse_option const* opt) {
+    std::size_t offset = std::size_t(opt - index->options);
+    char const* name = nullptr;
+    for_each([&](argparse_table const& table) {
+      if (name == nullptr && offset < table.n_options) {
+        name = table.name;
+      }
+      offset -= table.n_options;
+    });
+    return name;
+  };
+  if (is_long) {
+    std::fprintf(stderr, "error: option `--%s`", option->long_name);
+  } else {
+    std::fprintf(stderr, "error: option `-%c`", option->short_name);
+  }
+  std::fprintf(
+      stderr,
+      " of `%s` is already declared by `%s`\n",
+      table_of(option),
+      table_of(first));
+}
+
+template <typename ForEach>
+static auto merge_tables(
+    argparse_index* index,
+    void* storage,
+    std::size_t storage_size,
+    ForEach for_each) -> bool {
+  std::size_t size = merged_storage_size(for_each);
+  if (storage_size < size) {
+    return false;
+  }
+
+  auto* options = static_cast<argparse_option*>(storage);
+  std::size_t n_options = 0;
+  for_each([&](argparse_table const& table) {
+    for (std::size_t i = 0; i < table.n_options; ++i) {
+      new (options + n_options++) argparse_option(table.options[i]);
+    }
+  });
+  if (!argparse_index_build(
+          index,
+          options,
+          n_options,
+          options + n_options,
+          size - n_options * sizeof(argparse_option))) {
+    return false;
+  }
+
+  // the index keeps the first option of each name, any other is a conflict
+  bool ok = true;
+  for (std::size_t i = 0; i < n_options; ++i) {
+    auto const* option = options + i;
+    if (option->type == argparse_option_type::ARGPARSE_OPT_GROUP) {
+      continue;
+    }
+    if (option->long_name != nullptr) {
+      auto const* first = index_find_long(
+          index, option->long_name, std::strlen(option->long_name));
+      if (first != option) {
+        report_conflict(for_each, index, first, option, true);
+        ok = false;
+      }
+    }
+    if (option->short_name != '\0') {
+      std::uint32_t first = index->short_slots[static_cast<unsigned char>(
+          option->short_name)];
+      if (first != i + 1) {
+        report_conflict(for_each, index, options + (first - 1), option, false);
+        ok = false;
+      }
+    }
+  }
+  return ok;
+}
+
+auto argparse_tables_storage_size(
+    argparse_table const* tables, std::size_t n_tables) noexcept
+    -> std::size_t {
+  return merged_storage_size([&](auto f) {
+    for (std::size_t i = 0; i < n_tables; ++i) {
+      f(tables[i]);
+    }
+  });
+}
+
+auto argparse_tables_build(
+    argparse_index* index,
+    argparse_table const* tables,
+    std::size_t n_tables,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool {
+  return merge_tables(index, storage, storage_size, [&](auto f) {
+    for (std::size_t i = 0; i < n_tables; ++i) {
+      f(tables[i]);
+    }
+  });
+}
+
+auto argparse_registry_storage_size() noexcept -> std::size_t {
+  return merged_storage_size(for_each_module);
+}
+
+auto argparse_registry_build(
+    argparse_index* index, void* storage, std::size_t storage_size) noexcept
+    -> bool {
+#if !ARGPARSE_MODULE_SECTION
+  sort_modules();
+#endif
+  return merge_tables(index, storage, storage_size, for_each_module);
+}
+
+auto argparse_placeholder(argparse_option const* option) -> char const* {
+  if (option->type == argparse_option_type::ARGPARSE_OPT_CUSTOM) {
+    return option->placeholder;
+  }
+  return builtin_placeholder(option->type);
 }
 
 void argparse_usage(argparse const* self) {
@@ -363,7 +1225,7 @@ void argparse_usage(argparse const* self) {
   if (self->usages != nullptr) {
     std::fprintf(stdout, "Usage: %s\n", *self->usages);
     ++usages;
-    while (self->usages < usages + self->usages_len) {
+    while (usages < usages_first + self->usages_len) {
       std::fprintf(stdout, "   or: %s\n", *usages);
       ++usages;
     }
@@ -394,14 +1256,9 @@ void argparse_usage(argparse const* self) {
       len += std::strlen((options)->long_name) + 2;
     }
 
-    if (options->type >= to_option_type<char>::value) {
-      len += std::strlen("=<char>");
-    } else if (options->type == to_option_type<char const*>::value) {
-      len += std::strlen("=<str>");
-    } else if (options->type >= to_option_type<float>::value) {
-      len += std::strlen("=<flt>");
-    } else if (options->type >= to_option_type<unsigned char>::value) {
-      len += std::strlen("=<int>");
+    char const* placeholder = argparse_placeholder(options);
+    if (placeholder != nullptr) {
+      len += std::strlen(placeholder) + 1; // '='
     }
     len = (len + 3) - ((len + 3) & 3);
     if (usage_opts_width < len) {
@@ -431,14 +1288,9 @@ void argparse_usage(argparse const* self) {
       pos += std::fprintf(stdout, "--%s", options->long_name);
     }
 
-    if (options->type == to_option_type<char>::value) {
-      pos += std::fprintf(stdout, "=<char>");
-    } else if (options->type == to_option_type<char const*>::value) {
-      pos += std::fprintf(stdout, "=<str>");
-    } else if (options->type >= to_option_type<float>::value) {
-      pos += std::fprintf(stdout, "=<flt>");
-    } else if (options->type >= to_option_type<char unsigned>::value) {
-      pos += std::fprintf(stdout, "=<int>");
+    char const* placeholder = argparse_placeholder(options);
+    if (placeholder != nullptr) {
+      pos += std::fprintf(stdout, "=%s", placeholder);
     }
     if (pos <= usage_opts_width) {
       pad = static_cast<int>(usage_opts_width - pos);
@@ -455,6 +1307,342 @@ void argparse_usage(argparse const* self) {
   }
 }
 
+// returns the first option named by the `len` first characters of `name`.
+// if `base` is not nullptr, `*base` is set to the first option named by the
+// rest of `name` after `no-`, in the same pass
+static auto linear_find_long(
+    argparse_option const* options,
+    std::size_t n_options,
+    char const* name,
+    std::size_t len,
+    argparse_option const** base) -> argparse_option const* {
+  for (std::size_t i = 0; i < n_options; ++i) {
+    char const* long_name = options[i].long_name;
+    if (long_name == nullptr) {
+      continue;
+    }
+    if (std::strncmp(long_name, name, len) == 0 && long_name[len] == '\0') {
+      return options + i;
+    }
+    if (base != nullptr && *base == nullptr &&
+        std::strncmp(long_name, name + 3, len - 3) == 0 &&
+        long_name[len - 3] == '\0') {
+      *base = options + i;
+    }
+  }
+  return nullptr;
+}
+
+auto argparse_format_value(
+    argparse_option const* option, char* buf, std::size_t size)
+    -> std::size_t {
+  // options without value and user-defined types without `format` are
+  // written by the default case of `format_builtin`
+  if (option->value == nullptr) {
+    return format_builtin(
+        argparse_option_type::ARGPARSE_OPT_GROUP, nullptr, buf, size);
+  }
+  if (option->type == argparse_option_type::ARGPARSE_OPT_CUSTOM &&
+      option->format != nullptr) {
+    return option->format(option->value, buf, size);
+  }
+  return format_builtin(option->type, option->value, buf, size);
+}
+
+auto argparse_find_long(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    char const* name,
+    std::size_t len,
+    bool* negated) -> argparse_option const* {
+  bool no_prefix = len > 3 && prefix_cmp(name, "no-") == 0;
+  argparse_option const* base = nullptr;
+  argparse_option const* option = nullptr;
+  if (index != nullptr) {
+    option = index_find_long(index, name, len);
+    if (option == nullptr && no_prefix) {
+      base = index_find_long(index, name + 3, len - 3);
+    }
+  } else {
+    option = linear_find_long(
+        options, n_options, name, len, no_prefix ? &base : nullptr);
+  }
+  *negated = false;
+  if (option != nullptr) {
+    return option;
+  }
+  if (base == nullptr || !argparse_negatable(base)) {
+    return nullptr;
+  }
+  *negated = true;
+  return base;
+}
+
+auto argparse_find_short(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    char c) -> argparse_option const* {
+  if (index != nullptr) {
+    std::uint32_t i = index->short_slots[static_cast<unsigned char>(c)];
+    return i != 0 ? options + (i - 1) : nullptr;
+  }
+  for (std::size_t i = 0; c != '\0' && i < n_options; ++i) {
+    if (options[i].short_name == c) {
+      return options + i;
+    }
+  }
+  return nullptr;
+}
+
+auto argparse_arg_kind_of(char const* arg, std::size_t size)
+    -> argparse_arg_kind {
+  if (size < 2 || arg[0] != '-' || arg[1] == '\0') {
+    return ARGPARSE_ARG_POSITIONAL;
+  }
+  if (arg[1] != '-') {
+    return ARGPARSE_ARG_SHORT;
+  }
+  if (size == 2 || arg[2] == '\0') {
+    return ARGPARSE_ARG_SEPARATOR;
+  }
+  return ARGPARSE_ARG_LONG;
+}
+
+auto argparse_read_long(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    char const* name,
+    std::size_t size) -> argparse_read {
+  std::size_t len = 0;
+  while (len < size && name[len] != '\0' && name[len] != '=') {
+    ++len;
+  }
+  argparse_read read = {nullptr, nullptr, nullptr, nullptr, false};
+  read.option =
+      argparse_find_long(options, n_options, index, name, len, &read.negated);
+  char const* value =
+      len < size && name[len] == '=' ? name + len + 1 : nullptr;
+  if (read.option == nullptr) {
+    read.error = "unknown option";
+  } else if (argparse_placeholder(read.option) != nullptr) {
+    read.value = value;
+  } else if (value != nullptr) {
+    read.error = "takes no value";
+  } else {
+    read.value = read.negated ? "0" : "1";
+  }
+  return read;
+}
+
+auto argparse_read_short(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    char const* c,
+    std::size_t size) -> argparse_read {
+  argparse_read read = {nullptr, nullptr, nullptr, nullptr, false};
+  read.option = argparse_find_short(options, n_options, index, *c);
+  char const* rest = size > 1 && c[1] != '\0' ? c + 1 : nullptr;
+  if (read.option == nullptr) {
+    read.error = "unknown option";
+  } else if (argparse_placeholder(read.option) != nullptr) {
+    read.value = rest;
+  } else {
+    read.value = "1";
+    read.next = rest;
+  }
+  return read;
+}
+
+auto argparse_set_value(
+    argparse_option const* option,
+    char const* arg,
+    argparse_index const* index) -> char const* {
+  if (option->value == nullptr) {
+    return "has no value";
+  }
+  char const* reason = pattern_error(index, option, arg);
+  if (reason != nullptr) {
+    return reason;
+  }
+  if (option->type == argparse_option_type::ARGPARSE_OPT_CUSTOM) {
+    return option->parse(option->value, arg);
+  }
+  return parse_builtin(option->type, option->value, arg);
+}
+
+auto argparse_check_value(
+    argparse_option const* option,
+    char const* arg,
+    argparse_index const* index) -> char const* {
+  if (option->value == nullptr) {
+    return "has no value";
+  }
+  char const* reason = pattern_error(index, option, arg);
+  if (reason != nullptr) {
+    return reason;
+  }
+  if (option->type == argparse_option_type::ARGPARSE_OPT_CUSTOM) {
+    return option->parse(nullptr, arg);
+  }
+  union {
+    long double number;
+    long long unsigned integer;
+    char const* string;
+  } scratch;
+  return parse_builtin(option->type, &scratch, arg);
+}
+
+auto argparse_find_command(
+    argparse_command const* commands,
+    std::uint32_t const* slots,
+    std::size_t n_slots,
+    char const* name) noexcept -> argparse_command const* {
+  std::size_t len = std::strlen(name);
+  for (std::size_t pos = hash_name(name, len) & (n_slots - 1);;
+       pos = (pos + 1) & (n_slots - 1)) {
+    std::uint32_t i = slots[pos];
+    if (i == 0) {
+      return nullptr;
+    }
+    if (std::strcmp(commands[i - 1].name, name) == 0) {
+      return commands + (i - 1);
+    }
+  }
+}
+
+void argparse_commands_usage(
+    argparse_command const* commands, std::size_t n_commands) {
+  std::size_t width = 0;
+  for (std::size_t i = 0; i < n_commands; ++i) {
+    std::size_t len = std::strlen(commands[i].name);
+    width = len > width ? len : width;
+  }
+  std::fprintf(stdout, "\nCommands:\n");
+  for (std::size_t i = 0; i < n_commands; ++i) {
+    std::fprintf(
+        stdout,
+        "    %-*s  %s\n",
+        int(width),
+        commands[i].name,
+        commands[i].help);
+  }
+}
+
+void argparse_complete_commands(
+    argparse_command const* commands,
+    std::size_t n_commands,
+    char const* prefix) {
+  std::size_t len = std::strlen(prefix);
+  for (std::size_t i = 0; i < n_commands; ++i) {
+    if (std::strncmp(commands[i].name, prefix, len) == 0) {
+      std::fprintf(stdout, "%s\t%s\n", commands[i].name, commands[i].help);
+    }
+  }
+}
+
+auto argparse_completion_script(char const* shell, char const* program)
+    -> bool {
+  if (std::strcmp(shell, "bash") == 0) {
+    std::fprintf(
+        stdout,
+        "_%s_complete() {\n"
+        "  local IFS=$'\\n' cur=${COMP_WORDS[COMP_CWORD]} words=() i n\n"
+        "  # `=` breaks words, options are joined again with their value\n"
+        "  for ((i = 1; i <= COMP_CWORD; i++)); do\n"
+        "    n=${#words[@]}\n"
+        "    if ((i > 1)) && [[ ${COMP_WORDS[i]} == = ||\n"
+        "                       ${COMP_WORDS[i-1]} == = ]]; then\n"
+        "      words[n-1]+=${COMP_WORDS[i]}\n"
+        "    else\n"
+        "      words[n]=${COMP_WORDS[i]}\n"
+        "    fi\n"
+        "  done\n"
+        "  COMPREPLY=($(%s __complete \"${words[@]}\" 2>/dev/null | cut -f1))\n"
+        "  # the whole word is completed, bash replaces its last part only\n"
+        "  local word=${words[${#words[@]}-1]}\n"
+        "  COMPREPLY=(\"${COMPREPLY[@]#\"${word%%\"$cur\"}\"}\")\n"
+        "  [[ ${COMPREPLY[0]} == *= ]] && compopt -o nospace\n"
+        "}\n"
+        "complete -o default -F _%s_complete %s\n",
+        program,
+        program,
+        program,
+        program);
+    return true;
+  }
+  if (std::strcmp(shell, "zsh") == 0) {
+    std::fprintf(
+        stdout,
+        "#compdef %s\n"
+        "_%s() {\n"
+        "  local -a lines\n"
+        "  lines=(\"${(@f)$(%s __complete \"${(@)words[2,CURRENT]}\" "
+        "2>/dev/null)}\")\n"
+        "  compadd -S '' -- \"${(@)lines%%%%$'\\t'*}\"\n"
+        "}\n"
+        "compdef _%s %s\n",
+        program,
+        program,
+        program,
+        program,
+        program);
+    return true;
+  }
+  if (std::strcmp(shell, "fish") == 0) {
+    std::fprintf(
+        stdout,
+        "complete -c %s -f -a '(%s __complete "
+        "(commandline -opc)[2..-1] (commandline -ct))'\n",
+        program,
+        program);
+    return true;
+  }
+  std::fprintf(stderr, "error: unsupported shell `%s`\n", shell);
+  return false;
+}
+
+auto _argparse::completing_command(int argc, char const* const* argv) noexcept
+    -> bool {
+  return argc > 0 && std::strcmp(argv[0], complete_marker) == 0;
+}
+
+auto _argparse::complete_command(
+    argparse_command const* commands,
+    std::uint32_t const* slots,
+    std::size_t n_slots,
+    std::size_t n_commands,
+    int argc,
+    char** argv) -> argparse_command const* {
+  if (argc <= 2) {
+    argparse_complete_commands(commands, n_commands, argc == 2 ? argv[1] : "");
+    std::exit(0);
+  }
+  auto const* command = argparse_find_command(commands, slots, n_slots, argv[1]);
+  if (command == nullptr) {
+    std::exit(0);
+  }
+  argv[0] = argv[1];
+  argv[1] = const_cast<char*>(complete_marker);
+  return command;
+}
+
+void _argparse::unknown_command(
+    argparse_command const* commands,
+    std::size_t n_commands,
+    char const* name) {
+  if (name == nullptr) {
+    std::fprintf(stderr, "error: missing command\n");
+  } else {
+    std::fprintf(stderr, "error: unknown command `%s`\n", name);
+  }
+  argparse_commands_usage(commands, n_commands);
+  std::exit(1);
+}
+
 auto argparse_help_cb(argparse* self, argparse_option const* option) -> int {
   (void)option;
   argparse_usage(self);
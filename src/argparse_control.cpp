@@ -0,0 +1,420 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "argparse_control.hpp"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace veg {
+
+static char const* const source_names[] = {
+    "default",
+    "command-line",
+    "control",
+};
+
+static auto find_short(argparse_control const* self, char c)
+    -> argparse_option const* {
+  return argparse_find_short(self->options, self->n_options, self->index, c);
+}
+
+// reads the option at `c` in an option argument of the given kind
+static auto
+read_option(argparse_control const* self, argparse_arg_kind kind, char const* c)
+    -> argparse_read {
+  if (kind == ARGPARSE_ARG_LONG) {
+    return argparse_read_long(self->options, self->n_options, self->index, c);
+  }
+  return argparse_read_short(self->options, self->n_options, self->index, c);
+}
+
+// walks the options of `argv` as the parser does, and calls
+// `visit(option, arg)` for each of them, with "1" or "0" as the argument of
+// flags. unknown options, flags given a value and non-option arguments are
+// skipped unless `strict`. returns nullptr, or the reason of the first
+// failure, in which case `*failed` is set to the offending argument
+template <typename Visit>
+static auto walk_args(
+    argparse_control const* self,
+    int argc,
+    char const* const* argv,
+    bool strict,
+    char const** failed,
+    Visit visit) -> char const* {
+  for (int i = 0; i < argc; ++i) {
+    char const* arg = argv[i];
+    *failed = arg;
+    argparse_arg_kind kind = argparse_arg_kind_of(arg);
+    if (kind == ARGPARSE_ARG_POSITIONAL) {
+      if (strict) {
+        return "is not an option";
+      }
+      continue;
+    }
+    if (kind == ARGPARSE_ARG_SEPARATOR) {
+      break;
+    }
+
+    for (char const* c = arg + (kind == ARGPARSE_ARG_LONG ? 2 : 1);
+         c != nullptr;) {
+      argparse_read read = read_option(self, kind, c);
+      if (read.error != nullptr) {
+        if (strict) {
+          return read.error;
+        }
+        break;
+      }
+      char const* value = read.value;
+      if (value == nullptr) {
+        if (i + 1 == argc) {
+          return "requires a value";
+        }
+        value = argv[++i];
+      }
+      char const* reason = visit(read.option, value);
+      if (reason != nullptr) {
+        return reason;
+      }
+      c = read.next;
+    }
+  }
+  return nullptr;
+}
+
+void argparse_control_init(
+    argparse_control* self,
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    argparse_source* sources,
+    char* values,
+    std::size_t values_size,
+    int argc,
+    char const* const* argv) noexcept {
+  self->options = options;
+  self->n_options = n_options;
+  self->index = index;
+  self->sources = sources;
+  self->values = values;
+  self->value_size = n_options != 0 ? values_size / n_options : 0;
+  self->fd = -1;
+  for (std::size_t i = 0; i < n_options; ++i) {
+    sources[i] = ARGPARSE_SOURCE_DEFAULT;
+  }
+
+  char const* failed = nullptr;
+  walk_args(
+      self,
+      argc - 1,
+      argv + 1,
+      false,
+      &failed,
+      [&](argparse_option const* option, char const* /*unused*/) {
+        sources[option - options] = ARGPARSE_SOURCE_COMMAND_LINE;
+        return static_cast<char const*>(nullptr);
+      });
+}
+
+auto argparse_control_listen(argparse_control* self, char const* path) noexcept
+    -> bool {
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  std::size_t len = std::strlen(path);
+  if (len >= sizeof(addr.sun_path)) {
+    errno = ENAMETOOLONG;
+    return false;
+  }
+  std::memcpy(addr.sun_path, path, len + 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  unlink(path);
+  if (fcntl(fd, F_SETFD, FD_CLOEXEC) != 0 ||
+      fcntl(fd, F_SETFL, O_NONBLOCK) != 0 ||
+      bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, 8) != 0) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    return false;
+  }
+  self->fd = fd;
+  return true;
+}
+
+void argparse_control_close(argparse_control* self) noexcept {
+  if (self->fd >= 0) {
+    close(self->fd);
+    self->fd = -1;
+  }
+}
+
+namespace {
+// response buffer, sent to the client whenever it is full. `fd` is -1 once
+// the client stopped reading, and the rest of the response is dropped
+struct writer {
+  int fd;
+  int timeout_ms;
+  std::size_t len;
+  char buf[argparse_control::response_size];
+};
+} // namespace
+
+// the client is given the timeout of its request for each chunk to fit in
+// the socket buffer, so that a client not reading cannot stall the server
+static void flush(writer* w) {
+  std::size_t sent = 0;
+  while (w->fd >= 0 && sent < w->len) {
+    pollfd p = {w->fd, POLLOUT, 0};
+    int ready = poll(&p, 1, w->timeout_ms);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready <= 0) {
+      w->fd = -1;
+      break;
+    }
+    ssize_t n = send(
+        w->fd, w->buf + sent, w->len - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    }
+    if (n <= 0) {
+      w->fd = -1;
+      break;
+    }
+    sent += std::size_t(n);
+  }
+  w->len = 0;
+}
+
+static void put(writer* w, char const* str) {
+  for (; *str != '\0'; ++str) {
+    if (w->len == sizeof(w->buf)) {
+      flush(w);
+    }
+    w->buf[w->len++] = *str;
+  }
+}
+
+// values longer than the buffer are truncated
+static void put_value(writer* w, argparse_option const* option) {
+  std::size_t room = sizeof(w->buf) - w->len;
+  std::size_t len = argparse_format_value(option, w->buf + w->len, room);
+  if (len >= room) {
+    flush(w);
+    room = sizeof(w->buf);
+    len = argparse_format_value(option, w->buf, room);
+    len = len < room ? len : room - 1;
+  }
+  w->len += len;
+}
+
+static void put_option(
+    argparse_control const* self, writer* w, argparse_option const* option) {
+  if (option->long_name != nullptr) {
+    put(w, option->long_name);
+  } else {
+    char name[] = {'-', option->short_name, '\0'};
+    put(w, name);
+  }
+  put(w, "=");
+  put_value(w, option);
+  put(w, " ");
+  put(w, source_names[self->sources[option - self->options]]);
+  put(w, "\n");
+}
+
+// whether the values of `option` are copied to its slot before being set,
+// since they may point into their argument. flags are given "1" or "0"
+static auto stored(argparse_option const* option) -> bool {
+  using _argparse::argparse_option_type;
+  return argparse_placeholder(option) != nullptr &&
+         (option->type == argparse_option_type::ARGPARSE_OPT_STRING ||
+          option->type == argparse_option_type::ARGPARSE_OPT_CUSTOM);
+}
+
+static void put_error(writer* w, char const* arg, char const* reason) {
+  put(w, "error: `");
+  put(w, arg);
+  put(w, "` ");
+  put(w, reason);
+  put(w, "\n");
+}
+
+static void
+execute(argparse_control* self, writer* w, int argc, char const* const* argv) {
+  if (argc == 0) {
+    put(w, "error: empty request\n");
+    return;
+  }
+
+  if (std::strcmp(argv[0], "get") == 0) {
+    if (argc == 1) {
+      for (std::size_t i = 0; i < self->n_options; ++i) {
+        if (self->options[i].value != nullptr) {
+          put_option(self, w, self->options + i);
+        }
+      }
+      return;
+    }
+    for (int i = 1; i < argc; ++i) {
+      char const* name = argv[i];
+      while (*name == '-') {
+        ++name;
+      }
+      bool negated = false;
+      auto const* option = argparse_find_long(
+          self->options,
+          self->n_options,
+          self->index,
+          name,
+          std::strlen(name),
+          &negated);
+      if (option == nullptr && name[0] != '\0' && name[1] == '\0') {
+        option = find_short(self, name[0]);
+      }
+      if (option == nullptr || negated) {
+        put_error(w, argv[i], "unknown option");
+        return;
+      }
+      put_option(self, w, option);
+    }
+    return;
+  }
+
+  if (std::strcmp(argv[0], "set") == 0) {
+    char const* failed = nullptr;
+    char const* reason = walk_args(
+        self,
+        argc - 1,
+        argv + 1,
+        true,
+        &failed,
+        [&](argparse_option const* option, char const* arg) -> char const* {
+          if (stored(option) && std::strlen(arg) >= self->value_size) {
+            return "is too long to be stored";
+          }
+          return argparse_check_value(option, arg, self->index);
+        });
+    if (reason == nullptr) {
+      reason = walk_args(
+          self,
+          argc - 1,
+          argv + 1,
+          true,
+          &failed,
+          [&](argparse_option const* option, char const* arg) {
+            if (stored(option)) {
+              std::size_t i = std::size_t(option - self->options);
+              char* slot = self->values + i * self->value_size;
+              arg = static_cast<char const*>(
+                  std::memcpy(slot, arg, std::strlen(arg) + 1));
+            }
+            char const* r = argparse_set_value(option, arg, self->index);
+            if (r == nullptr) {
+              self->sources[option - self->options] = ARGPARSE_SOURCE_CONTROL;
+            }
+            return r;
+          });
+    }
+    if (reason != nullptr) {
+      put_error(w, failed, reason);
+    } else {
+      put(w, "ok\n");
+    }
+    return;
+  }
+
+  put_error(w, argv[0], "unknown command, expected `get` or `set`");
+}
+
+// reads a single line, returns its length, or a negative value if the client
+// timed out or the line does not fit
+static auto read_request(int fd, char* buf, std::size_t size, int timeout_ms)
+    -> long {
+  std::size_t len = 0;
+  while (len < size) {
+    pollfd p = {fd, POLLIN, 0};
+    if (poll(&p, 1, timeout_ms) <= 0) {
+      return -1;
+    }
+    ssize_t n = recv(fd, buf + len, size - len, 0);
+    if (n < 0) {
+      return -1;
+    }
+    char const* end =
+        static_cast<char const*>(std::memchr(buf + len, '\n', std::size_t(n)));
+    if (n == 0 || end != nullptr) {
+      return end != nullptr ? long(end - buf) : long(len);
+    }
+    len += std::size_t(n);
+  }
+  return -1;
+}
+
+auto argparse_control_serve(argparse_control* self, int timeout_ms) noexcept
+    -> int {
+  pollfd p = {self->fd, POLLIN, 0};
+  int ready = poll(&p, 1, timeout_ms);
+  if (ready <= 0) {
+    return ready == 0 || errno == EINTR ? 0 : -1;
+  }
+  int client = accept(self->fd, nullptr, nullptr);
+  if (client < 0) {
+#if EAGAIN != EWOULDBLOCK
+    if (errno == EWOULDBLOCK) {
+      return 0;
+    }
+#endif
+    return errno == EAGAIN || errno == EINTR ? 0 : -1;
+  }
+
+  writer w;
+  w.fd = client;
+  w.timeout_ms = timeout_ms;
+  w.len = 0;
+  char request[argparse_control::request_size];
+  long len = read_request(client, request, sizeof(request) - 1, timeout_ms);
+  if (len < 0) {
+    put(&w, "error: incomplete or too long request\n");
+  } else {
+    request[len] = '\0';
+    char const* argv[argparse_control::max_words];
+    int argc = 0;
+    char* save = nullptr;
+    for (char* word = strtok_r(request, " \t\r", &save); word != nullptr;
+         word = strtok_r(nullptr, " \t\r", &save)) {
+      if (argc == int(argparse_control::max_words)) {
+        argc = -1;
+        break;
+      }
+      argv[argc++] = word;
+    }
+    if (argc < 0) {
+      put(&w, "error: too many words\n");
+    } else {
+      execute(self, &w, argc, argv);
+    }
+  }
+  flush(&w);
+  close(client);
+  return 1;
+}
+
+} // namespace veg
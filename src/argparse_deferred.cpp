@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+#include <atomic>
+#include <thread>
+#include "argparse_deferred.hpp"
+
+namespace veg {
+
+static void run_call(void* arg) {
+  auto* call = static_cast<argparse_deferred_call*>(arg);
+  call->result = call->option->callback(nullptr, call->option);
+}
+
+// runs each maximal sequence of independent calls with
+// `run_batch(calls, n)`, and the other calls alone, in between
+template <typename RunBatch>
+static auto run_in_order(argparse_deferred* deferred, RunBatch run_batch)
+    -> std::size_t {
+  std::size_t begin = 0;
+  for (std::size_t i = 0; i <= deferred->len; ++i) {
+    auto* call = deferred->calls + i;
+    if (i < deferred->len &&
+        (call->option->flags & OPT_INDEPENDENT) != 0) {
+      continue;
+    }
+    if (i > begin) {
+      run_batch(deferred->calls + begin, i - begin);
+    }
+    if (i < deferred->len) {
+      run_call(call);
+    }
+    begin = i + 1;
+  }
+
+  std::size_t n_failures = 0;
+  for (std::size_t i = 0; i < deferred->len; ++i) {
+    n_failures += deferred->calls[i].result != 0 ? 1 : 0;
+  }
+  return n_failures;
+}
+
+auto argparse_run_deferred(
+    argparse_deferred* deferred, argparse_executor const& executor)
+    -> std::size_t {
+  return run_in_order(
+      deferred, [&](argparse_deferred_call* calls, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+          executor.submit(executor.context, &run_call, calls + i);
+        }
+        executor.wait(executor.context);
+      });
+}
+
+auto argparse_run_deferred(argparse_deferred* deferred, unsigned n_threads)
+    -> std::size_t {
+  constexpr unsigned max_threads = 64;
+  return run_in_order(
+      deferred, [&](argparse_deferred_call* calls, std::size_t n) {
+        std::atomic<std::size_t> next{0};
+        auto work = [&] {
+          for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+               i < n;
+               i = next.fetch_add(1, std::memory_order_relaxed)) {
+            run_call(calls + i);
+          }
+        };
+        std::size_t n_workers = n_threads < n ? n_threads : n;
+        n_workers = n_workers < max_threads ? n_workers : max_threads;
+        std::thread workers[max_threads - 1];
+        std::size_t n_started = 0;
+        // a thread that fails to start leaves its share of the calls to the
+        // started ones and to this one, which joins them before returning
+        try {
+          for (; n_started + 1 < n_workers; ++n_started) {
+            workers[n_started] = std::thread(work);
+          }
+        } catch (...) {
+        }
+        work();
+        for (std::size_t i = 0; i < n_started; ++i) {
+          workers[i].join();
+        }
+      });
+}
+
+} // namespace veg
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+#include "argparse_events.hpp"
+
+namespace veg {
+
+void argparse_cursor_init(
+    argparse_cursor* self,
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    int flags,
+    int argc,
+    char const* const* argv) noexcept {
+  self->options = options;
+  self->n_options = n_options;
+  self->index = index;
+  self->flags = flags;
+  self->argc = argc;
+  self->argv = argv;
+  self->pos = 1;
+  self->cluster = nullptr;
+  self->literal = false;
+}
+
+static void set_error(
+    argparse_event* event,
+    argparse_option const* option,
+    char const* value,
+    char const* error) {
+  event->kind = ARGPARSE_EVENT_ERROR;
+  event->option = option;
+  event->value = value;
+  event->error = error;
+}
+
+// sets the value of `option` from the next argument, if any
+static void
+take_next(argparse_cursor* self, argparse_event* event, char const* name) {
+  if (self->pos < self->argc) {
+    event->value = self->argv[self->pos++];
+    ++event->n_args;
+  } else {
+    set_error(event, event->option, name, "requires a value");
+  }
+}
+
+// reads the next option of the short option cluster
+static void next_short(argparse_cursor* self, argparse_event* event) {
+  char const* c = self->cluster;
+  event->error = nullptr;
+  event->index = self->pos;
+  event->n_args = 0;
+
+  argparse_read read =
+      argparse_read_short(self->options, self->n_options, self->index, c);
+  self->cluster = read.next;
+  if (read.error != nullptr) {
+    set_error(event, read.option, c, read.error);
+  } else {
+    event->kind = ARGPARSE_EVENT_OPTION;
+    event->option = read.option;
+    event->value = read.value;
+  }
+  if (self->cluster == nullptr) {
+    ++self->pos;
+    event->n_args = 1;
+    if (event->kind == ARGPARSE_EVENT_OPTION && event->value == nullptr) {
+      take_next(self, event, c);
+    }
+  }
+}
+
+auto argparse_cursor_next(argparse_cursor* self, argparse_event* event) noexcept
+    -> bool {
+  if (self->cluster != nullptr) {
+    next_short(self, event);
+    return true;
+  }
+  if (self->pos >= self->argc) {
+    return false;
+  }
+
+  char const* arg = self->argv[self->pos];
+  event->option = nullptr;
+  event->value = nullptr;
+  event->error = nullptr;
+  event->index = self->pos;
+  event->n_args = 1;
+
+  argparse_arg_kind kind =
+      self->literal ? ARGPARSE_ARG_POSITIONAL : argparse_arg_kind_of(arg);
+  if (kind == ARGPARSE_ARG_POSITIONAL) {
+    ++self->pos;
+    event->kind = ARGPARSE_EVENT_POSITIONAL;
+    event->value = arg;
+    self->literal =
+        self->literal || (self->flags & ARGPARSE_STOP_AT_NON_OPTION) != 0;
+    return true;
+  }
+  if (kind == ARGPARSE_ARG_SHORT) {
+    self->cluster = arg + 1;
+    next_short(self, event);
+    return true;
+  }
+
+  ++self->pos;
+  if (kind == ARGPARSE_ARG_SEPARATOR) {
+    event->kind = ARGPARSE_EVENT_SEPARATOR;
+    self->literal = true;
+    return true;
+  }
+  char const* name = arg + 2;
+  argparse_read read =
+      argparse_read_long(self->options, self->n_options, self->index, name);
+  if (read.error != nullptr) {
+    set_error(event, read.option, name, read.error);
+    return true;
+  }
+  event->kind = ARGPARSE_EVENT_OPTION;
+  event->option = read.option;
+  event->value = read.value;
+  if (read.value == nullptr) {
+    take_next(self, event, name);
+  }
+  return true;
+}
+
+} // namespace veg
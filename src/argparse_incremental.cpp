@@ -0,0 +1,327 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+#include <cstring>
+#include <limits>
+#include "argparse_incremental.hpp"
+
+namespace veg {
+
+using namespace _argparse;
+
+// the token is the value of the option ending the previous one
+#define STATE_VALUE 1
+// the token follows `--`, or a non-option word with
+// ARGPARSE_STOP_AT_NON_OPTION
+#define STATE_LITERAL (1 << 1)
+
+// last occurrence to be looked up again
+static std::uint32_t const stale = std::numeric_limits<std::uint32_t>::max();
+
+// reads the option at `c` in the option argument `arg`
+static auto read_option(
+    argparse_incremental const* self, char const* arg, char const* c)
+    -> argparse_read {
+  if (arg[1] == '-') {
+    return argparse_read_long(self->options, self->n_options, self->index, c);
+  }
+  return argparse_read_short(self->options, self->n_options, self->index, c);
+}
+
+// first option of the option argument `arg`
+static auto first_option(char const* arg) -> char const* {
+  return arg + (arg[1] == '-' ? 2 : 1);
+}
+
+static void
+set_unknown(argparse_incremental const* self, argparse_token& token) {
+  token.kind = ARGPARSE_TOKEN_UNKNOWN;
+  if ((self->flags & ARGPARSE_KEEP_UNKNOWN) == 0) {
+    token.error = "unknown option";
+  }
+}
+
+// classifies the token at `i`, parsed in `state`, and returns the state of
+// the next token
+static auto
+classify(argparse_incremental* self, std::size_t i, unsigned char state)
+    -> unsigned char {
+  auto& token = self->tokens[i];
+  char const* arg = token.arg;
+  token.state = state;
+  token.error = nullptr;
+  token.option = 0;
+
+  if ((state & STATE_VALUE) != 0) {
+    token.kind = ARGPARSE_TOKEN_VALUE;
+    token.option = self->tokens[i - 1].option;
+    token.error =
+        argparse_check_value(self->options + token.option, arg, self->index);
+    return static_cast<unsigned char>(state & ~STATE_VALUE);
+  }
+  argparse_arg_kind kind = (state & STATE_LITERAL) != 0
+                               ? ARGPARSE_ARG_POSITIONAL
+                               : argparse_arg_kind_of(arg);
+  if (kind == ARGPARSE_ARG_POSITIONAL) {
+    token.kind = ARGPARSE_TOKEN_POSITIONAL;
+    if ((self->flags & ARGPARSE_STOP_AT_NON_OPTION) != 0) {
+      return state | STATE_LITERAL;
+    }
+    return state;
+  }
+  if (kind == ARGPARSE_ARG_SEPARATOR) {
+    token.kind = ARGPARSE_TOKEN_SEPARATOR;
+    return state | STATE_LITERAL;
+  }
+
+  token.kind = ARGPARSE_TOKEN_OPTION;
+  for (char const* c = first_option(arg); c != nullptr;) {
+    argparse_read read = read_option(self, arg, c);
+    if (read.option == nullptr) {
+      set_unknown(self, token);
+      return state;
+    }
+    token.option = static_cast<std::uint32_t>(read.option - self->options);
+    if (read.error != nullptr) {
+      token.error = read.error;
+      return state;
+    }
+    if (read.value == nullptr) {
+      return state | STATE_VALUE;
+    }
+    if (argparse_placeholder(read.option) != nullptr) {
+      token.error = argparse_check_value(read.option, read.value, self->index);
+    }
+    c = read.next;
+  }
+  return state;
+}
+
+// calls `visit(i, value)` for each option set by the token at `t`, `i` being
+// its position in the option table, and `value` its value as accepted by
+// `argparse_set_value`, or nullptr if missing
+template <typename Visit>
+static void
+for_each_option(argparse_incremental const* self, std::size_t t, Visit visit) {
+  auto const& token = self->tokens[t];
+  if (token.kind != ARGPARSE_TOKEN_OPTION &&
+      token.kind != ARGPARSE_TOKEN_UNKNOWN) {
+    return;
+  }
+  char const* arg = token.arg;
+  char const* next = t + 1 < self->len ? self->tokens[t + 1].arg : nullptr;
+  for (char const* c = first_option(arg); c != nullptr;) {
+    argparse_read read = read_option(self, arg, c);
+    if (read.error != nullptr) {
+      return;
+    }
+    visit(
+        std::size_t(read.option - self->options),
+        read.value != nullptr ? read.value : next);
+    c = read.next;
+  }
+}
+
+void argparse_incremental_init(
+    argparse_incremental* self,
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    int flags,
+    argparse_token* tokens,
+    std::size_t capacity,
+    std::uint32_t* last) noexcept {
+  self->options = options;
+  self->n_options = n_options;
+  self->index = index;
+  self->flags = flags;
+  self->tokens = tokens;
+  self->len = 0;
+  self->capacity = capacity;
+  self->last = last;
+  self->state = 0;
+  for (std::size_t i = 0; i < n_options; ++i) {
+    last[i] = 0;
+  }
+}
+
+auto argparse_incremental_edit(
+    argparse_incremental* self,
+    std::size_t begin,
+    std::size_t end,
+    char const* const* args,
+    std::size_t n_args) -> bool {
+  if (begin > end || end > self->len ||
+      self->len - (end - begin) + n_args > self->capacity ||
+      self->len - (end - begin) + n_args > stale - 1) {
+    return false;
+  }
+  std::size_t removed = end - begin;
+  std::memmove(
+      self->tokens + begin + n_args,
+      self->tokens + end,
+      (self->len - end) * sizeof(*self->tokens));
+  for (std::size_t i = 0; i < n_args; ++i) {
+    self->tokens[begin + i].arg = args[i];
+  }
+  self->len = self->len - removed + n_args;
+
+  // the previous token is classified again, as the state it leaves is only
+  // stored in the token following it, which may be gone
+  unsigned char state = 0;
+  if (begin > 0) {
+    state = classify(self, begin - 1, self->tokens[begin - 1].state);
+  }
+  // the following tokens are classified until one is reached in the state it
+  // was parsed in, unless it is a value, as its option may have changed
+  std::size_t stop = begin;
+  for (; stop < self->len; ++stop) {
+    auto const& token = self->tokens[stop];
+    if (stop >= begin + n_args && token.state == state &&
+        (state & STATE_VALUE) == 0) {
+      break;
+    }
+    state = classify(self, stop, state);
+  }
+  if (stop == self->len) {
+    self->state = state;
+  }
+
+  // last occurrences in the classified range are looked up again, the ones
+  // after it are moved along with their token
+  std::size_t old_stop = stop - n_args + removed;
+  std::size_t n_stale = 0;
+  for (std::size_t i = 0; i < self->n_options; ++i) {
+    std::uint32_t& last = self->last[i];
+    if (last == 0 || last - 1 < begin) {
+      continue;
+    }
+    if (last - 1 >= old_stop) {
+      last = static_cast<std::uint32_t>(last - removed + n_args);
+    } else {
+      last = stale;
+      ++n_stale;
+    }
+  }
+  for (std::size_t t = begin; t < stop; ++t) {
+    for_each_option(self, t, [&](std::size_t i, char const* /*unused*/) {
+      std::uint32_t& last = self->last[i];
+      if (last == stale) {
+        --n_stale;
+      }
+      if (last == stale || last <= t) {
+        last = static_cast<std::uint32_t>(t + 1);
+      }
+    });
+  }
+  for (std::size_t t = begin; n_stale != 0 && t-- > 0;) {
+    for_each_option(self, t, [&](std::size_t i, char const* /*unused*/) {
+      if (self->last[i] == stale) {
+        self->last[i] = static_cast<std::uint32_t>(t + 1);
+        --n_stale;
+      }
+    });
+  }
+  if (n_stale != 0) {
+    for (std::size_t i = 0; i < self->n_options; ++i) {
+      if (self->last[i] == stale) {
+        self->last[i] = 0;
+      }
+    }
+  }
+  return true;
+}
+
+auto argparse_incremental_error(
+    argparse_incremental const* self, std::size_t* token) noexcept
+    -> char const* {
+  for (std::size_t i = 0; i < self->len; ++i) {
+    if (self->tokens[i].error != nullptr) {
+      *token = i;
+      return self->tokens[i].error;
+    }
+  }
+  if ((self->state & STATE_VALUE) != 0) {
+    *token = self->len - 1;
+    return "requires a value";
+  }
+  if (self->index == nullptr || self->index->n_constraints == 0) {
+    return nullptr;
+  }
+  // negated flags have "0" as their value
+  std::uint64_t given = 0;
+  for (std::size_t i = 0; i < self->n_options; ++i) {
+    char const* value = argparse_incremental_value(self, i);
+    auto const* option = self->options + i;
+    if (value != nullptr) {
+      bool negated =
+          argparse_placeholder(option) == nullptr && value[0] == '0';
+      given = argparse_index_give(self->index, option, negated, given);
+    }
+  }
+  char const* reason = argparse_index_violation(self->index, given).reason;
+  if (reason != nullptr) {
+    *token = self->len;
+  }
+  return reason;
+}
+
+auto argparse_incremental_value(
+    argparse_incremental const* self, std::size_t i) noexcept -> char const* {
+  std::uint32_t last = self->last[i];
+  char const* value = nullptr;
+  if (last != 0) {
+    for_each_option(self, last - 1, [&](std::size_t j, char const* v) {
+      if (j == i) {
+        value = v;
+      }
+    });
+  }
+  return value;
+}
+
+// sets the option at `i` once per occurrence, in order, as `parse_args` does
+static auto apply_each(argparse_incremental const* self, std::size_t i)
+    -> char const* {
+  char const* reason = nullptr;
+  for (std::size_t t = 0; t < self->last[i] && reason == nullptr; ++t) {
+    for_each_option(self, t, [&](std::size_t j, char const* v) {
+      if (j == i && v != nullptr && reason == nullptr) {
+        reason = argparse_set_value(self->options + i, v, self->index);
+      }
+    });
+  }
+  return reason;
+}
+
+auto argparse_incremental_apply(
+    argparse_incremental const* self, argparse_option const** failed)
+    -> char const* {
+  for (std::size_t i = 0; i < self->n_options; ++i) {
+    auto const* option = self->options + i;
+    if (option->value == nullptr) {
+      continue;
+    }
+    char const* reason = nullptr;
+    if ((option->flags & OPT_REPEATED) != 0) {
+      reason = apply_each(self, i);
+    } else {
+      char const* value = argparse_incremental_value(self, i);
+      if (value == nullptr) {
+        continue;
+      }
+      reason = argparse_set_value(option, value, self->index);
+    }
+    if (reason != nullptr) {
+      *failed = option;
+      return reason;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace veg
@@ -0,0 +1,28 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+#include "argparse_override.hpp"
+
+namespace veg {
+
+#if defined(__GNUC__)
+__thread _argparse::override_node* _argparse::override_top = nullptr;
+#elif __cplusplus < 201703L
+thread_local _argparse::override_node* _argparse::override_top = nullptr;
+#endif
+
+auto _argparse::find_override(
+    override_node const* node, void const* target) noexcept -> void const* {
+  for (; node != nullptr; node = node->prev) {
+    if (node->target == target) {
+      return node->value;
+    }
+  }
+  return target;
+}
+
+} // namespace veg
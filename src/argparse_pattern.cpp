@@ -0,0 +1,657 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "argparse_pattern.hpp"
+
+namespace veg {
+
+namespace {
+constexpr std::size_t max_nodes = 512;
+constexpr std::size_t max_sets = 256;
+constexpr std::size_t max_nfa_states = 512;
+constexpr std::size_t max_dfa_states = 256;
+constexpr std::uint16_t none = 0xFFFF;
+constexpr std::uint16_t unbounded = 0xFFFF;
+constexpr std::size_t max_repeat = 255;
+
+struct byte_set {
+  std::uint64_t bits[4];
+
+  void add(unsigned char c) { bits[c / 64] |= std::uint64_t(1) << (c % 64); }
+  auto has(unsigned char c) const -> bool {
+    return ((bits[c / 64] >> (c % 64)) & 1) != 0;
+  }
+};
+
+struct state_set {
+  std::uint64_t bits[max_nfa_states / 64];
+
+  void add(std::size_t i) { bits[i / 64] |= std::uint64_t(1) << (i % 64); }
+  auto has(std::size_t i) const -> bool {
+    return ((bits[i / 64] >> (i % 64)) & 1) != 0;
+  }
+};
+
+enum node_kind : unsigned char {
+  NODE_EMPTY,
+  NODE_SET,
+  NODE_CONCAT,
+  NODE_ALT,
+  NODE_REPEAT,
+};
+
+// syntax tree node, `a` and `b` are the operands, `a` is the set of NODE_SET
+struct node {
+  node_kind kind;
+  std::uint16_t a;
+  std::uint16_t b;
+  std::uint16_t min;
+  std::uint16_t max;
+};
+
+// thompson automaton state, with a transition to `next` on the bytes of
+// `set`, if any, and up to two empty transitions
+struct nfa_state {
+  std::uint16_t set;
+  std::uint16_t next;
+  std::uint16_t eps[2];
+};
+
+struct fragment {
+  std::uint16_t start;
+  std::uint16_t end;
+};
+
+// compiles a pattern to a dfa, in a syntax tree, then a thompson automaton,
+// then a dfa over byte classes, with the subset construction
+class pattern_compiler {
+public:
+  explicit pattern_compiler(char const* regex) : regex_{regex}, pos_{regex} {}
+
+  // compiles the pattern, writing the tables to `out` if not nullptr.
+  // returns the number of bytes of the tables, or 0 and sets `error`
+  auto compile(argparse_dfa* dfa, std::uint8_t* out) -> std::size_t;
+
+  char const* error = nullptr;
+
+private:
+  auto parse_alt() -> std::uint16_t;
+  auto parse_concat() -> std::uint16_t;
+  auto parse_repeat() -> std::uint16_t;
+  auto parse_atom() -> std::uint16_t;
+  auto parse_set() -> std::uint16_t;
+  auto parse_count(std::uint16_t* count) -> bool;
+  auto escape_set(char c, byte_set* set) -> bool;
+
+  auto new_node(node_kind kind, std::uint16_t a, std::uint16_t b)
+      -> std::uint16_t;
+  auto new_set() -> std::uint16_t;
+  // records the first error, and stops the parse at an empty rest
+  auto fail(char const* reason) -> std::uint16_t {
+    if (error == nullptr) {
+      error = reason;
+    }
+    pos_ = "";
+    return none;
+  }
+
+  auto new_state() -> std::uint16_t;
+  void link(std::uint16_t from, std::uint16_t to);
+  auto build(std::uint16_t i) -> fragment;
+
+  void closure(state_set* set) const;
+  void split_classes(std::uint8_t* classes, std::size_t* n_classes) const;
+
+  char const* regex_;
+  char const* pos_;
+  node nodes_[max_nodes]{};
+  std::size_t n_nodes_ = 0;
+  byte_set sets_[max_sets]{};
+  std::size_t n_sets_ = 0;
+  nfa_state states_[max_nfa_states]{};
+  std::size_t n_states_ = 0;
+  state_set dfa_sets_[max_dfa_states]{};
+};
+
+auto pattern_compiler::new_node(
+    node_kind kind, std::uint16_t a, std::uint16_t b) -> std::uint16_t {
+  if (a == none || b == none) {
+    return none;
+  }
+  if (n_nodes_ == max_nodes) {
+    return fail("is too complex");
+  }
+  nodes_[n_nodes_] = {kind, a, b, 0, 0};
+  return static_cast<std::uint16_t>(n_nodes_++);
+}
+
+auto pattern_compiler::new_set() -> std::uint16_t {
+  if (n_sets_ == max_sets) {
+    return fail("is too complex");
+  }
+  sets_[n_sets_] = {};
+  return static_cast<std::uint16_t>(n_sets_++);
+}
+
+auto pattern_compiler::parse_alt() -> std::uint16_t {
+  std::uint16_t left = parse_concat();
+  while (*pos_ == '|') {
+    ++pos_;
+    left = new_node(NODE_ALT, left, parse_concat());
+  }
+  return left;
+}
+
+auto pattern_compiler::parse_concat() -> std::uint16_t {
+  std::uint16_t left = new_node(NODE_EMPTY, 0, 0);
+  while (*pos_ != '\0' && *pos_ != '|' && *pos_ != ')' && left != none) {
+    left = new_node(NODE_CONCAT, left, parse_repeat());
+  }
+  return left;
+}
+
+// reads a decimal count, up to `max_repeat`
+auto pattern_compiler::parse_count(std::uint16_t* count) -> bool {
+  if (*pos_ < '0' || *pos_ > '9') {
+    return false;
+  }
+  std::size_t n = 0;
+  for (; *pos_ >= '0' && *pos_ <= '9'; ++pos_) {
+    n = n * 10 + std::size_t(*pos_ - '0');
+    if (n > max_repeat) {
+      return false;
+    }
+  }
+  *count = static_cast<std::uint16_t>(n);
+  return true;
+}
+
+auto pattern_compiler::parse_repeat() -> std::uint16_t {
+  std::uint16_t atom = parse_atom();
+  while (atom != none) {
+    std::uint16_t min = 0;
+    std::uint16_t max = unbounded;
+    switch (*pos_) {
+    case '*':
+      break;
+    case '+':
+      min = 1;
+      break;
+    case '?':
+      max = 1;
+      break;
+    case '{':
+      ++pos_;
+      if (!parse_count(&min)) {
+        return fail("has an invalid repetition count");
+      }
+      max = min;
+      if (*pos_ == ',') {
+        ++pos_;
+        max = unbounded;
+        if (*pos_ != '}' && (!parse_count(&max) || max < min)) {
+          return fail("has an invalid repetition count");
+        }
+      }
+      if (*pos_ != '}') {
+        return fail("has an invalid repetition count");
+      }
+      break;
+    default:
+      return atom;
+    }
+    ++pos_;
+    atom = new_node(NODE_REPEAT, atom, 0);
+    if (atom != none) {
+      nodes_[atom].min = min;
+      nodes_[atom].max = max;
+    }
+  }
+  return atom;
+}
+
+// whether `p` starts a POSIX class, equivalence class or collating element,
+// which are not supported, rather than a `[` byte of a set
+auto posix_bracket(char const* p) -> bool {
+  return p[0] == '[' && (p[1] == ':' || p[1] == '=' || p[1] == '.');
+}
+
+// adds the bytes of the class escape `\c` to `set`, returns false if `c` is
+// a literal
+auto pattern_compiler::escape_set(char c, byte_set* set) -> bool {
+  switch (c) {
+  case 'd':
+    for (unsigned char d = '0'; d <= '9'; ++d) {
+      set->add(d);
+    }
+    return true;
+  case 'w':
+    for (unsigned b = 0; b < 256; ++b) {
+      unsigned char l = static_cast<unsigned char>(b | 0x20U);
+      if ((l >= 'a' && l <= 'z') || (b >= '0' && b <= '9') || b == '_') {
+        set->add(static_cast<unsigned char>(b));
+      }
+    }
+    return true;
+  case 's':
+    for (char const* s = " \t\n\v\f\r"; *s != '\0'; ++s) {
+      set->add(static_cast<unsigned char>(*s));
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+
+auto pattern_compiler::parse_set() -> std::uint16_t {
+  std::uint16_t i = new_set();
+  if (i == none) {
+    return none;
+  }
+  byte_set set = {};
+  bool negated = *pos_ == '^';
+  if (negated) {
+    ++pos_;
+  }
+  bool first = true;
+  for (; *pos_ != ']' || first; first = false) {
+    if (posix_bracket(pos_)) {
+      return fail("has an unsupported `[:`, `[=` or `[.` in a set");
+    }
+    char c = *pos_++;
+    if (c == '\0') {
+      return fail("has an unterminated set");
+    }
+    if (c == '\\') {
+      c = *pos_++;
+      if (c == '\0') {
+        return fail("ends with `\\`");
+      }
+      if (escape_set(c, &set)) {
+        continue;
+      }
+    }
+    unsigned char last = static_cast<unsigned char>(c);
+    if (pos_[0] == '-' && pos_[1] != ']' && pos_[1] != '\0') {
+      if (posix_bracket(pos_ + 1)) {
+        return fail("has an unsupported `[:`, `[=` or `[.` in a set");
+      }
+      char end = pos_[1];
+      pos_ += 2;
+      if (end == '\\') {
+        end = *pos_++;
+        if (end == '\0') {
+          return fail("ends with `\\`");
+        }
+      }
+      last = static_cast<unsigned char>(end);
+      if (last < static_cast<unsigned char>(c)) {
+        return fail("has an invalid range");
+      }
+    }
+    for (unsigned b = static_cast<unsigned char>(c); b <= last; ++b) {
+      set.add(static_cast<unsigned char>(b));
+    }
+  }
+  ++pos_;
+  if (negated) {
+    for (auto& word : set.bits) {
+      word = ~word;
+    }
+  }
+  sets_[i] = set;
+  return new_node(NODE_SET, i, 0);
+}
+
+auto pattern_compiler::parse_atom() -> std::uint16_t {
+  char c = *pos_++;
+  switch (c) {
+  case '(': {
+    std::uint16_t inner = parse_alt();
+    if (*pos_ != ')') {
+      return fail("has an unbalanced `(`");
+    }
+    ++pos_;
+    return inner;
+  }
+  case '[':
+    return parse_set();
+  case '*':
+  case '+':
+  case '?':
+  case '{':
+    return fail("has nothing to repeat");
+  case '^':
+    if (pos_ - 1 != regex_) {
+      return fail("has a misplaced `^`");
+    }
+    return new_node(NODE_EMPTY, 0, 0);
+  case '$':
+    if (*pos_ != '\0') {
+      return fail("has a misplaced `$`");
+    }
+    return new_node(NODE_EMPTY, 0, 0);
+  default:
+    break;
+  }
+
+  std::uint16_t i = new_set();
+  if (i == none) {
+    return none;
+  }
+  if (c == '.') {
+    sets_[i] = {{~std::uint64_t(0), ~std::uint64_t(0), ~std::uint64_t(0),
+                 ~std::uint64_t(0)}};
+  } else if (c == '\\') {
+    c = *pos_++;
+    if (c == '\0') {
+      return fail("ends with `\\`");
+    }
+    if (!escape_set(c, sets_ + i)) {
+      sets_[i].add(static_cast<unsigned char>(c));
+    }
+  } else {
+    sets_[i].add(static_cast<unsigned char>(c));
+  }
+  return new_node(NODE_SET, i, 0);
+}
+
+auto pattern_compiler::new_state() -> std::uint16_t {
+  if (n_states_ == max_nfa_states) {
+    return fail("is too complex");
+  }
+  states_[n_states_] = {none, none, {none, none}};
+  return static_cast<std::uint16_t>(n_states_++);
+}
+
+// adds an empty transition, `from` is the end of a fragment, or a new state,
+// so it has a free one
+void pattern_compiler::link(std::uint16_t from, std::uint16_t to) {
+  if (from == none || to == none) {
+    return;
+  }
+  auto& eps = states_[from].eps;
+  eps[eps[0] == none ? 0 : 1] = to;
+}
+
+auto pattern_compiler::build(std::uint16_t i) -> fragment {
+  node const& n = nodes_[i];
+  switch (n.kind) {
+  case NODE_EMPTY: {
+    std::uint16_t s = new_state();
+    return {s, s};
+  }
+  case NODE_SET: {
+    std::uint16_t s = new_state();
+    std::uint16_t e = new_state();
+    if (e != none) {
+      states_[s].set = n.a;
+      states_[s].next = e;
+    }
+    return {s, e};
+  }
+  case NODE_CONCAT: {
+    fragment a = build(n.a);
+    fragment b = build(n.b);
+    link(a.end, b.start);
+    return {a.start, b.end};
+  }
+  case NODE_ALT: {
+    std::uint16_t s = new_state();
+    fragment a = build(n.a);
+    fragment b = build(n.b);
+    std::uint16_t e = new_state();
+    link(s, a.start);
+    link(s, b.start);
+    link(a.end, e);
+    link(b.end, e);
+    return {s, e};
+  }
+  case NODE_REPEAT: {
+    std::uint16_t s = new_state();
+    std::uint16_t last = s;
+    for (std::size_t k = 0; k < n.min && error == nullptr; ++k) {
+      fragment a = build(n.a);
+      link(last, a.start);
+      last = a.end;
+    }
+    if (n.max == unbounded) {
+      std::uint16_t loop = new_state();
+      fragment a = build(n.a);
+      std::uint16_t e = new_state();
+      link(last, loop);
+      link(loop, a.start);
+      link(loop, e);
+      link(a.end, loop);
+      return {s, e};
+    }
+    for (std::size_t k = n.min; k < n.max && error == nullptr; ++k) {
+      fragment a = build(n.a);
+      std::uint16_t e = new_state();
+      link(last, a.start);
+      link(last, e);
+      link(a.end, e);
+      last = e;
+    }
+    return {s, last};
+  }
+  }
+  return {none, none};
+}
+
+void pattern_compiler::closure(state_set* set) const {
+  std::uint16_t stack[max_nfa_states];
+  std::size_t top = 0;
+  for (std::size_t i = 0; i < n_states_; ++i) {
+    if (set->has(i)) {
+      stack[top++] = static_cast<std::uint16_t>(i);
+    }
+  }
+  while (top > 0) {
+    for (std::uint16_t to : states_[stack[--top]].eps) {
+      if (to != none && !set->has(to)) {
+        set->add(to);
+        stack[top++] = to;
+      }
+    }
+  }
+}
+
+// splits the bytes into classes, such that every set holds either all the
+// bytes of a class or none of them
+void pattern_compiler::split_classes(
+    std::uint8_t* classes, std::size_t* n_classes) const {
+  std::memset(classes, 0, 256);
+  *n_classes = 1;
+  for (std::size_t i = 0; i < n_sets_; ++i) {
+    std::uint16_t split[512];
+    std::fill(split, split + 512, none);
+    std::size_t n = 0;
+    for (unsigned b = 0; b < 256; ++b) {
+      auto c = static_cast<unsigned char>(b);
+      std::size_t key = classes[b] * 2U + (sets_[i].has(c) ? 1U : 0U);
+      if (split[key] == none) {
+        split[key] = static_cast<std::uint16_t>(n++);
+      }
+      classes[b] = static_cast<std::uint8_t>(split[key]);
+    }
+    *n_classes = n;
+  }
+}
+
+auto pattern_compiler::compile(argparse_dfa* dfa, std::uint8_t* out)
+    -> std::size_t {
+  std::uint16_t root = parse_alt();
+  if (root != none && *pos_ != '\0') {
+    root = fail("has an unbalanced `)`");
+  }
+  fragment nfa = root != none ? build(root) : fragment{none, none};
+  if (error != nullptr) {
+    return 0;
+  }
+
+  std::uint8_t classes[256];
+  std::size_t n_classes = 0;
+  split_classes(classes, &n_classes);
+  unsigned char first_byte[256];
+  for (unsigned b = 256; b-- > 0;) {
+    first_byte[classes[b]] = static_cast<unsigned char>(b);
+  }
+
+  // state 0 is the empty set, which rejects everything
+  dfa_sets_[0] = {};
+  dfa_sets_[1] = {};
+  dfa_sets_[1].add(nfa.start);
+  closure(dfa_sets_ + 1);
+  std::size_t n_dfa = 2;
+  for (std::size_t i = 0; i < n_dfa; ++i) {
+    for (std::size_t c = 0; c < n_classes; ++c) {
+      state_set next = {};
+      for (std::size_t k = 0; k < n_states_; ++k) {
+        auto const& state = states_[k];
+        if (dfa_sets_[i].has(k) && state.set != none &&
+            sets_[state.set].has(first_byte[c])) {
+          next.add(state.next);
+        }
+      }
+      closure(&next);
+      std::size_t j = 0;
+      while (j < n_dfa &&
+             std::memcmp(&dfa_sets_[j], &next, sizeof(next)) != 0) {
+        ++j;
+      }
+      if (j == n_dfa) {
+        if (n_dfa == max_dfa_states) {
+          error = "is too complex";
+          return 0;
+        }
+        dfa_sets_[n_dfa++] = next;
+      }
+      if (out != nullptr) {
+        out[i * n_classes + c] = static_cast<std::uint8_t>(j);
+      }
+    }
+  }
+
+  if (out != nullptr) {
+    std::uint8_t* accepting = out + n_dfa * n_classes;
+    for (std::size_t i = 0; i < n_dfa; ++i) {
+      accepting[i] = dfa_sets_[i].has(nfa.end) ? 1 : 0;
+    }
+    std::memcpy(dfa->classes, classes, sizeof(classes));
+    dfa->n_classes = n_classes;
+    dfa->n_states = n_dfa;
+    dfa->next = out;
+    dfa->accepting = accepting;
+  }
+  return n_dfa * n_classes + n_dfa;
+}
+} // namespace
+
+static constexpr char const mismatch_prefix[] = "does not match `";
+
+// bytes of the compiled `pattern`, its tables and its error message, or 0 if
+// the pattern is invalid
+static auto pattern_size(argparse_pattern const& pattern) -> std::size_t {
+  pattern_compiler compiler{pattern.regex};
+  std::size_t size = compiler.compile(nullptr, nullptr);
+  if (compiler.error != nullptr) {
+    return 0;
+  }
+  return size + sizeof(mismatch_prefix) + std::strlen(pattern.regex) + 1;
+}
+
+auto argparse_patterns_storage_size(
+    std::size_t n_options,
+    argparse_pattern const* patterns,
+    std::size_t n_patterns) noexcept -> std::size_t {
+  std::size_t size = n_options * sizeof(argparse_dfa const*) +
+                     n_patterns * sizeof(argparse_dfa);
+  for (std::size_t i = 0; i < n_patterns; ++i) {
+    size += pattern_size(patterns[i]);
+  }
+  return size;
+}
+
+auto argparse_index_match(
+    argparse_index* index,
+    argparse_pattern const* patterns,
+    std::size_t n_patterns,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool {
+  std::size_t used = index->len * sizeof(argparse_dfa const*) +
+                     n_patterns * sizeof(argparse_dfa);
+  if (storage_size < used) {
+    return false;
+  }
+  auto* compiled = static_cast<argparse_dfa const**>(storage);
+  auto* dfas = reinterpret_cast<argparse_dfa*>(compiled + index->len);
+  auto* bytes = reinterpret_cast<std::uint8_t*>(dfas + n_patterns);
+  std::fill(compiled, compiled + index->len, nullptr);
+  std::size_t offset = 0;
+
+  for (std::size_t i = 0; i < n_patterns; ++i) {
+    auto const& pattern = patterns[i];
+    bool negated = false;
+    auto const* option = argparse_find_long(
+        index->options,
+        index->len,
+        index,
+        pattern.name,
+        std::strlen(pattern.name),
+        &negated);
+    if (option == nullptr || negated) {
+      std::fprintf(
+          stderr, "error: pattern on unknown option `--%s`\n", pattern.name);
+      return false;
+    }
+    if (option->type != _argparse::argparse_option_type::ARGPARSE_OPT_STRING &&
+        (option->type != _argparse::argparse_option_type::ARGPARSE_OPT_CUSTOM ||
+         option->placeholder == nullptr)) {
+      std::fprintf(
+          stderr,
+          "error: pattern on option `--%s`, which takes no string\n",
+          pattern.name);
+      return false;
+    }
+
+    pattern_compiler compiler{pattern.regex};
+    std::size_t size = compiler.compile(nullptr, nullptr);
+    if (compiler.error != nullptr) {
+      std::fprintf(
+          stderr,
+          "error: pattern `%s` of option `--%s` %s\n",
+          pattern.regex,
+          pattern.name,
+          compiler.error);
+      return false;
+    }
+    std::size_t message_size =
+        sizeof(mismatch_prefix) + std::strlen(pattern.regex) + 1;
+    if (storage_size - used < size + message_size) {
+      return false;
+    }
+    used += size + message_size;
+
+    auto& dfa = dfas[i];
+    pattern_compiler{pattern.regex}.compile(&dfa, bytes + offset);
+    auto* error = reinterpret_cast<char*>(bytes + offset + size);
+    std::snprintf(
+        error, message_size, "%s%s`", mismatch_prefix, pattern.regex);
+    dfa.error = error;
+    offset += size + message_size;
+    compiled[option - index->options] = &dfa;
+  }
+
+  index->patterns = compiled;
+  return true;
+}
+
+} // namespace veg
@@ -0,0 +1,250 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include "argparse_pattern.hpp"
+#include "argparse_reload.hpp"
+
+namespace veg {
+
+// each slot holds the epoch at which it was unpublished, the config and the
+// config file text, each part aligned for `std::max_align_t`
+static auto align_up(std::size_t size) -> std::size_t {
+  std::size_t const a = alignof(std::max_align_t);
+  return (size + a - 1) / a * a;
+}
+
+static auto slot_size(std::size_t config_size, std::size_t text_size)
+    -> std::size_t {
+  return align_up(sizeof(std::uint64_t)) + align_up(config_size) +
+         align_up(text_size);
+}
+
+static auto slot_retired(argparse_reload const* self, std::size_t i)
+    -> std::uint64_t* {
+  return reinterpret_cast<std::uint64_t*>(self->slots + i * self->slot_size);
+}
+
+static auto slot_config(argparse_reload const* self, std::size_t i) -> char* {
+  return self->slots + i * self->slot_size + align_up(sizeof(std::uint64_t));
+}
+
+static auto slot_text(argparse_reload const* self, std::size_t i) -> char* {
+  return slot_config(self, i) + align_up(self->config_size);
+}
+
+auto argparse_reload_storage_size(
+    std::size_t config_size,
+    std::size_t text_size,
+    std::size_t n_slots) noexcept -> std::size_t {
+  return n_slots * slot_size(config_size, text_size);
+}
+
+auto argparse_reload_init(
+    argparse_reload* self,
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    void const* prototype,
+    std::size_t config_size,
+    std::size_t text_size,
+    argparse_reload_reader* readers,
+    std::size_t n_readers,
+    void* storage,
+    std::size_t storage_size) noexcept -> bool {
+  std::size_t size = slot_size(config_size, text_size);
+  if (text_size == 0 || storage_size / size < 2) {
+    return false;
+  }
+  self->options = options;
+  self->n_options = n_options;
+  self->index = index;
+  self->prototype = static_cast<char const*>(prototype);
+  self->config_size = config_size;
+  self->text_size = text_size;
+  self->slots = static_cast<char*>(storage);
+  self->slot_size = size;
+  self->n_slots = storage_size / size;
+  self->readers = readers;
+  self->n_readers = n_readers;
+  self->error_line = 0;
+  for (std::size_t i = 0; i < self->n_slots; ++i) {
+    *slot_retired(self, i) = 0;
+  }
+
+  std::memcpy(slot_config(self, 0), self->prototype, config_size);
+  self->current.store(slot_config(self, 0), std::memory_order_release);
+  return true;
+}
+
+// a slot is free once every online reader went through a quiescent state
+// since the slot was unpublished
+static auto find_free_slot(argparse_reload const* self) -> std::size_t {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::uint64_t min_epoch = std::numeric_limits<std::uint64_t>::max();
+  for (std::size_t i = 0; i < self->n_readers; ++i) {
+    std::uint64_t epoch =
+        self->readers[i].epoch.load(std::memory_order_seq_cst);
+    if (epoch != 0 && epoch < min_epoch) {
+      min_epoch = epoch;
+    }
+  }
+
+  void const* current = self->current.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < self->n_slots; ++i) {
+    if (slot_config(self, i) != current &&
+        *slot_retired(self, i) <= min_epoch) {
+      return i;
+    }
+  }
+  return self->n_slots;
+}
+
+static auto read_file(char const* path, char* text, std::size_t text_size)
+    -> char const* {
+  std::FILE* file = std::fopen(path, "r");
+  if (file == nullptr) {
+    return std::strerror(errno);
+  }
+  std::size_t len = std::fread(text, 1, text_size, file);
+  bool failed = std::ferror(file) != 0;
+  std::fclose(file);
+  if (failed) {
+    return "cannot read the config file";
+  }
+  if (len == text_size) {
+    return "config file is too large";
+  }
+  text[len] = '\0';
+  return nullptr;
+}
+
+// applies a single `name[=value]` line to the slot at `config`
+static auto apply_line(argparse_reload const* self, char* line, char* config)
+    -> char const* {
+  while (*line == ' ' || *line == '\t') {
+    ++line;
+  }
+  std::size_t len = std::strlen(line);
+  while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ' ||
+                     line[len - 1] == '\t')) {
+    line[--len] = '\0';
+  }
+  if (len == 0 || line[0] == '#') {
+    return nullptr;
+  }
+  while (*line == '-') {
+    ++line;
+  }
+
+  char* value = std::strchr(line, '=');
+  std::size_t name_len = value != nullptr ? std::size_t(value - line)
+                                          : std::strlen(line);
+  bool negated = false;
+  auto const* option = argparse_find_long(
+      self->options, self->n_options, self->index, line, name_len, &negated);
+  if (option == nullptr) {
+    return "unknown option";
+  }
+  auto const* target = static_cast<char const*>(option->value);
+  if (target < self->prototype ||
+      target >= self->prototype + self->config_size) {
+    return "option is not reloadable";
+  }
+
+  char const* arg = nullptr;
+  if (argparse_placeholder(option) == nullptr) {
+    if (value != nullptr) {
+      return "flag does not take a value";
+    }
+    arg = negated ? "0" : "1";
+  } else if (value == nullptr) {
+    return "option requires a value";
+  } else {
+    arg = value + 1;
+  }
+
+  // the pattern is attached to the option of the table, not to its copy
+  if (self->index != nullptr && self->index->patterns != nullptr) {
+    char const* reason =
+        argparse_index_check(self->index, option, arg, std::strlen(arg));
+    if (reason != nullptr) {
+      return reason;
+    }
+  }
+  argparse_option rebased = *option;
+  rebased.value = config + (target - self->prototype);
+  return argparse_set_value(&rebased, arg);
+}
+
+auto argparse_reload_file(argparse_reload* self, char const* path)
+    -> char const* {
+  self->error_line = 0;
+  std::size_t i = find_free_slot(self);
+  if (i == self->n_slots) {
+    return "all the snapshots are still in use";
+  }
+  char* config = slot_config(self, i);
+  char* text = slot_text(self, i);
+  char const* reason = read_file(path, text, self->text_size);
+  if (reason != nullptr) {
+    return reason;
+  }
+
+  std::memcpy(config, self->prototype, self->config_size);
+  std::size_t line_number = 0;
+  for (char* line = text; line != nullptr;) {
+    char* next = std::strchr(line, '\n');
+    if (next != nullptr) {
+      *next++ = '\0';
+    }
+    ++line_number;
+    reason = apply_line(self, line, config);
+    if (reason != nullptr) {
+      self->error_line = line_number;
+      return reason;
+    }
+    line = next;
+  }
+
+  auto const* previous = static_cast<char const*>(
+      self->current.exchange(config, std::memory_order_acq_rel));
+  std::uint64_t epoch = self->epoch.fetch_add(1, std::memory_order_acq_rel);
+  *slot_retired(self, std::size_t(previous - self->slots) / self->slot_size) =
+      epoch + 1;
+  return nullptr;
+}
+
+auto argparse_reload_poll(argparse_reload* self, char const* path)
+    -> char const* {
+  if (self->pending.exchange(0, std::memory_order_relaxed) == 0) {
+    return nullptr;
+  }
+  return argparse_reload_file(self, path);
+}
+
+static std::atomic<argparse_reload*> signal_reload{nullptr};
+
+static void reload_signal_handler(int signo) {
+  (void)signo;
+  argparse_reload* self = signal_reload.load(std::memory_order_relaxed);
+  if (self != nullptr) {
+    argparse_reload_request(self);
+  }
+}
+
+auto argparse_reload_on_signal(argparse_reload* self, int signo) noexcept
+    -> bool {
+  signal_reload.store(self, std::memory_order_relaxed);
+  return std::signal(signo, reload_signal_handler) != SIG_ERR;
+}
+
+} // namespace veg
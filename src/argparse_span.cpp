@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2020 sarah k.
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a MIT-style license that can be found
+ * in the LICENSE file.
+ */
+#include "argparse_pattern.hpp"
+#include "argparse_span.hpp"
+
+namespace veg {
+
+using namespace _argparse;
+
+// converts the `size` bytes at `arg` into the target of `option`, once
+// checked against its pattern in `index`
+static auto set_view(
+    argparse_index const* index,
+    argparse_option const* option,
+    char const* arg,
+    std::size_t size) -> char const* {
+  char const* reason = argparse_index_check(index, option, arg, size);
+  if (reason != nullptr) {
+    return reason;
+  }
+  if (option->parse_view != nullptr) {
+    return option->parse_view(option->value, arg, size);
+  }
+  if (option->type == argparse_option_type::ARGPARSE_OPT_CUSTOM) {
+    return "requires a null-terminated argument";
+  }
+  return parse_builtin_view(option->type, option->value, arg, size);
+}
+
+// sets `option` from the value at `value`, or from the next argument if
+// nullptr, and returns nullptr, or the reason of the failure
+static auto take_value(
+    argparse_index const* index,
+    argparse_option const* option,
+    char const* value,
+    std::size_t size,
+    void const* args,
+    argparse_arg_fn get,
+    std::size_t n_args,
+    std::size_t* i) -> char const* {
+  if (value == nullptr) {
+    if (*i + 1 == n_args) {
+      return "requires a value";
+    }
+    argparse_arg next = get(args, ++*i);
+    value = next.data;
+    size = next.size;
+  }
+  if (option->value == nullptr) {
+    return nullptr;
+  }
+  return set_view(index, option, value, size);
+}
+
+static auto set_flag(
+    argparse_index const* index,
+    argparse_option const* option,
+    char const* value) -> char const* {
+  if (option->value == nullptr) {
+    return nullptr;
+  }
+  return argparse_set_value(option, value, index);
+}
+
+auto argparse_parse_span(
+    argparse_option const* options,
+    std::size_t n_options,
+    argparse_index const* index,
+    void const* args,
+    argparse_arg_fn get,
+    std::size_t n_args,
+    std::size_t* rest,
+    int flags) noexcept -> argparse_span_result {
+  argparse_span_result result = {nullptr, 0, 0};
+  auto fail = [&](std::size_t i, char const* reason) {
+    result.error = reason;
+    result.failed = i;
+    return result;
+  };
+  // constrained options given, checked once the arguments are parsed
+  std::uint64_t given = 0;
+  auto done = [&] {
+    char const* reason = argparse_index_violation(index, given).reason;
+    return reason != nullptr ? fail(n_args, reason) : result;
+  };
+  auto unknown = [&](std::size_t i) {
+    if ((flags & ARGPARSE_KEEP_UNKNOWN) == 0) {
+      return false;
+    }
+    rest[result.n_rest++] = i;
+    return true;
+  };
+
+  for (std::size_t i = 0; i < n_args; ++i) {
+    argparse_arg arg = get(args, i);
+    char const* data = arg.data;
+    char const* end = data + arg.size;
+    argparse_arg_kind kind = argparse_arg_kind_of(data, arg.size);
+    if (kind == ARGPARSE_ARG_POSITIONAL) {
+      if ((flags & ARGPARSE_STOP_AT_NON_OPTION) != 0) {
+        for (; i < n_args; ++i) {
+          rest[result.n_rest++] = i;
+        }
+        return done();
+      }
+      rest[result.n_rest++] = i;
+      continue;
+    }
+    if (kind == ARGPARSE_ARG_SEPARATOR) {
+      for (++i; i < n_args; ++i) {
+        rest[result.n_rest++] = i;
+      }
+      return done();
+    }
+
+    // the single option of a long option argument ends it, as the last one of
+    // a cluster does
+    bool is_long = kind == ARGPARSE_ARG_LONG;
+    std::size_t pos = i;
+    for (char const* c = data + (is_long ? 2 : 1); c != nullptr;) {
+      std::size_t size = std::size_t(end - c);
+      argparse_read read =
+          is_long ? argparse_read_long(options, n_options, index, c, size)
+                  : argparse_read_short(options, n_options, index, c, size);
+      if (read.option == nullptr) {
+        if (!unknown(pos)) {
+          return fail(pos, read.error);
+        }
+        break;
+      }
+      if (read.error != nullptr) {
+        return fail(pos, read.error);
+      }
+      given = argparse_index_give(index, read.option, read.negated, given);
+      char const* reason = nullptr;
+      if (argparse_placeholder(read.option) == nullptr) {
+        reason = set_flag(index, read.option, read.value);
+      } else {
+        reason = take_value(
+            index,
+            read.option,
+            read.value,
+            read.value != nullptr ? std::size_t(end - read.value) : 0,
+            args,
+            get,
+            n_args,
+            &i);
+      }
+      if (reason != nullptr) {
+        return fail(pos, reason);
+      }
+      c = read.next;
+    }
+  }
+  return done();
+}
+
+} // namespace veg
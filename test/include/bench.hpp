@@ -0,0 +1,317 @@
+#ifndef ARGPARSE_CXX_BENCH_HPP_7QW3K0RZB
+#define ARGPARSE_CXX_BENCH_HPP_7QW3K0RZB
+
+#include <fmt/core.h>
+#include "argparse.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// synthetic corpora and measurement helpers shared by the benchmarks
+namespace bench {
+
+// splitmix64, so that corpora are identical across runs and platforms
+struct rng {
+  std::uint64_t state;
+  auto next() -> std::uint64_t {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31U);
+  }
+  auto below(std::size_t n) -> std::size_t { return next() % n; }
+};
+
+enum struct corpus_kind {
+  mixed,
+  short_clusters,
+  long_eq,
+  negations,
+  numeric,
+};
+
+constexpr char const* kind_names[] = {
+    "mixed",
+    "short",
+    "long_eq",
+    "neg",
+    "numeric",
+};
+
+enum struct value_kind { boolean, tern, sint, slong, dbl, str, count };
+
+constexpr char short_names[] =
+    "abcdefgijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// option table with `n` options, cycling through the value kinds. the first
+// options get a short name.
+struct table {
+  std::vector<std::string> names;
+  std::unique_ptr<bool[]> bools; // not std::vector<bool>, which packs bits
+  std::vector<veg::ternary> ternaries;
+  std::vector<int> ints;
+  std::vector<long> longs;
+  std::vector<double> doubles;
+  std::vector<char const*> strings;
+  std::vector<veg::argparse_option> options;
+  std::vector<std::uint32_t> index_storage;
+  veg::argparse_index index;
+
+  explicit table(std::size_t n)
+      : bools(new bool[n]()),
+        ternaries(n),
+        ints(n),
+        longs(n),
+        doubles(n),
+        strings(n) {
+    names.reserve(n);
+    options.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      char short_name = i < sizeof(short_names) - 1 ? short_names[i] : '\0';
+      names.push_back(fmt::format("option-{}-{}", kind_of(i), i));
+      char const* name = names.back().c_str();
+      switch (value_kind(kind_of(i))) {
+      case value_kind::boolean:
+        options.emplace_back(&bools[i], short_name, name);
+        break;
+      case value_kind::tern:
+        options.emplace_back(&ternaries[i], short_name, name);
+        break;
+      case value_kind::sint:
+        options.emplace_back(&ints[i], short_name, name);
+        break;
+      case value_kind::slong:
+        options.emplace_back(&longs[i], short_name, name);
+        break;
+      case value_kind::dbl:
+        options.emplace_back(&doubles[i], short_name, name);
+        break;
+      default:
+        options.emplace_back(&strings[i], short_name, name);
+        break;
+      }
+    }
+
+    std::size_t size =
+        veg::argparse_index_storage_size(options.data(), options.size());
+    index_storage.resize((size + 3) / 4);
+    veg::argparse_index_build(
+        &index, options.data(), options.size(), index_storage.data(), size);
+  }
+
+  static auto kind_of(std::size_t i) -> std::size_t {
+    return i % std::size_t(value_kind::count);
+  }
+  auto flag(std::size_t i) const -> bool {
+    return kind_of(i) == std::size_t(value_kind::boolean) ||
+           kind_of(i) == std::size_t(value_kind::tern);
+  }
+};
+
+// synthetic argv, `n_tokens` arguments after argv[0]
+struct corpus {
+  std::vector<std::string> tokens;
+  std::vector<char*> argv;
+
+  corpus(table const& t, corpus_kind kind, std::size_t n_tokens, rng& gen) {
+    std::size_t n = t.options.size();
+    std::size_t n_short = std::min(n, sizeof(short_names) - 1);
+    tokens.emplace_back("bench");
+
+    auto value = [&](std::size_t i) -> std::string {
+      switch (value_kind(table::kind_of(i))) {
+      case value_kind::sint:
+      case value_kind::slong:
+        return std::to_string(gen.below(1000000));
+      case value_kind::dbl:
+        return fmt::format("{}.{}", gen.below(1000), gen.below(1000));
+      default:
+        return fmt::format("value{}", gen.below(1000));
+      }
+    };
+    auto pick = [&](bool flag, std::size_t range) {
+      for (;;) {
+        std::size_t i = gen.below(range);
+        if (t.flag(i) == flag) {
+          return i;
+        }
+      }
+    };
+
+    std::vector<std::string> group;
+    for (;;) {
+      group.clear();
+      corpus_kind k = kind;
+      if (k == corpus_kind::mixed) {
+        k = corpus_kind(1 + gen.below(4));
+      }
+      std::size_t i = 0;
+      switch (k) {
+      case corpus_kind::short_clusters: {
+        std::string cluster = "-";
+        std::size_t len = 1 + gen.below(4);
+        for (std::size_t j = 0; j < len; ++j) {
+          cluster += t.options[pick(true, n_short)].short_name;
+        }
+        group.push_back(cluster);
+        break;
+      }
+      case corpus_kind::long_eq:
+        i = gen.below(n);
+        if (t.flag(i)) {
+          group.push_back("--" + t.names[i]);
+        } else {
+          group.push_back("--" + t.names[i] + "=" + value(i));
+        }
+        break;
+      case corpus_kind::negations:
+        group.push_back("--no-" + t.names[pick(true, n)]);
+        break;
+      default:
+        i = pick(false, n);
+        group.push_back("--" + t.names[i]);
+        group.push_back(value(i));
+        break;
+      }
+      if (tokens.size() + group.size() > n_tokens + 1) {
+        break;
+      }
+      tokens.insert(tokens.end(), group.begin(), group.end());
+    }
+    // an option and its value did not fit, pad with positional arguments
+    tokens.resize(n_tokens + 1, "positional");
+
+    for (auto& token : tokens) {
+      argv.push_back(&token[0]);
+    }
+    argv.push_back(nullptr);
+  }
+};
+
+struct perf_counters {
+  enum { instructions, cache_misses, n_counters };
+  int fds[n_counters] = {-1, -1};
+
+  perf_counters() {
+#ifdef __linux__
+    std::uint64_t configs[n_counters] = {
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+    };
+    for (int i = 0; i < n_counters; ++i) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[i];
+      attr.disabled = i == 0 ? 1 : 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      fds[i] = static_cast<int>(
+          syscall(SYS_perf_event_open, &attr, 0, -1, fds[0], 0));
+      if (fds[i] < 0) {
+        close_all();
+        return;
+      }
+    }
+#endif
+  }
+  perf_counters(perf_counters const&) = delete;
+  auto operator=(perf_counters const&) -> perf_counters& = delete;
+  ~perf_counters() { close_all(); }
+
+  void close_all() {
+#ifdef __linux__
+    for (int& fd : fds) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      fd = -1;
+    }
+#endif
+  }
+
+  auto available() const -> bool { return fds[0] >= 0; }
+
+  void start() {
+#ifdef __linux__
+    if (available()) {
+      ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+
+  void stop(std::uint64_t (&out)[n_counters]) {
+    out[0] = out[1] = 0;
+#ifdef __linux__
+    if (available()) {
+      ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+      std::uint64_t buf[1 + n_counters] = {};
+      if (::read(fds[0], buf, sizeof(buf)) == sizeof(buf)) {
+        out[0] = buf[1];
+        out[1] = buf[2];
+      }
+    }
+#endif
+  }
+};
+
+struct result {
+  double ns_per_token;
+  double instructions_per_token;
+  double misses_per_token;
+};
+
+template <typename Parse>
+auto measure(
+    corpus const& c, double min_time_ms, perf_counters& counters, Parse parse)
+    -> result {
+  using clock = std::chrono::steady_clock;
+  std::vector<char*> argv(c.argv.size());
+  std::size_t n_tokens = c.argv.size() - 2;
+
+  auto run = [&](std::size_t iters) {
+    for (std::size_t k = 0; k < iters; ++k) {
+      std::memcpy(argv.data(), c.argv.data(), argv.size() * sizeof(char*));
+      int argc = static_cast<int>(argv.size() - 1);
+      parse(&argc, argv.data());
+    }
+  };
+
+  run(1);
+  std::size_t iters = 1;
+  for (;;) {
+    std::uint64_t counts[perf_counters::n_counters];
+    counters.start();
+    auto begin = clock::now();
+    run(iters);
+    auto elapsed =
+        std::chrono::duration<double, std::milli>(clock::now() - begin);
+    counters.stop(counts);
+    if (elapsed.count() >= min_time_ms) {
+      double n = double(iters) * double(n_tokens);
+      return {
+          elapsed.count() * 1e6 / n,
+          double(counts[0]) / n,
+          double(counts[1]) / n,
+      };
+    }
+    iters *= 2;
+  }
+}
+
+} // namespace bench
+
+#endif /* end of include guard ARGPARSE_CXX_BENCH_HPP_7QW3K0RZB */
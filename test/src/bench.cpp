@@ -0,0 +1,159 @@
+#include "bench.hpp"
+#include <cstdio>
+#include <map>
+
+using namespace bench;
+
+namespace {
+
+auto read_baseline(char const* path) -> std::map<std::string, double> {
+  std::map<std::string, double> baseline;
+  std::FILE* file = std::fopen(path, "r");
+  if (file == nullptr) {
+    std::fprintf(stderr, "error: cannot open baseline `%s`\n", path);
+    std::exit(1);
+  }
+  char name[256];
+  double ns = 0;
+  while (std::fscanf(file, "%255s %lf", name, &ns) == 2) {
+    baseline[name] = ns;
+  }
+  std::fclose(file);
+  return baseline;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int {
+  char const* filter = nullptr;
+  char const* baseline_path = nullptr;
+  char const* save_path = nullptr;
+  double max_slowdown = 1.25;
+  double min_time_ms = 20;
+  long long unsigned seed = 42;
+
+  char const* usage[] = {"bench [options]"};
+  veg::argparse_option options[] = {
+      veg::help,
+      {&filter, 'f', "filter", "only run cases containing this string"},
+      {&min_time_ms, "min-time", "minimum measurement time per case, in ms"},
+      {&seed, "seed", "corpus generator seed"},
+      "Regression mode",
+      {&baseline_path, 'b', "baseline", "compare against this baseline file"},
+      {&max_slowdown,
+       "max-slowdown",
+       "fail if a case is slower than baseline times this ratio"},
+      {&save_path, "save-baseline", "write the results to this file"},
+  };
+  veg::parse_args(
+      &argc,
+      argv,
+      options,
+      usage,
+      "micro-benchmarks of the parse engine on synthetic corpora");
+
+  // an empty baseline is given by the `bench_regression` test when no baseline
+  // is configured, 77 makes ctest report it as skipped
+  if (baseline_path != nullptr && *baseline_path == '\0') {
+    fmt::print("no baseline given, skipping the regression test\n");
+    return 77;
+  }
+  std::map<std::string, double> baseline;
+  if (baseline_path != nullptr) {
+    baseline = read_baseline(baseline_path);
+  }
+  std::FILE* save = nullptr;
+  if (save_path != nullptr) {
+    save = std::fopen(save_path, "w");
+    if (save == nullptr) {
+      std::fprintf(stderr, "error: cannot write baseline `%s`\n", save_path);
+      return 1;
+    }
+  }
+
+  perf_counters counters;
+  if (!counters.available()) {
+    fmt::print("hardware counters unavailable, reporting time only\n");
+  }
+  fmt::print(
+      "{:<32} {:>10} {:>12} {:>12} {:>10}\n",
+      "case",
+      "ns/token",
+      "instr/token",
+      "miss/token",
+      "vs base");
+
+  char const* usages[] = {"bench"};
+  bool failed = false;
+  std::size_t const table_sizes[] = {10, 100, 1000, 10000};
+  std::size_t const argv_lengths[] = {16, 256};
+
+  for (std::size_t n_options : table_sizes) {
+    table t(n_options);
+    for (std::size_t kind = 0; kind < 5; ++kind) {
+      for (std::size_t n_tokens : argv_lengths) {
+        rng gen{seed};
+        corpus c(t, corpus_kind(kind), n_tokens, gen);
+
+        for (int indexed = 0; indexed < 2; ++indexed) {
+          std::string name = fmt::format(
+              "{}/{}/{}/{}",
+              kind_names[kind],
+              n_options,
+              n_tokens,
+              indexed != 0 ? "index" : "linear");
+          if (filter != nullptr &&
+              name.find(filter) == std::string::npos) {
+            continue;
+          }
+
+          result r =
+              measure(c, min_time_ms, counters, [&](int* ac, char** av) {
+                if (indexed != 0) {
+                  veg::parse_args(ac, av, t.index, usages);
+                } else {
+                  veg::parse_args(
+                      ac, av, t.options.data(), t.options.size(), usages, 1);
+                }
+              });
+
+          std::string ratio = "-";
+          auto it = baseline.find(name);
+          if (it != baseline.end() && it->second > 0) {
+            double slowdown = r.ns_per_token / it->second;
+            ratio = fmt::format("{:.2f}", slowdown);
+            if (slowdown > max_slowdown) {
+              ratio += " FAIL";
+              failed = true;
+            }
+          }
+          if (counters.available()) {
+            fmt::print(
+                "{:<32} {:>10.2f} {:>12.1f} {:>12.3f} {:>10}\n",
+                name,
+                r.ns_per_token,
+                r.instructions_per_token,
+                r.misses_per_token,
+                ratio);
+          } else {
+            fmt::print(
+                "{:<32} {:>10.2f} {:>12} {:>12} {:>10}\n",
+                name,
+                r.ns_per_token,
+                "-",
+                "-",
+                ratio);
+          }
+          if (save != nullptr) {
+            std::fprintf(save, "%s %f\n", name.c_str(), r.ns_per_token);
+          }
+        }
+      }
+    }
+  }
+
+  if (save != nullptr) {
+    std::fclose(save);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,38 @@
+// built with -DCASE=<n> by the choices_fail_<n> tests. case 0 compiles, the
+// other ones must fail to, in the constant evaluation of `make_choices`
+#include "argparse_choices.hpp"
+
+enum struct mode { fast, safe };
+
+#if CASE == 1
+// duplicate names
+constexpr veg::argparse_choice<mode> names[] = {
+    {"fast", mode::fast},
+    {"fast", mode::safe},
+};
+constexpr auto modes = veg::make_choices(names);
+#elif CASE == 2
+// names equal once their case is folded
+constexpr veg::argparse_choice<mode> names[] = {
+    {"fast", mode::fast},
+    {"Fast", mode::safe},
+};
+constexpr auto modes = veg::make_choices(names, true);
+#elif CASE == 3
+// no seed to try
+constexpr veg::argparse_choice<mode> names[] = {
+    {"fast", mode::fast},
+    {"safe", mode::safe},
+};
+constexpr auto modes = veg::make_choices(names, false, 0);
+#else
+constexpr veg::argparse_choice<mode> names[] = {
+    {"fast", mode::fast},
+    {"Fast", mode::safe},
+};
+constexpr auto modes = veg::make_choices(names);
+#endif
+
+auto main() -> int {
+  return int(modes.seed);
+}
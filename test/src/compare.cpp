@@ -0,0 +1,394 @@
+#include "bench.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+#if __has_include(<elf.h>)
+#include <elf.h>
+#endif
+#if __has_include(<getopt.h>)
+#include <getopt.h>
+#define COMPARE_HAS_GETOPT
+#endif
+#if __has_include(<cxxopts.hpp>)
+#include <cxxopts.hpp>
+#define COMPARE_HAS_CXXOPTS
+#endif
+#if __has_include(<CLI/CLI.hpp>)
+#include <CLI/CLI.hpp>
+#define COMPARE_HAS_CLI11
+#endif
+
+using namespace bench;
+
+namespace {
+
+// none of the other parsers support ternary options or `--no-` negations, so
+// ternary options are parsed as booleans and the comparison only uses the
+// corpora without negations
+constexpr corpus_kind compared_kinds[] = {
+    corpus_kind::short_clusters,
+    corpus_kind::long_eq,
+    corpus_kind::numeric,
+};
+
+#ifdef COMPARE_HAS_GETOPT
+struct getopt_parser {
+  table& t;
+  std::vector<std::string> negated_names;
+  std::vector<::option> long_options;
+  std::string short_options;
+  int short_index[256] = {};
+
+  explicit getopt_parser(table& tab) : t{tab} {
+    std::size_t n = t.options.size();
+    negated_names.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      bool flag = t.flag(i);
+      int has_arg = flag ? no_argument : required_argument;
+      long_options.push_back(
+          {t.names[i].c_str(), has_arg, nullptr, int(256 + i)});
+      if (flag) {
+        negated_names.push_back("no-" + t.names[i]);
+        long_options.push_back({
+            negated_names.back().c_str(),
+            no_argument,
+            nullptr,
+            int(256 + n + i),
+        });
+      }
+      char short_name = t.options[i].short_name;
+      if (short_name != '\0') {
+        short_options += short_name;
+        if (!flag) {
+          short_options += ':';
+        }
+        short_index[static_cast<unsigned char>(short_name)] = int(i);
+      }
+    }
+    long_options.push_back({nullptr, 0, nullptr, 0});
+  }
+
+  void parse(int* argc, char** argv) {
+    int n = int(t.options.size());
+    optind = 0; // reinitializes glibc's getopt
+    opterr = 0;
+    int c = 0;
+    while ((c = getopt_long(
+                *argc,
+                argv,
+                short_options.c_str(),
+                long_options.data(),
+                nullptr)) != -1) {
+      bool negated = c >= 256 + n;
+      std::size_t i = std::size_t(
+          c >= 256 + n ? c - 256 - n : c >= 256 ? c - 256 : short_index[c]);
+      switch (value_kind(table::kind_of(i))) {
+      case value_kind::boolean:
+        t.bools[i] = !negated;
+        break;
+      case value_kind::tern:
+        t.ternaries[i] = negated ? veg::ternary::no : veg::ternary::yes;
+        break;
+      case value_kind::sint:
+        t.ints[i] = int(std::strtol(optarg, nullptr, 0));
+        break;
+      case value_kind::slong:
+        t.longs[i] = std::strtol(optarg, nullptr, 0);
+        break;
+      case value_kind::dbl:
+        t.doubles[i] = std::strtod(optarg, nullptr);
+        break;
+      default:
+        t.strings[i] = optarg;
+        break;
+      }
+    }
+  }
+};
+#endif
+
+#ifdef COMPARE_HAS_CXXOPTS
+struct cxxopts_parser {
+  std::unique_ptr<bool[]> ternaries;
+  std::vector<std::string> strings;
+  cxxopts::Options options{"compare"};
+
+  explicit cxxopts_parser(table& t)
+      : ternaries(new bool[t.options.size()]()),
+        strings(t.options.size()) {
+    auto add = options.add_options();
+    for (std::size_t i = 0; i < t.options.size(); ++i) {
+      char short_name = t.options[i].short_name;
+      std::string spec = short_name != '\0'
+                             ? std::string(1, short_name) + "," + t.names[i]
+                             : t.names[i];
+      switch (value_kind(table::kind_of(i))) {
+      case value_kind::boolean:
+        add(spec, "", cxxopts::value(t.bools[i]));
+        break;
+      case value_kind::tern:
+        add(spec, "", cxxopts::value(ternaries[i]));
+        break;
+      case value_kind::sint:
+        add(spec, "", cxxopts::value(t.ints[i]));
+        break;
+      case value_kind::slong:
+        add(spec, "", cxxopts::value(t.longs[i]));
+        break;
+      case value_kind::dbl:
+        add(spec, "", cxxopts::value(t.doubles[i]));
+        break;
+      default:
+        add(spec, "", cxxopts::value(strings[i]));
+        break;
+      }
+    }
+  }
+
+  void parse(int* argc, char** argv) { options.parse(*argc, argv); }
+};
+#endif
+
+#ifdef COMPARE_HAS_CLI11
+struct cli11_parser {
+  std::unique_ptr<bool[]> ternaries;
+  std::vector<std::string> strings;
+  CLI::App app{"compare"};
+
+  explicit cli11_parser(table& t)
+      : ternaries(new bool[t.options.size()]()),
+        strings(t.options.size()) {
+    app.allow_extras();
+    for (std::size_t i = 0; i < t.options.size(); ++i) {
+      char short_name = t.options[i].short_name;
+      std::string spec = "--" + t.names[i];
+      if (short_name != '\0') {
+        spec = std::string("-") + short_name + "," + spec;
+      }
+      switch (value_kind(table::kind_of(i))) {
+      case value_kind::boolean:
+        app.add_flag(spec, t.bools[i]);
+        break;
+      case value_kind::tern:
+        app.add_flag(spec, ternaries[i]);
+        break;
+      case value_kind::sint:
+        app.add_option(spec, t.ints[i]);
+        break;
+      case value_kind::slong:
+        app.add_option(spec, t.longs[i]);
+        break;
+      case value_kind::dbl:
+        app.add_option(spec, t.doubles[i]);
+        break;
+      default:
+        app.add_option(spec, strings[i]);
+        break;
+      }
+    }
+  }
+
+  void parse(int* argc, char** argv) {
+    app.clear();
+    app.parse(*argc, argv);
+  }
+};
+#endif
+
+// binaries built from compare_size.cpp, in COMPARE_PARSER order
+struct size_probe {
+  char const* parser;
+  char const* binary;
+};
+
+constexpr size_probe size_probes[] = {
+#ifdef COMPARE_SIZE_NONE
+    {"none", COMPARE_SIZE_NONE},
+    {"veg", COMPARE_SIZE_VEG},
+    {"getopt_long", COMPARE_SIZE_GETOPT},
+    {"cxxopts", COMPARE_SIZE_CXXOPTS},
+    {"cli11", COMPARE_SIZE_CLI11},
+#else
+    {"none", nullptr},
+#endif
+};
+
+// size of the sections loaded in memory, as reported by `size`, falls back to
+// the file size for non-ELF binaries
+auto binary_size(char const* path) -> long long {
+  if (path == nullptr) {
+    return -1;
+  }
+  std::FILE* file = std::fopen(path, "rb");
+  if (file == nullptr) {
+    return -1;
+  }
+  long long size = -1;
+#if __has_include(<elf.h>)
+  Elf64_Ehdr header = {};
+  if (std::fread(&header, sizeof(header), 1, file) == 1 &&
+      std::memcmp(header.e_ident, ELFMAG, SELFMAG) == 0 &&
+      header.e_ident[EI_CLASS] == ELFCLASS64) {
+    size = 0;
+    for (unsigned i = 0; i < header.e_shnum; ++i) {
+      Elf64_Shdr section = {};
+      if (std::fseek(
+              file, long(header.e_shoff + i * header.e_shentsize), SEEK_SET) !=
+              0 ||
+          std::fread(&section, sizeof(section), 1, file) != 1) {
+        size = -1;
+        break;
+      }
+      if ((section.sh_flags & SHF_ALLOC) != 0) {
+        size += static_cast<long long>(section.sh_size);
+      }
+    }
+  }
+#endif
+  if (size < 0 && std::fseek(file, 0, SEEK_END) == 0) {
+    size = std::ftell(file);
+  }
+  std::fclose(file);
+  return size;
+}
+
+// compiles compare_size.cpp for the given parser, returns the fastest of
+// `runs` compilations in ms, or a negative value on failure
+auto compile_time_ms(int parser, int runs) -> double {
+#if defined(COMPARE_CXX) && defined(COMPARE_FLAGS) && defined(COMPARE_SOURCE)
+  std::string command = fmt::format(
+      "\"{}\" @\"{}\" -DCOMPARE_PARSER={} -c \"{}\" -o compare_size_tmp.o",
+      COMPARE_CXX,
+      COMPARE_FLAGS,
+      parser,
+      COMPARE_SOURCE);
+  double best = -1;
+  for (int k = 0; k < runs; ++k) {
+    auto begin = std::chrono::steady_clock::now();
+    if (std::system(command.c_str()) != 0) {
+      return -1;
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - begin)
+                         .count();
+    if (best < 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  std::remove("compare_size_tmp.o");
+  return best;
+#else
+  (void)parser;
+  (void)runs;
+  return -1;
+#endif
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int {
+  char const* filter = nullptr;
+  double min_time_ms = 20;
+  long long unsigned seed = 42;
+  int compile_runs = 3;
+
+  char const* usage[] = {"compare [options]"};
+  veg::argparse_option options[] = {
+      veg::help,
+      {&filter, 'f', "filter", "only run cases containing this string"},
+      {&min_time_ms, "min-time", "minimum measurement time per case, in ms"},
+      {&seed, "seed", "corpus generator seed"},
+      {&compile_runs,
+       "compile-runs",
+       "compilations per parser when timing builds, 0 to skip"},
+  };
+  veg::parse_args(
+      &argc,
+      argv,
+      options,
+      usage,
+      "compares the parse engine against other command line parsers");
+
+  perf_counters counters;
+  char const* usages[] = {"compare"};
+  std::size_t const table_sizes[] = {10, 100, 1000};
+  std::size_t const n_tokens = 64;
+
+  fmt::print("{:<24} {:<12} {:>10}\n", "case", "parser", "ns/token");
+  for (std::size_t n_options : table_sizes) {
+    table t(n_options);
+#ifdef COMPARE_HAS_GETOPT
+    getopt_parser getopt_p(t);
+#endif
+#ifdef COMPARE_HAS_CXXOPTS
+    cxxopts_parser cxxopts_p(t);
+#endif
+#ifdef COMPARE_HAS_CLI11
+    cli11_parser cli11_p(t);
+#endif
+
+    for (corpus_kind kind : compared_kinds) {
+      rng gen{seed};
+      corpus c(t, kind, n_tokens, gen);
+      std::string name =
+          fmt::format("{}/{}/{}", kind_names[int(kind)], n_options, n_tokens);
+      if (filter != nullptr && name.find(filter) == std::string::npos) {
+        continue;
+      }
+
+      auto report = [&](char const* parser, result r) {
+        fmt::print("{:<24} {:<12} {:>10.2f}\n", name, parser, r.ns_per_token);
+      };
+      report(
+          "veg",
+          measure(c, min_time_ms, counters, [&](int* ac, char** av) {
+            veg::parse_args(
+                ac, av, t.options.data(), t.options.size(), usages, 1);
+          }));
+      report(
+          "veg/index",
+          measure(c, min_time_ms, counters, [&](int* ac, char** av) {
+            veg::parse_args(ac, av, t.index, usages);
+          }));
+#ifdef COMPARE_HAS_GETOPT
+      report(
+          "getopt_long",
+          measure(c, min_time_ms, counters, [&](int* ac, char** av) {
+            getopt_p.parse(ac, av);
+          }));
+#endif
+#ifdef COMPARE_HAS_CXXOPTS
+      report(
+          "cxxopts",
+          measure(c, min_time_ms, counters, [&](int* ac, char** av) {
+            cxxopts_p.parse(ac, av);
+          }));
+#endif
+#ifdef COMPARE_HAS_CLI11
+      report(
+          "cli11",
+          measure(c, min_time_ms, counters, [&](int* ac, char** av) {
+            cli11_p.parse(ac, av);
+          }));
+#endif
+    }
+  }
+
+  fmt::print(
+      "\n{:<12} {:>16} {:>18}\n", "parser", "size delta (B)", "compile (ms)");
+  long long base_size = binary_size(size_probes[0].binary);
+  double base_time = compile_runs > 0 ? compile_time_ms(0, compile_runs) : -1;
+  for (std::size_t i = 1; i < sizeof(size_probes) / sizeof(size_probes[0]);
+       ++i) {
+    long long size = binary_size(size_probes[i].binary);
+    double time =
+        compile_runs > 0 ? compile_time_ms(int(i), compile_runs) : -1;
+    fmt::print(
+        "{:<12} {:>16} {:>18}\n",
+        size_probes[i].parser,
+        size >= 0 && base_size >= 0 ? std::to_string(size - base_size) : "-",
+        time >= 0 && base_time >= 0 ? fmt::format("{:.1f}", time - base_time)
+                                    : "-");
+  }
+  return 0;
+}
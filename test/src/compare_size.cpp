@@ -0,0 +1,93 @@
+// minimal program parsing a fixed option set with a single parser, built once
+// per parser so that `compare` can report each parser's binary size and
+// compile time relative to `COMPARE_PARSER_NONE`
+
+#define COMPARE_PARSER_NONE 0
+#define COMPARE_PARSER_VEG 1
+#define COMPARE_PARSER_GETOPT 2
+#define COMPARE_PARSER_CXXOPTS 3
+#define COMPARE_PARSER_CLI11 4
+
+#include <cstdio>
+#include <cstdlib>
+
+#if COMPARE_PARSER == COMPARE_PARSER_VEG
+#include "argparse.hpp"
+#elif COMPARE_PARSER == COMPARE_PARSER_GETOPT
+#include <getopt.h>
+#elif COMPARE_PARSER == COMPARE_PARSER_CXXOPTS
+#include <cxxopts.hpp>
+#elif COMPARE_PARSER == COMPARE_PARSER_CLI11
+#include <CLI/CLI.hpp>
+#endif
+
+auto main(int argc, char** argv) -> int {
+  bool force = false;
+  int num = 0;
+  double ratio = 0;
+  char const* path = "";
+
+#if COMPARE_PARSER == COMPARE_PARSER_VEG
+  char const* usage[] = {"compare_size [options]"};
+  veg::argparse_option options[] = {
+      veg::help,
+      {&force, 'f', "force", "force to do"},
+      {&num, 'n', "num", "selected num"},
+      {&ratio, "ratio", "selected ratio"},
+      {&path, 'p', "path", "path to read"},
+  };
+  veg::parse_args(&argc, argv, options, usage);
+
+#elif COMPARE_PARSER == COMPARE_PARSER_GETOPT
+  ::option options[] = {
+      {"force", no_argument, nullptr, 'f'},
+      {"num", required_argument, nullptr, 'n'},
+      {"ratio", required_argument, nullptr, 'r'},
+      {"path", required_argument, nullptr, 'p'},
+      {nullptr, 0, nullptr, 0},
+  };
+  int c = 0;
+  while ((c = getopt_long(argc, argv, "fn:p:", options, nullptr)) != -1) {
+    switch (c) {
+    case 'f':
+      force = true;
+      break;
+    case 'n':
+      num = static_cast<int>(std::strtol(optarg, nullptr, 0));
+      break;
+    case 'r':
+      ratio = std::strtod(optarg, nullptr);
+      break;
+    case 'p':
+      path = optarg;
+      break;
+    default:
+      return 1;
+    }
+  }
+
+#elif COMPARE_PARSER == COMPARE_PARSER_CXXOPTS
+  std::string path_str;
+  cxxopts::Options options("compare_size");
+  options.add_options()                                     //
+      ("f,force", "force to do", cxxopts::value(force))     //
+      ("n,num", "selected num", cxxopts::value(num))        //
+      ("ratio", "selected ratio", cxxopts::value(ratio))    //
+      ("p,path", "path to read", cxxopts::value(path_str)); //
+  options.parse(argc, argv);
+  path = path_str.c_str();
+
+#elif COMPARE_PARSER == COMPARE_PARSER_CLI11
+  std::string path_str;
+  CLI::App app{"compare_size"};
+  app.add_flag("-f,--force", force, "force to do");
+  app.add_option("-n,--num", num, "selected num");
+  app.add_option("--ratio", ratio, "selected ratio");
+  app.add_option("-p,--path", path_str, "path to read");
+  CLI11_PARSE(app, argc, argv);
+  path = path_str.c_str();
+#endif
+
+  std::printf("%d %d %g %s\n", int(force), num, ratio, path);
+  return 0;
+}
@@ -0,0 +1,193 @@
+#include <fmt/core.h>
+#include "argparse.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+extern char** environ; // NOLINT
+
+namespace {
+
+// value types cycled through by the generated option tables, so that every
+// type dispatch path is instantiated
+constexpr char const* value_types[] = {
+    "bool",
+    "veg::ternary",
+    "char",
+    "char const*",
+    "signed char",
+    "short",
+    "int",
+    "long",
+    "long long",
+    "unsigned char",
+    "unsigned short",
+    "unsigned",
+    "unsigned long",
+    "unsigned long long",
+    "float",
+    "double",
+    "long double",
+};
+constexpr std::size_t n_value_types = sizeof(value_types) / sizeof(char*);
+
+// translation unit declaring `n_tables` option tables of `n_options` options
+auto generate(std::size_t n_tables, std::size_t n_options) -> std::string {
+  std::string src = "#include \"argparse.hpp\"\n\n";
+  for (std::size_t i = 0; i < n_value_types; ++i) {
+    src += fmt::format(
+        "static {} values_{}[{}];\n",
+        value_types[i],
+        i,
+        1 + n_options / n_value_types);
+  }
+  for (std::size_t t = 0; t < n_tables; ++t) {
+    src += fmt::format("\nveg::argparse_option const table_{}[] = {{\n", t);
+    src += "    veg::help,\n";
+    for (std::size_t i = 0; i < n_options; ++i) {
+      src += fmt::format(
+          "    {{&values_{}[{}], \"option-{}-{}\", \"help\"}},\n",
+          i % n_value_types,
+          i / n_value_types,
+          t,
+          i);
+    }
+    src += "};\n";
+  }
+  src += "\nauto main(int argc, char** argv) -> int {\n"
+         "  char const* usage[] = {\"generated\"};\n";
+  for (std::size_t t = 0; t < n_tables; ++t) {
+    src +=
+        fmt::format("  veg::parse_args(&argc, argv, table_{}, usage);\n", t);
+  }
+  src += "}\n";
+  return src;
+}
+
+struct result {
+  double ms;
+  long max_rss_kb;
+};
+
+// runs the command `runs` times, returns the fastest run and the largest
+// resident set, or a negative time if the command failed
+auto run(std::vector<std::string> const& command, int runs) -> result {
+  std::vector<char*> argv;
+  for (auto const& arg : command) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  result r = {-1, 0};
+  for (int k = 0; k < runs; ++k) {
+    pid_t pid = 0;
+    int status = 0;
+    rusage usage = {};
+    auto begin = std::chrono::steady_clock::now();
+    if (posix_spawn(&pid, argv[0], nullptr, nullptr, argv.data(), environ) !=
+            0 ||
+        wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      return {-1, 0};
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - begin)
+                    .count();
+    r.ms = r.ms < 0 ? ms : std::min(r.ms, ms);
+    r.max_rss_kb = std::max(r.max_rss_kb, long(usage.ru_maxrss));
+  }
+  return r;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int {
+  char const* cxx = nullptr;
+  char const* flags = nullptr;
+  int runs = 3;
+#ifdef COMPILE_TIME_CXX
+  cxx = COMPILE_TIME_CXX;
+  flags = COMPILE_TIME_FLAGS;
+#endif
+
+  char const* usage[] = {"compile_time [options]"};
+  veg::argparse_option options[] = {
+      veg::help,
+      {&cxx, "cxx", "compiler to benchmark"},
+      {&flags, "flags", "response file with the compiler flags"},
+      {&runs, 'r', "runs", "compilations per case, the fastest is reported"},
+  };
+  veg::parse_args(
+      &argc,
+      argv,
+      options,
+      usage,
+      "measures the compile time cost of including the header and declaring "
+      "option tables");
+  if (cxx == nullptr || flags == nullptr) {
+    std::fprintf(stderr, "error: --cxx and --flags are required\n");
+    return 1;
+  }
+
+  struct tu {
+    char const* name;
+    std::size_t n_tables;
+    std::size_t n_options;
+  };
+  tu const cases[] = {
+      {"include", 1, 0},
+      {"table/500", 1, 500},
+      {"tables/20x500", 20, 500},
+  };
+  struct stage {
+    char const* name;
+    std::vector<std::string> args;
+  };
+  stage const stages[] = {
+      {"preprocess", {"-E", "-o", "/dev/null"}},
+      {"syntax", {"-fsyntax-only"}},
+      {"compile", {"-c", "-o", "compile_time_tmp.o"}},
+  };
+
+  fmt::print(
+      "{:<16} {:<12} {:>10} {:>14}\n", "case", "stage", "ms", "max rss (KB)");
+  int status = 0;
+  for (auto const& c : cases) {
+    std::string path = fmt::format("compile_time_{}.cpp", c.n_tables);
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+      std::fprintf(stderr, "error: cannot write `%s`\n", path.c_str());
+      return 1;
+    }
+    std::string src = generate(c.n_tables, c.n_options);
+    std::fwrite(src.data(), 1, src.size(), file);
+    std::fclose(file);
+
+    for (auto const& s : stages) {
+      std::vector<std::string> command = {cxx, std::string("@") + flags};
+      command.insert(command.end(), s.args.begin(), s.args.end());
+      command.push_back(path);
+      result r = run(command, runs);
+      if (r.ms < 0) {
+        std::fprintf(stderr, "error: %s/%s failed\n", c.name, s.name);
+        status = 1;
+        continue;
+      }
+      fmt::print(
+          "{:<16} {:<12} {:>10.1f} {:>14}\n",
+          c.name,
+          s.name,
+          r.ms,
+          r.max_rss_kb);
+    }
+    std::remove(path.c_str());
+  }
+  std::remove("compile_time_tmp.o");
+  return status;
+}
@@ -0,0 +1,111 @@
+// option tables and parse state declared at namespace scope, as documented.
+// compiled on its own by the `constinit` test, which fails if the object file
+// has any dynamic initializer. the variables without ARGPARSE_CONSTINIT are
+// checked by the test only, with the compilers where it expands to nothing
+#include "argparse.hpp"
+#include <cstdint>
+
+namespace {
+
+struct endpoint {
+  char const* host;
+  int port;
+};
+
+} // namespace
+
+namespace veg {
+template <>
+struct option_traits<endpoint> {
+  static constexpr char const* placeholder = "<host:port>";
+  static auto parse(endpoint& out, char const* arg) -> char const* {
+    out.host = arg;
+    return nullptr;
+  }
+};
+} // namespace veg
+
+namespace {
+
+bool force = false;
+veg::ternary color;
+long num = 0;
+double ratio = 1;
+char const* path = nullptr;
+endpoint server = {"localhost", 80};
+std::uint32_t features = 0;
+int verbosity = 0;
+
+ARGPARSE_CONSTINIT veg::argparse_option const options[] = {
+    veg::help,
+    "Basic options",
+    {&force, 'f', "force", "force to do"},
+    {&color, "color", "colorize the output"},
+    {&num, 'n', "num", "selected num"},
+    {&ratio, "ratio"},
+    {&path, 'p', "path", "path to read"},
+    {&server, "server", "server to connect to"},
+    veg::with_flags({&num, "jobs"}, veg::OPT_NONEG),
+    veg::bit<1U << 3U>(&features, "jit", "enable the jit"),
+    veg::counter(&verbosity, 'v', "verbose"),
+};
+
+// no ARGPARSE_CONSTINIT, checked by the test only
+veg::argparse_option const plain_options[] = {
+    veg::help,
+    {&force, 'f', "force"},
+    {&server, "server"},
+};
+
+ARGPARSE_CONSTINIT veg::argparse_index index;
+ARGPARSE_CONSTINIT std::uint32_t index_storage[256];
+ARGPARSE_CONSTINIT std::uint64_t constraints_storage[16];
+
+long cache_size = 64;
+veg::argparse_option const cache_options[] = {
+    "Cache options",
+    {&cache_size, "cache-size", "cache size in MiB"},
+};
+ARGPARSE_MODULE(cache, cache_options);
+
+constexpr veg::argparse_constraint constraints[] = {
+    veg::required("num"),
+    veg::at_most_one("force", "color"),
+    veg::implies("server", "path"),
+};
+
+auto cmd_run(int argc, char** argv) -> int {
+  (void)argv;
+  return argc;
+}
+
+constexpr veg::argparse_command commands_[] = {
+    {"run", cmd_run, "run it"},
+    {"stop", cmd_run, "stop it"},
+};
+ARGPARSE_CONSTINIT auto const commands =
+    veg::argparse_commands<2>{commands_};
+
+} // namespace
+
+// referenced, so that the variables are emitted
+auto constinit_probe(int* argc, char** argv) -> int {
+  char const* const usages[] = {"constinit"};
+  if (veg::argparse_index_build(
+          &index,
+          options,
+          sizeof(options) / sizeof(options[0]),
+          index_storage,
+          sizeof(index_storage)) &&
+      veg::argparse_index_constrain(
+          &index,
+          constraints,
+          3,
+          constraints_storage,
+          sizeof(constraints_storage))) {
+    veg::parse_args(argc, argv, index, usages);
+  } else {
+    veg::parse_args(argc, argv, plain_options, usages);
+  }
+  return veg::run_command(commands, *argc, argv);
+}
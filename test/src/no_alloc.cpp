@@ -0,0 +1,324 @@
+// parsing never allocates: the global allocation functions are replaced, and
+// count the allocations made while a parse is running. malloc and friends are
+// replaced as well with glibc, unless a sanitizer already intercepts them
+#include "doctest.h"
+#include "argparse.hpp"
+#include "argparse_events.hpp"
+#include "argparse_incremental.hpp"
+#include "argparse_span.hpp"
+#include "argparse_std.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) ||    \
+    __has_feature(memory_sanitizer)
+#define NO_ALLOC_SANITIZED
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define NO_ALLOC_SANITIZED
+#endif
+
+namespace {
+
+bool armed = false;
+std::size_t allocations = 0;
+
+void count() {
+  if (armed) {
+    ++allocations;
+  }
+}
+
+// runs `f` and returns the number of allocations it made
+template <typename F>
+auto allocations_of(F f) -> std::size_t {
+  allocations = 0;
+  armed = true;
+  f();
+  armed = false;
+  return allocations;
+}
+
+auto allocate(std::size_t size) -> void* {
+  count();
+  void* ptr = std::malloc(size != 0 ? size : 1);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+auto allocate(std::size_t size, std::align_val_t align) -> void* {
+  count();
+  std::size_t a = static_cast<std::size_t>(align);
+  void* ptr = std::aligned_alloc(a, (size + a - 1) / a * a);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+} // namespace
+
+auto operator new(std::size_t size) -> void* {
+  return allocate(size);
+}
+auto operator new[](std::size_t size) -> void* {
+  return allocate(size);
+}
+auto operator new(std::size_t size, std::align_val_t align) -> void* {
+  return allocate(size, align);
+}
+auto operator new[](std::size_t size, std::align_val_t align) -> void* {
+  return allocate(size, align);
+}
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t /*unused*/) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void* ptr, std::size_t /*unused*/) noexcept {
+  std::free(ptr);
+}
+void operator delete(void* ptr, std::align_val_t /*unused*/) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t /*unused*/) noexcept {
+  std::free(ptr);
+}
+void operator delete(
+    void* ptr, std::size_t /*unused*/, std::align_val_t /*unused*/) noexcept {
+  std::free(ptr);
+}
+void operator delete[](
+    void* ptr, std::size_t /*unused*/, std::align_val_t /*unused*/) noexcept {
+  std::free(ptr);
+}
+
+#if defined(__GLIBC__) && !defined(NO_ALLOC_SANITIZED)
+extern "C" {
+auto __libc_malloc(std::size_t size) -> void*;
+auto __libc_calloc(std::size_t n, std::size_t size) -> void*;
+auto __libc_realloc(void* ptr, std::size_t size) -> void*;
+
+auto malloc(std::size_t size) -> void* {
+  count();
+  return __libc_malloc(size);
+}
+auto calloc(std::size_t n, std::size_t size) -> void* {
+  count();
+  return __libc_calloc(n, size);
+}
+auto realloc(void* ptr, std::size_t size) -> void* {
+  count();
+  return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+namespace {
+
+bool force = false;
+veg::ternary color;
+long num = 0;
+double ratio = 0;
+char letter = 0;
+char const* path = nullptr;
+std::string_view name;
+int verbosity = 0;
+
+veg::argparse_option const options[] = {
+    veg::help,
+    {&force, 'f', "force"},
+    {&color, 'c', "color"},
+    {&num, 'n', "num"},
+    {&ratio, "ratio"},
+    {&letter, 'l', "letter"},
+    {&path, 'p', "path"},
+    {&name, "name"},
+    veg::counter(&verbosity, 'v', "verbose"),
+};
+constexpr std::size_t n_options = sizeof(options) / sizeof(options[0]);
+char const* const usages[] = {"no_alloc"};
+
+std::uint32_t index_storage[512];
+
+auto make_index() -> veg::argparse_index {
+  veg::argparse_index index;
+  REQUIRE(
+      veg::argparse_index_storage_size(options, n_options) <=
+      sizeof(index_storage));
+  REQUIRE(veg::argparse_index_build(
+      &index, options, n_options, index_storage, sizeof(index_storage)));
+  return index;
+}
+
+// mutable copy of a command line, as `main` would get it
+struct command_line {
+  static constexpr std::size_t max_args = 16;
+  char text[512];
+  char* argv[max_args + 1];
+  int argc = 0;
+
+  template <std::size_t n>
+  explicit command_line(char const* const (&args)[n]) {
+    static_assert(n <= max_args, "too many arguments");
+    std::size_t pos = 0;
+    for (char const* arg : args) {
+      std::size_t len = std::strlen(arg) + 1;
+      REQUIRE(pos + len <= sizeof(text));
+      std::memcpy(text + pos, arg, len);
+      argv[argc++] = text + pos;
+      pos += len;
+    }
+    argv[argc] = nullptr;
+  }
+};
+
+char const* const line[] = {
+    "no_alloc",
+    "-fvvn",
+    "3",
+    "input",
+    "--no-color",
+    "--ratio=0.5",
+    "-lx",
+    "--path",
+    "out",
+    "--name=db",
+    "--",
+    "-f",
+};
+
+} // namespace
+
+TEST_CASE("no allocation: parse_args") {
+  command_line linear(line);
+  CHECK(allocations_of([&] {
+          veg::parse_args(
+              &linear.argc, linear.argv, options, n_options, usages, 1);
+        }) == 0);
+  CHECK(linear.argc == 2);
+  CHECK(num == 3);
+
+  veg::argparse_index index = make_index();
+  command_line indexed(line);
+  CHECK(allocations_of([&] {
+          veg::parse_args(&indexed.argc, indexed.argv, index, usages);
+        }) == 0);
+  CHECK(indexed.argc == 2);
+}
+
+TEST_CASE("no allocation: parse_known_args") {
+  char const* const args[] = {
+      "no_alloc", "--unknown=1", "-f", "-x", "--num", "4", "rest"};
+  veg::argparse_index index = make_index();
+  command_line cl(args);
+  CHECK(allocations_of([&] {
+          veg::parse_known_args(&cl.argc, cl.argv, index, usages);
+        }) == 0);
+  CHECK(cl.argc == 3);
+  CHECK(num == 4);
+
+  command_line linear(args);
+  CHECK(allocations_of([&] {
+          veg::parse_known_args(&linear.argc, linear.argv, options, usages);
+        }) == 0);
+  CHECK(linear.argc == 3);
+}
+
+TEST_CASE("no allocation: parse_span") {
+  std::string_view const args[] = {
+      "-fvn", "5", "--name=span", "--ratio", "2", "-lz", "input", "--", "-f"};
+  std::size_t rest[9];
+  veg::argparse_index index = make_index();
+  veg::argparse_span_result result{};
+  CHECK(allocations_of([&] {
+          result = veg::parse_span(index, args, 9, rest);
+        }) == 0);
+  CHECK(result.error == nullptr);
+  CHECK(result.n_rest == 2);
+  CHECK(name == "span");
+
+  CHECK(allocations_of([&] {
+          result = veg::parse_span(options, args, 9, rest);
+        }) == 0);
+  CHECK(result.error == nullptr);
+}
+
+TEST_CASE("no allocation: cursor") {
+  veg::argparse_index index = make_index();
+  std::size_t n_events = 0;
+  CHECK(allocations_of([&] {
+          for (auto const& event : veg::argparse_events(
+                   index, int(sizeof(line) / sizeof(line[0])), line)) {
+            (void)event;
+            ++n_events;
+          }
+        }) == 0);
+  CHECK(n_events == 12);
+}
+
+TEST_CASE("no allocation: incremental") {
+  veg::argparse_token tokens[32];
+  std::uint32_t last[n_options];
+  veg::argparse_incremental inc;
+  char const* edit[] = {"-fvv", "--num=7"};
+  char const* error = nullptr;
+  char const* reason = nullptr;
+  CHECK(allocations_of([&] {
+          veg::argparse_incremental_init(
+              &inc, options, n_options, nullptr, 0, tokens, 32, last);
+          veg::argparse_incremental_edit(&inc, 0, 0, line + 1, 11);
+          veg::argparse_incremental_edit(&inc, 0, 2, edit, 2);
+          std::size_t token = 0;
+          error = veg::argparse_incremental_error(&inc, &token);
+          veg::argparse_option const* failed = nullptr;
+          reason = veg::argparse_incremental_apply(&inc, &failed);
+        }) == 0);
+  CHECK(error == nullptr);
+  CHECK(reason == nullptr);
+  CHECK(num == 7);
+}
+
+namespace {
+
+// memory resource handing out a single static buffer
+struct buffer_resource {
+  alignas(std::uint32_t) unsigned char buffer[4096];
+  void* allocated = nullptr;
+  void* released = nullptr;
+
+  auto allocate(std::size_t size, std::size_t /*unused*/) -> void* {
+    REQUIRE(size <= sizeof(buffer));
+    allocated = buffer;
+    return buffer;
+  }
+  void deallocate(void* ptr, std::size_t /*unused*/, std::size_t /*unused*/) {
+    released = ptr;
+  }
+};
+
+} // namespace
+
+TEST_CASE("no allocation: index storage from a memory resource") {
+  buffer_resource resource;
+  veg::argparse_index index;
+  REQUIRE(veg::argparse_index_build(&index, options, n_options, &resource));
+
+  // as documented with `argparse_index_build`
+  std::size_t size = veg::argparse_index_storage_size(options, n_options);
+  resource.deallocate(
+      const_cast<veg::argparse_index_entry*>(index.entries),
+      size,
+      alignof(std::uint32_t));
+  CHECK(resource.released == resource.allocated);
+}
@@ -0,0 +1,54 @@
+// modules sharing an option name: the registry is global to the process, so
+// that the conflicting modules are registered in an executable of their own
+#include "doctest.h"
+#include "argparse.hpp"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+long cache_size = 64;
+veg::argparse_option const cache_options[] = {
+    {&cache_size, 's', "size"},
+};
+ARGPARSE_MODULE(cache, cache_options);
+
+long disk_size = 0;
+bool disk_sync = false;
+veg::argparse_option const disk_options[] = {
+    {&disk_size, "size"},
+    {&disk_sync, 's', "sync"},
+};
+ARGPARSE_MODULE(disk, disk_options);
+
+} // namespace
+
+TEST_CASE("registry: names shared by modules are reported") {
+  alignas(veg::argparse_option) static unsigned char storage[2048];
+  std::size_t size = veg::argparse_registry_storage_size();
+  REQUIRE(size <= sizeof(storage));
+
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  std::fflush(stderr);
+  int saved = dup(2);
+  dup2(fds[1], 2);
+  close(fds[1]);
+  veg::argparse_index index;
+  bool built = veg::argparse_registry_build(&index, storage, size);
+  std::fflush(stderr);
+  dup2(saved, 2);
+  close(saved);
+  std::string errors;
+  char buf[256];
+  for (ssize_t n; (n = read(fds[0], buf, sizeof(buf))) > 0;) {
+    errors.append(buf, std::size_t(n));
+  }
+  close(fds[0]);
+
+  CHECK_FALSE(built);
+  CHECK(errors ==
+        "error: option `--size` of `disk` is already declared by `cache`\n"
+        "error: option `-s` of `disk` is already declared by `cache`\n");
+}
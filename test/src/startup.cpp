@@ -0,0 +1,163 @@
+#include <fmt/core.h>
+#include "argparse.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+extern char** environ; // NOLINT
+
+namespace {
+
+// binaries built from startup_probe.cpp
+struct probe {
+  char const* name;
+  char const* path;
+};
+
+constexpr probe probes[] = {
+#ifdef STARTUP_PROBE_SMALL
+    {"small", STARTUP_PROBE_SMALL},
+    {"large", STARTUP_PROBE_LARGE},
+    {"huge", STARTUP_PROBE_HUGE},
+#endif
+    {nullptr, nullptr},
+};
+
+struct mode {
+  char const* name;
+  std::vector<char const*> args;
+  int expected_status;
+};
+
+struct stats {
+  double p50_us;
+  double p99_us;
+  double p50_faults;
+  double p99_faults;
+};
+
+template <typename T>
+auto percentile(std::vector<T>& v, double p) -> double {
+  std::size_t i = std::min(v.size() - 1, std::size_t(p * double(v.size())));
+  std::nth_element(v.begin(), v.begin() + std::ptrdiff_t(i), v.end());
+  return double(v[i]);
+}
+
+// spawns the binary `runs` times with stdout/stderr redirected to /dev/null,
+// returns false if any run exits with an unexpected status
+auto measure(char const* path, mode const& m, int runs, stats* out) -> bool {
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(path));
+  for (char const* arg : m.args) {
+    argv.push_back(const_cast<char*>(arg));
+  }
+  argv.push_back(nullptr);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+
+  std::vector<double> times;
+  std::vector<long> faults;
+  bool ok = true;
+  for (int k = 0; k < runs && ok; ++k) {
+    pid_t pid = 0;
+    int status = 0;
+    rusage usage = {};
+    auto begin = std::chrono::steady_clock::now();
+    if (posix_spawn(&pid, path, &actions, nullptr, argv.data(), environ) !=
+            0 ||
+        wait4(pid, &status, 0, &usage) != pid) {
+      ok = false;
+      break;
+    }
+    auto end = std::chrono::steady_clock::now();
+    ok = WIFEXITED(status) && WEXITSTATUS(status) == m.expected_status;
+    times.push_back(std::chrono::duration<double, std::micro>(end - begin)
+                        .count());
+    faults.push_back(usage.ru_minflt + usage.ru_majflt);
+  }
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (ok) {
+    *out = {
+        percentile(times, 0.5),
+        percentile(times, 0.99),
+        percentile(faults, 0.5),
+        percentile(faults, 0.99),
+    };
+  }
+  return ok;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int {
+  int runs = 2000;
+  char const* extra = nullptr;
+
+  char const* usage[] = {"startup [options]"};
+  veg::argparse_option options[] = {
+      veg::help,
+      {&runs, 'r', "runs", "spawns per binary and mode"},
+      {&extra, "probe", "additional binary to measure"},
+  };
+  veg::parse_args(
+      &argc,
+      argv,
+      options,
+      usage,
+      "measures end-to-end process startup of binaries using the parser");
+
+  mode const modes[] = {
+      {"normal", {"-v", "--num=3", "input"}, 0},
+      {"help", {"--help"}, 0},
+      {"error", {"--unknown-option"}, 1},
+  };
+
+  std::vector<probe> targets(probes, probes + sizeof(probes) / sizeof(probe));
+  targets.pop_back();
+  if (extra != nullptr) {
+    targets.push_back({"extra", extra});
+  }
+
+  fmt::print(
+      "{:<8} {:<8} {:>10} {:>10} {:>12} {:>12}\n",
+      "binary",
+      "mode",
+      "p50 (us)",
+      "p99 (us)",
+      "p50 faults",
+      "p99 faults");
+  int status = 0;
+  for (auto const& target : targets) {
+    for (auto const& m : modes) {
+      stats s = {};
+      if (!measure(target.path, m, runs, &s)) {
+        std::fprintf(
+            stderr,
+            "error: `%s` failed in mode `%s`\n",
+            target.path,
+            m.name);
+        status = 1;
+        continue;
+      }
+      fmt::print(
+          "{:<8} {:<8} {:>10.1f} {:>10.1f} {:>12.0f} {:>12.0f}\n",
+          target.name,
+          m.name,
+          s.p50_us,
+          s.p99_us,
+          s.p50_faults,
+          s.p99_faults);
+    }
+  }
+  return status;
+}
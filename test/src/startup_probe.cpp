@@ -0,0 +1,70 @@
+// representative tool with a static option table of 10^STARTUP_DEPTH generated
+// options, spawned by `startup` to measure what the library adds to process
+// startup
+
+#include "argparse.hpp"
+
+#define STARTUP_R10(M, x)                                                      \
+  M(x##0) M(x##1) M(x##2) M(x##3) M(x##4) M(x##5) M(x##6) M(x##7) M(x##8)      \
+  M(x##9)
+#define STARTUP_R100(M, x)                                                     \
+  STARTUP_R10(M, x##0)                                                         \
+  STARTUP_R10(M, x##1)                                                         \
+  STARTUP_R10(M, x##2)                                                         \
+  STARTUP_R10(M, x##3)                                                         \
+  STARTUP_R10(M, x##4)                                                         \
+  STARTUP_R10(M, x##5)                                                         \
+  STARTUP_R10(M, x##6)                                                         \
+  STARTUP_R10(M, x##7)                                                         \
+  STARTUP_R10(M, x##8)                                                         \
+  STARTUP_R10(M, x##9)
+#define STARTUP_R1000(M, x)                                                    \
+  STARTUP_R100(M, x##0)                                                        \
+  STARTUP_R100(M, x##1)                                                        \
+  STARTUP_R100(M, x##2)                                                        \
+  STARTUP_R100(M, x##3)                                                        \
+  STARTUP_R100(M, x##4)                                                        \
+  STARTUP_R100(M, x##5)                                                        \
+  STARTUP_R100(M, x##6)                                                        \
+  STARTUP_R100(M, x##7)                                                        \
+  STARTUP_R100(M, x##8)                                                        \
+  STARTUP_R100(M, x##9)
+#define STARTUP_R10000(M, x)                                                   \
+  STARTUP_R1000(M, x##0)                                                       \
+  STARTUP_R1000(M, x##1)                                                       \
+  STARTUP_R1000(M, x##2)                                                       \
+  STARTUP_R1000(M, x##3)                                                       \
+  STARTUP_R1000(M, x##4)                                                       \
+  STARTUP_R1000(M, x##5)                                                       \
+  STARTUP_R1000(M, x##6)                                                       \
+  STARTUP_R1000(M, x##7)                                                       \
+  STARTUP_R1000(M, x##8)                                                       \
+  STARTUP_R1000(M, x##9)
+
+#if STARTUP_DEPTH == 1
+#define STARTUP_OPTIONS(M) STARTUP_R10(M, )
+#elif STARTUP_DEPTH == 3
+#define STARTUP_OPTIONS(M) STARTUP_R1000(M, )
+#else
+#define STARTUP_OPTIONS(M) STARTUP_R10000(M, )
+#endif
+
+// all generated options share a target, only the table size matters here
+static long value = 0;
+static bool verbose = false;
+static long num = 0;
+
+#define STARTUP_OPTION(x) {&value, "option-" #x, "generated option " #x},
+
+static veg::argparse_option const options[] = {
+    veg::help,
+    {&verbose, 'v', "verbose", "print more"},
+    {&num, 'n', "num", "selected num"},
+    "Generated options",
+    STARTUP_OPTIONS(STARTUP_OPTION)};
+
+auto main(int argc, char** argv) -> int {
+  char const* usage[] = {"startup_probe [options]"};
+  veg::parse_args(&argc, argv, options, usage);
+  return 0;
+}
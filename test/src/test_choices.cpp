@@ -0,0 +1,82 @@
+#include "doctest.h"
+#include "argparse_choices.hpp"
+#include <string>
+
+namespace {
+
+enum struct color { red, green, blue, cyan, magenta, yellow, black, white };
+
+constexpr veg::argparse_choice<color> color_names[] = {
+    {"red", color::red},
+    {"green", color::green},
+    {"blue", color::blue},
+    {"cyan", color::cyan},
+    {"magenta", color::magenta},
+    {"yellow", color::yellow},
+    {"black", color::black},
+    {"white", color::white},
+};
+constexpr auto colors = veg::make_choices(color_names);
+constexpr auto folded_colors = veg::make_choices(color_names, true);
+
+// the seed found is the first one that works
+static_assert(
+    veg::make_choices(color_names, false, colors.seed + 1).seed == colors.seed,
+    "");
+
+auto find(decltype(colors) const& table, char const* arg)
+    -> veg::argparse_choice<color> const* {
+  return table.find(arg, std::char_traits<char>::length(arg));
+}
+
+} // namespace
+
+template <>
+struct veg::option_traits<color>
+    : veg::choice_traits<decltype(colors), colors> {};
+
+TEST_CASE("choices: every name has a slot of its own") {
+  std::size_t n_used = 0;
+  for (auto slot : colors.slots) {
+    n_used += slot != 0 ? 1 : 0;
+  }
+  CHECK(n_used == colors.size);
+  for (auto const& choice : color_names) {
+    CAPTURE(choice.name);
+    auto const* found = find(colors, choice.name);
+    REQUIRE(found != nullptr);
+    CHECK(found->value == choice.value);
+  }
+  for (char const* other : {"", "re", "redd", "Red", "purple", "white "}) {
+    CAPTURE(other);
+    CHECK(find(colors, other) == nullptr);
+  }
+  // the length is the one given, not the null character
+  CHECK(colors.find("greenery", 5)->value == color::green);
+}
+
+TEST_CASE("choices: case folding") {
+  CHECK(find(folded_colors, "RED")->value == color::red);
+  CHECK(find(folded_colors, "Magenta")->value == color::magenta);
+  CHECK(find(folded_colors, "bLuE")->value == color::blue);
+  CHECK(find(folded_colors, "BLUES") == nullptr);
+  CHECK(find(colors, "RED") == nullptr);
+}
+
+TEST_CASE("choices: option traits") {
+  using traits = veg::option_traits<color>;
+  CHECK(
+      std::string(traits::placeholder) ==
+      "{red|green|blue|cyan|magenta|yellow|black|white}");
+  color value = color::red;
+  CHECK(traits::parse(value, "cyan") == nullptr);
+  CHECK(value == color::cyan);
+  CHECK(
+      std::string(traits::parse(value, "purple")) ==
+      "expects one of red, green, blue, cyan, magenta, yellow, black or "
+      "white");
+  CHECK(value == color::cyan);
+  char buf[16];
+  CHECK(traits::format(value, buf, sizeof(buf)) == 4);
+  CHECK(std::string(buf) == "cyan");
+}
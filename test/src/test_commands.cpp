@@ -0,0 +1,180 @@
+#include "doctest.h"
+#include "argparse.hpp"
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+char const* const usages[] = {"tool"};
+
+// arguments each command was run with, space separated
+std::vector<std::string> runs;
+
+auto record(int argc, char** argv) -> int {
+  std::string run;
+  for (int i = 0; i < argc; ++i) {
+    run += (i == 0 ? "" : " ") + std::string(argv[i]);
+  }
+  runs.push_back(run);
+  return int(runs.size());
+}
+
+constexpr veg::argparse_command remote_commands_[] = {
+    {"add", record, "add a remote"},
+    {"remove", record, "remove a remote"},
+};
+constexpr auto remote_commands = veg::argparse_commands<2>{remote_commands_};
+
+auto cmd_remote(int argc, char** argv) -> int {
+  record(argc, argv);
+  bool verbose = false;
+  veg::argparse_option const options[] = {
+      {&verbose, 'v', "verbose", "say more"},
+  };
+  veg::parse_args(
+      &argc,
+      argv,
+      options,
+      usages,
+      "",
+      "",
+      veg::ARGPARSE_STOP_AT_NON_OPTION);
+  return 10 * int(verbose) + veg::run_command(remote_commands, argc, argv);
+}
+
+constexpr veg::argparse_command commands_[] = {
+    {"commit", record, "record changes"},
+    {"remote", cmd_remote, "manage remotes"},
+};
+constexpr auto commands = veg::argparse_commands<2>{commands_};
+
+// enough git commands for several names to share their first slot
+constexpr veg::argparse_command git_commands_[] = {
+    {"add", record},      {"am", record},          {"apply", record},
+    {"bisect", record},   {"blame", record},       {"branch", record},
+    {"checkout", record}, {"cherry-pick", record}, {"clean", record},
+    {"clone", record},    {"commit", record},      {"config", record},
+    {"describe", record}, {"diff", record},        {"fetch", record},
+    {"grep", record},     {"init", record},        {"log", record},
+    {"merge", record},    {"mv", record},          {"pull", record},
+    {"push", record},     {"rebase", record},      {"reflog", record},
+    {"remote", record},   {"reset", record},       {"restore", record},
+    {"revert", record},   {"rm", record},          {"show", record},
+    {"stash", record},    {"status", record},      {"switch", record},
+    {"tag", record},      {"worktree", record},
+};
+constexpr auto git_commands = veg::argparse_commands<35>{git_commands_};
+
+// mutable copy of the arguments following the program name
+struct args {
+  std::vector<std::string> storage;
+  std::vector<char*> argv;
+
+  args(std::initializer_list<char const*> list)
+      : storage(list.begin(), list.end()) {
+    for (auto& arg : storage) {
+      argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+  }
+  auto argc() const -> int { return int(argv.size() - 1); }
+};
+
+// runs the commands on `list` in a child process, and returns its exit
+// status, followed by its output on stdout and stderr
+auto run_failing(std::initializer_list<char const*> list) -> std::string {
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  std::fflush(stdout);
+  std::fflush(stderr);
+  pid_t pid = fork();
+  REQUIRE(pid >= 0);
+  if (pid == 0) {
+    dup2(fds[1], 1);
+    dup2(fds[1], 2);
+    close(fds[0]);
+    args a(list);
+    veg::run_command(commands, a.argc(), a.argv.data());
+    _exit(0);
+  }
+  close(fds[1]);
+  std::string out;
+  char buf[256];
+  for (ssize_t n; (n = read(fds[0], buf, sizeof(buf))) > 0;) {
+    out.append(buf, std::size_t(n));
+  }
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  REQUIRE(WIFEXITED(status));
+  return std::to_string(WEXITSTATUS(status)) + "\n" + out;
+}
+
+} // namespace
+
+TEST_CASE("commands: the command gets its name and its arguments") {
+  runs.clear();
+  args a = {"commit", "-m", "message"};
+  CHECK(veg::run_command(commands, a.argc(), a.argv.data()) == 1);
+  REQUIRE(runs.size() == 1);
+  CHECK(runs[0] == "commit -m message");
+}
+
+TEST_CASE("commands: nested commands dispatch on the words left") {
+  runs.clear();
+  args a = {"remote", "-v", "add", "origin", "url"};
+  CHECK(veg::run_command(commands, a.argc(), a.argv.data()) == 12);
+  REQUIRE(runs.size() == 2);
+  CHECK(runs[0] == "remote -v add origin url");
+  CHECK(runs[1] == "add origin url");
+}
+
+TEST_CASE("commands: unknown and missing commands exit with the list") {
+  std::string const list =
+      "\nCommands:\n"
+      "    commit  record changes\n"
+      "    remote  manage remotes\n";
+  CHECK(run_failing({"comit"}) ==
+        "1\nerror: unknown command `comit`\n" + list);
+  CHECK(run_failing({}) == "1\nerror: missing command\n" + list);
+  // nested tables report their own commands
+  CHECK(run_failing({"remote", "rename"}) ==
+        "1\nerror: unknown command `rename`\n"
+        "\nCommands:\n"
+        "    add     add a remote\n"
+        "    remove  remove a remote\n");
+}
+
+TEST_CASE("commands: names sharing a slot are probed") {
+  std::size_t const mask = git_commands.n_slots - 1;
+  std::size_t n_moved = 0;
+  for (auto const& command : git_commands.commands) {
+    std::size_t home =
+        veg::_argparse::hash_name(command.name, std::strlen(command.name)) &
+        mask;
+    std::uint32_t i = git_commands.slots[home];
+    n_moved += git_commands.commands[i - 1].name != command.name ? 1 : 0;
+  }
+  REQUIRE(n_moved > 0);
+
+  runs.clear();
+  for (auto const& command : git_commands.commands) {
+    args a = {command.name, "--flag"};
+    veg::run_command(git_commands, a.argc(), a.argv.data());
+    CHECK(runs.back() == std::string(command.name) + " --flag");
+  }
+  CHECK(runs.size() == 35);
+  for (char const* name : {"ad", "commits", "remove", "x"}) {
+    CHECK(
+        veg::argparse_find_command(
+            git_commands.commands,
+            git_commands.slots,
+            git_commands.n_slots,
+            name) == nullptr);
+  }
+}
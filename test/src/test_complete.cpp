@@ -0,0 +1,149 @@
+#include "doctest.h"
+#include "argparse.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+char const* const usages[] = {"tool"};
+
+auto cmd_commit(int argc, char** argv) -> int {
+  bool amend = false;
+  veg::argparse_option const options[] = {
+      {&amend, "amend", "amend the last commit"},
+  };
+  veg::parse_args(&argc, argv, options, usages, "", "", veg::ARGPARSE_COMPLETE);
+  return 7;
+}
+
+constexpr veg::argparse_command commands_[] = {
+    {"commit", cmd_commit, "record changes"},
+    {"config", cmd_commit, "get and set options"},
+};
+constexpr auto commands = veg::argparse_commands<2>{commands_};
+
+// runs the tool with `args` in a child process, and returns its output. the
+// tool parses with `flags`, and prints the arguments left if it returns
+auto run(int flags, std::vector<char const*> args) -> std::string {
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  std::fflush(stdout);
+  pid_t pid = fork();
+  REQUIRE(pid >= 0);
+  if (pid == 0) {
+    dup2(fds[1], 1);
+    close(fds[0]);
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>("tool"));
+    for (char const* arg : args) {
+      argv.push_back(const_cast<char*>(arg));
+    }
+    argv.push_back(nullptr);
+    int argc = int(argv.size() - 1);
+
+    bool verbose = false;
+    veg::argparse_option const options[] = {
+        {&verbose, 'v', "verbose", "say more"},
+    };
+    veg::parse_args(&argc, argv.data(), options, usages, "", "", flags);
+    if ((flags & veg::ARGPARSE_STOP_AT_NON_OPTION) != 0) {
+      std::printf("ran %d\n", veg::run_command(commands, argc, argv.data()));
+    } else {
+      for (int i = 0; i < argc; ++i) {
+        std::printf("%s\n", argv[std::size_t(i)]);
+      }
+    }
+    std::fflush(stdout);
+    _exit(0);
+  }
+  close(fds[1]);
+  std::string out;
+  char buf[256];
+  for (ssize_t n; (n = read(fds[0], buf, sizeof(buf))) > 0;) {
+    out.append(buf, std::size_t(n));
+  }
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return out;
+}
+
+// sources the bash completion script of the tool, with a `tool` function
+// answering `__complete` with the lines of `answer`, and completes `words`
+// as split by bash. returns the words given to `tool`, then the replies
+auto complete_in_bash(std::string const& answer, std::string const& words)
+    -> std::string {
+  char path[] = "/tmp/test_complete_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  std::string script = run(veg::ARGPARSE_COMPLETE, {"__completion", "bash"});
+  script +=
+      "tool() { printf '%s|' \"$@\" >\"$log\"; printf -- '" + answer + "'; }\n"
+      "log=$(mktemp)\n"
+      "COMP_WORDS=(" + words + ")\n"
+      "COMP_CWORD=$((${#COMP_WORDS[@]} - 1))\n"
+      "_tool_complete 2>/dev/null\n"
+      "cat \"$log\"; echo; rm -f \"$log\"\n"
+      "printf '%s\\n' \"${COMPREPLY[@]}\"\n";
+  REQUIRE(write(fd, script.data(), script.size()) == ssize_t(script.size()));
+  close(fd);
+
+  std::string out;
+  std::FILE* bash = popen(("bash " + std::string(path)).c_str(), "r");
+  REQUIRE(bash != nullptr);
+  char buf[256];
+  for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), bash)) > 0;) {
+    out.append(buf, n);
+  }
+  pclose(bash);
+  unlink(path);
+  return out;
+}
+
+} // namespace
+
+TEST_CASE("complete: only with ARGPARSE_COMPLETE") {
+  CHECK(run(0, {"__complete", "-v", "x"}) == "__complete\nx\n");
+  CHECK(run(0, {"__completion", "bash"}) == "__completion\nbash\n");
+  CHECK(
+      run(veg::ARGPARSE_COMPLETE, {"__complete", "--ve"}) ==
+      "--verbose\tsay more\n");
+}
+
+TEST_CASE("complete: commands and their options") {
+  int flags = veg::ARGPARSE_COMPLETE | veg::ARGPARSE_STOP_AT_NON_OPTION;
+  CHECK(
+      run(flags, {"__complete", "-v", "co"}) ==
+      "commit\trecord changes\nconfig\tget and set options\n");
+  CHECK(run(flags, {"__complete", "-v", "com"}) == "commit\trecord changes\n");
+  CHECK(
+      run(flags, {"__complete", "commit", "--am"}) ==
+      "--amend\tamend the last commit\n");
+  CHECK(run(flags, {"__complete", "unknown", "--am"}).empty());
+  CHECK(run(flags, {"commit", "--amend"}) == "ran 7\n");
+}
+
+TEST_CASE("complete: bash completes values after `=`") {
+  // the script is only run where bash is installed
+  if (std::system("command -v bash >/dev/null 2>&1") != 0) {
+    return;
+  }
+  // bash breaks words at `=`
+  std::string choices = "--mode=fast\\tgo fast\\n--mode=faster\\t\\n";
+  CHECK(
+      complete_in_bash(choices, "tool --mode = f") ==
+      "__complete|--mode=f|\nfast\nfaster\n");
+  CHECK(
+      complete_in_bash(choices, "tool -v --mode =") ==
+      "__complete|-v|--mode=|\n=fast\n=faster\n");
+  CHECK(
+      complete_in_bash(choices, "tool --mode=f") ==
+      "__complete|--mode=f|\n--mode=fast\n--mode=faster\n");
+  CHECK(
+      complete_in_bash("--verbose\\tsay more\\n", "tool --ve") ==
+      "__complete|--ve|\n--verbose\n");
+}
@@ -0,0 +1,295 @@
+#include "doctest.h"
+#include "argparse.hpp"
+#include "argparse_incremental.hpp"
+#include "argparse_span.hpp"
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+char const* input = nullptr;
+bool json = false;
+bool yaml = false;
+char const* cert = nullptr;
+char const* key = nullptr;
+char const* user = nullptr;
+char const* password = nullptr;
+
+veg::argparse_option const options[] = {
+    {&input, 'i', "input"},
+    {&json, "json"},
+    {&yaml, "yaml"},
+    {&cert, "tls-cert"},
+    {&key, "tls-key"},
+    {&user, 'u', "user"},
+    {&password, "password"},
+};
+constexpr std::size_t n_options = sizeof(options) / sizeof(options[0]);
+
+constexpr veg::argparse_constraint constraints[] = {
+    veg::required("input"),
+    veg::at_most_one("json", "yaml"),
+    veg::all_or_none("tls-cert", "tls-key"),
+    veg::implies("user", "password"),
+};
+
+struct result {
+  int status;
+  std::string error;
+};
+
+// parses `args` in a child process, and returns its exit status and the first
+// line it wrote to stderr
+auto run(std::vector<char const*> args) -> result {
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  pid_t pid = fork();
+  REQUIRE(pid >= 0);
+  if (pid == 0) {
+    dup2(fds[1], 2);
+    close(fds[0]);
+    // the usage printed with the error is not checked
+    std::freopen("/dev/null", "w", stdout);
+    std::uint32_t index_storage[512];
+    std::uint64_t constraints_storage[64];
+    veg::argparse_index index;
+    if (!veg::argparse_index_build(
+            &index, options, n_options, index_storage, sizeof(index_storage)) ||
+        !veg::argparse_index_constrain(
+            &index,
+            constraints,
+            4,
+            constraints_storage,
+            sizeof(constraints_storage))) {
+      _exit(2);
+    }
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>("test_constraints"));
+    for (char const* arg : args) {
+      argv.push_back(const_cast<char*>(arg));
+    }
+    argv.push_back(nullptr);
+    int argc = int(argv.size() - 1);
+    char const* const usages[] = {"test_constraints"};
+    veg::parse_args(&argc, argv.data(), index, usages);
+    _exit(0);
+  }
+  close(fds[1]);
+  std::string error;
+  char buf[256];
+  for (ssize_t n; (n = read(fds[0], buf, sizeof(buf))) > 0;) {
+    error.append(buf, std::size_t(n));
+  }
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return {WIFEXITED(status) ? WEXITSTATUS(status) : -1,
+          error.substr(0, error.find('\n'))};
+}
+
+} // namespace
+
+TEST_CASE("constraints: satisfied constraints parse") {
+  CHECK(run({"-i", "in"}).status == 0);
+  CHECK(run({"--input=in", "--json"}).status == 0);
+  CHECK(run({"-i", "in", "--tls-cert=c", "--tls-key=k"}).status == 0);
+  CHECK(run({"-i", "in", "-u", "me", "--password=pw"}).status == 0);
+  CHECK(run({"-i", "in", "--password=pw"}).status == 0);
+  // the last occurrence of a negated option does not give it
+  CHECK(run({"-i", "in", "--json", "--no-yaml"}).status == 0);
+  CHECK(run({"-i", "in", "--yaml", "--json", "--no-yaml"}).status == 0);
+}
+
+TEST_CASE("constraints: violations are reported") {
+  result r = run({"--json"});
+  CHECK(r.status == 1);
+  CHECK(r.error == "error: option `--input` is required");
+
+  r = run({"-i", "in", "--yaml", "--json"});
+  CHECK(r.status == 1);
+  CHECK(
+      r.error ==
+      "error: options `--json` and `--yaml` are mutually exclusive");
+
+  r = run({"-i", "in", "--tls-key=k"});
+  CHECK(r.status == 1);
+  CHECK(r.error == "error: option `--tls-cert` is required with `--tls-key`");
+
+  r = run({"-i", "in", "-u", "me"});
+  CHECK(r.status == 1);
+  CHECK(r.error == "error: option `--password` is required by `--user`");
+}
+
+TEST_CASE("constraints: invalid constraints are not attached") {
+  std::uint32_t index_storage[512];
+  veg::argparse_index index;
+  REQUIRE(veg::argparse_index_build(
+      &index, options, n_options, index_storage, sizeof(index_storage)));
+  std::uint64_t storage[64];
+
+  CHECK_FALSE(veg::argparse_index_constrain(
+      &index,
+      constraints,
+      4,
+      storage,
+      veg::argparse_constraints_storage_size(n_options, 4) - 1));
+  CHECK(index.constraints == nullptr);
+
+  constexpr veg::argparse_constraint unknown[] = {
+      veg::required("output"),
+  };
+  CHECK_FALSE(veg::argparse_index_constrain(
+      &index, unknown, 1, storage, sizeof(storage)));
+  CHECK(index.constraints == nullptr);
+
+  REQUIRE(veg::argparse_index_constrain(
+      &index, constraints, 4, storage, sizeof(storage)));
+  CHECK(index.n_constraints == 4);
+}
+
+TEST_CASE("constraints: at most 64 options are constrained") {
+  constexpr std::size_t n_many = 65;
+  char names[n_many][4];
+  bool values[n_many] = {};
+  std::vector<veg::argparse_option> many;
+  for (std::size_t i = 0; i < n_many; ++i) {
+    std::snprintf(names[i], sizeof(names[i]), "o%02zu", i);
+    many.push_back({&values[i], names[i]});
+  }
+  std::uint32_t index_storage[1024];
+  veg::argparse_index index;
+  REQUIRE(veg::argparse_index_storage_size(many.data(), n_many) <=
+          sizeof(index_storage));
+  REQUIRE(veg::argparse_index_build(
+      &index, many.data(), n_many, index_storage, sizeof(index_storage)));
+
+  constexpr std::size_t max_names = veg::argparse_constraint::max_names;
+  constexpr std::size_t n_constraints = (n_many + max_names - 1) / max_names;
+  veg::argparse_constraint required[n_constraints] = {};
+  for (std::size_t i = 0; i < n_many; ++i) {
+    auto& constraint = required[i / max_names];
+    constraint.kind = veg::ARGPARSE_REQUIRED;
+    constraint.names[constraint.n_names++] = names[i];
+  }
+  std::uint64_t storage[256];
+  REQUIRE(veg::argparse_constraints_storage_size(n_many, n_constraints) <=
+          sizeof(storage));
+  CHECK_FALSE(veg::argparse_index_constrain(
+      &index, required, n_constraints, storage, sizeof(storage)));
+  CHECK(veg::argparse_index_constrain(
+      &index, required, n_constraints - 1, storage, sizeof(storage)));
+}
+
+namespace {
+
+bool with_json = false;
+bool with_yaml = false;
+long output = 0;
+
+veg::argparse_option const flag_options[] = {
+    {&with_json, "json"},
+    {&with_yaml, "yaml"},
+    {&output, 'o', "output"},
+};
+
+constexpr veg::argparse_constraint flag_constraints[] = {
+    veg::at_most_one("json", "yaml"),
+    veg::required("output"),
+};
+
+// an index over `flag_options`, with `flag_constraints` attached
+struct constrained {
+  std::uint32_t index_storage[512];
+  std::uint64_t constraints_storage[64];
+  veg::argparse_index index;
+
+  constrained() {
+    REQUIRE(veg::argparse_index_build(
+        &index, flag_options, 3, index_storage, sizeof(index_storage)));
+    REQUIRE(veg::argparse_index_constrain(
+        &index,
+        flag_constraints,
+        2,
+        constraints_storage,
+        sizeof(constraints_storage)));
+  }
+};
+
+} // namespace
+
+TEST_CASE("constraints: the first violation is returned") {
+  constrained c;
+  auto bit = [&](std::size_t i) {
+    return veg::argparse_index_give(&c.index, flag_options + i, false, 0);
+  };
+  auto violation = veg::argparse_index_violation(&c.index, bit(0) | bit(1));
+  REQUIRE(violation.reason != nullptr);
+  CHECK(violation.kind == veg::ARGPARSE_AT_MOST_ONE);
+  CHECK(violation.option == flag_options + 0);
+  CHECK(violation.other == flag_options + 1);
+
+  violation = veg::argparse_index_violation(&c.index, bit(0));
+  REQUIRE(violation.reason != nullptr);
+  CHECK(violation.kind == veg::ARGPARSE_REQUIRED);
+  CHECK(violation.option == flag_options + 2);
+  CHECK(violation.other == nullptr);
+
+  CHECK(
+      veg::argparse_index_violation(&c.index, bit(0) | bit(2)).reason ==
+      nullptr);
+  // a negation takes back the option given
+  std::uint64_t given =
+      veg::argparse_index_give(&c.index, flag_options + 1, true, bit(1));
+  CHECK(given == 0);
+  CHECK(veg::argparse_index_violation(nullptr, 0).reason == nullptr);
+}
+
+TEST_CASE("constraints: spans are checked") {
+  constrained c;
+  std::size_t rest[4];
+  std::string_view exclusive[] = {"--json", "--yaml", "-o", "1"};
+  auto result = veg::parse_span(c.index, exclusive, 4, rest);
+  REQUIRE(result.error != nullptr);
+  CHECK(std::string(result.error) == "mutually exclusive options are given");
+  CHECK(result.failed == 4);
+
+  std::string_view missing[] = {"--json", "--", "-o"};
+  result = veg::parse_span(c.index, missing, 3, rest);
+  REQUIRE(result.error != nullptr);
+  CHECK(std::string(result.error) == "a required option is missing");
+  CHECK(result.failed == 3);
+
+  std::string_view negated[] = {"--json", "--yaml", "--no-yaml", "-o1"};
+  result = veg::parse_span(c.index, negated, 4, rest);
+  CHECK(result.error == nullptr);
+}
+
+TEST_CASE("constraints: incremental lines are checked") {
+  constrained c;
+  veg::argparse_token tokens[8];
+  std::uint32_t last[3];
+  veg::argparse_incremental line;
+  veg::argparse_incremental_init(
+      &line, flag_options, 3, &c.index, 0, tokens, 8, last);
+  char const* args[] = {"--json", "--yaml", "-o", "1"};
+  REQUIRE(veg::argparse_incremental_edit(&line, 0, 0, args, 4));
+  std::size_t token = 0;
+  char const* reason = veg::argparse_incremental_error(&line, &token);
+  REQUIRE(reason != nullptr);
+  CHECK(std::string(reason) == "mutually exclusive options are given");
+  CHECK(token == 4);
+
+  char const* negated[] = {"--no-yaml"};
+  REQUIRE(veg::argparse_incremental_edit(&line, 1, 2, negated, 1));
+  CHECK(veg::argparse_incremental_error(&line, &token) == nullptr);
+
+  REQUIRE(veg::argparse_incremental_edit(&line, 2, 4, nullptr, 0));
+  reason = veg::argparse_incremental_error(&line, &token);
+  REQUIRE(reason != nullptr);
+  CHECK(std::string(reason) == "a required option is missing");
+  CHECK(token == 2);
+}
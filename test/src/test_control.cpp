@@ -0,0 +1,252 @@
+#include "doctest.h"
+#include "argparse_control.hpp"
+#include "argparse_pattern.hpp"
+#include "argparse_std.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// sends `request` to the endpoint of `control` listening at `path`, serves
+// it, and returns the response
+auto request(
+    veg::argparse_control* control, char const* path, std::string const& line)
+    -> std::string {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  REQUIRE(fd >= 0);
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+  REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+  std::string text = line + "\n";
+  REQUIRE(send(fd, text.data(), text.size(), 0) == ssize_t(text.size()));
+  REQUIRE(veg::argparse_control_serve(control, 1000) == 1);
+
+  std::string response;
+  char buf[256];
+  for (ssize_t n; (n = recv(fd, buf, sizeof(buf), 0)) > 0;) {
+    response.append(buf, std::size_t(n));
+  }
+  close(fd);
+  return response;
+}
+
+} // namespace
+
+TEST_CASE("control: set copies values to the values storage") {
+  long num = 1;
+  char const* path = "in";
+  std::string_view name = "default";
+  veg::argparse_option const options[] = {
+      {&num, 'n', "num"},
+      {&path, 'p', "path"},
+      {&name, "name"},
+  };
+  veg::argparse_source sources[3];
+  char values[3 * 16];
+  char const* argv[] = {"test_control", "-n", "2"};
+  veg::argparse_control control;
+  veg::argparse_control_init(
+      &control, options, 3, nullptr, sources, values, sizeof(values), 3, argv);
+  CHECK(sources[0] == veg::ARGPARSE_SOURCE_COMMAND_LINE);
+
+  char socket_path[] = "/tmp/test_control_XXXXXX";
+  int tmp = mkstemp(socket_path);
+  REQUIRE(tmp >= 0);
+  close(tmp);
+  REQUIRE(veg::argparse_control_listen(&control, socket_path));
+
+  CHECK(request(&control, socket_path, "set --path=out --name db -n 3") ==
+        "ok\n");
+  // the request buffer is gone, and reused by the next request
+  CHECK(request(&control, socket_path, "get num") == "num=3 control\n");
+  CHECK(std::string(path) == "out");
+  CHECK(name == "db");
+  CHECK(path >= values);
+  CHECK(path < values + sizeof(values));
+  CHECK(name.data() >= values);
+  CHECK(name.data() < values + sizeof(values));
+
+  SUBCASE("a failing set applies nothing") {
+    CHECK(request(&control, socket_path, "set --path=new -n x --name=n2") ==
+          "error: `-n` expects an integer value\n");
+    CHECK(request(&control, socket_path, "set --name=n2 --path=new -q") ==
+          "error: `-q` unknown option\n");
+    CHECK(std::string(path) == "out");
+    CHECK(name == "db");
+    CHECK(num == 3);
+  }
+  SUBCASE("values that do not fit in their slot are rejected") {
+    CHECK(request(&control, socket_path, "set -n 4 --path=0123456789abcdef") ==
+          "error: `--path=0123456789abcdef` is too long to be stored\n");
+    CHECK(num == 3);
+    CHECK(request(&control, socket_path, "set -n 4 --path=0123456789abcde") ==
+          "ok\n");
+    CHECK(std::string(path) == "0123456789abcde");
+  }
+
+  veg::argparse_control_close(&control);
+  unlink(socket_path);
+}
+
+TEST_CASE("control: strings cannot be set without values storage") {
+  char const* path = "in";
+  bool verbose = false;
+  veg::argparse_option const options[] = {
+      {&path, 'p', "path"},
+      {&verbose, 'v', "verbose"},
+  };
+  veg::argparse_source sources[2];
+  char const* argv[] = {"test_control"};
+  veg::argparse_control control;
+  veg::argparse_control_init(
+      &control, options, 2, nullptr, sources, nullptr, 0, 1, argv);
+
+  char socket_path[] = "/tmp/test_control_XXXXXX";
+  int tmp = mkstemp(socket_path);
+  REQUIRE(tmp >= 0);
+  close(tmp);
+  REQUIRE(veg::argparse_control_listen(&control, socket_path));
+  CHECK(request(&control, socket_path, "set -v --path=x") ==
+        "error: `--path=x` is too long to be stored\n");
+  CHECK_FALSE(verbose);
+  CHECK(request(&control, socket_path, "set -v") == "ok\n");
+  CHECK(verbose);
+  veg::argparse_control_close(&control);
+  unlink(socket_path);
+}
+
+TEST_CASE("control: the command line is walked past what it cannot set") {
+  long num = 1;
+  bool verbose = false;
+  veg::argparse_option const options[] = {
+      {&num, 'n', "num"},
+      {&verbose, 'v', "verbose"},
+  };
+  veg::argparse_source sources[2];
+  char const* argv[] = {"test_control", "--verbose=1", "-x", "-n", "2"};
+  veg::argparse_control control;
+  veg::argparse_control_init(
+      &control, options, 2, nullptr, sources, nullptr, 0, 5, argv);
+  CHECK(sources[0] == veg::ARGPARSE_SOURCE_COMMAND_LINE);
+  CHECK(sources[1] == veg::ARGPARSE_SOURCE_DEFAULT);
+}
+
+TEST_CASE("control: set checks the patterns of the index") {
+  char const* tenant = "default";
+  long num = 1;
+  veg::argparse_option const options[] = {
+      {&tenant, 't', "tenant"},
+      {&num, 'n', "num"},
+  };
+  constexpr veg::argparse_pattern patterns[] = {{"tenant", "[a-z]+"}};
+  std::uint32_t index_storage[512];
+  void* pattern_storage[256];
+  veg::argparse_index index;
+  REQUIRE(veg::argparse_index_build(
+      &index, options, 2, index_storage, sizeof(index_storage)));
+  REQUIRE(veg::argparse_index_match(
+      &index, patterns, 1, pattern_storage, sizeof(pattern_storage)));
+  veg::argparse_source sources[2];
+  char values[2 * 16];
+  char const* argv[] = {"test_control"};
+  veg::argparse_control control;
+  veg::argparse_control_init(
+      &control, options, 2, &index, sources, values, sizeof(values), 1, argv);
+
+  char socket_path[] = "/tmp/test_control_XXXXXX";
+  int tmp = mkstemp(socket_path);
+  REQUIRE(tmp >= 0);
+  close(tmp);
+  REQUIRE(veg::argparse_control_listen(&control, socket_path));
+  CHECK(request(&control, socket_path, "set -n 2 --tenant=Acme") ==
+        "error: `--tenant=Acme` does not match `[a-z]+`\n");
+  CHECK(num == 1);
+  CHECK(std::string(tenant) == "default");
+  CHECK(request(&control, socket_path, "set -n 2 --tenant=acme") == "ok\n");
+  CHECK(num == 2);
+  CHECK(std::string(tenant) == "acme");
+  veg::argparse_control_close(&control);
+  unlink(socket_path);
+}
+
+TEST_CASE("control: set counts every occurrence of counters") {
+  int verbosity = 0;
+  veg::argparse_option const options[] = {
+      veg::counter(&verbosity, 'v', "verbose"),
+  };
+  veg::argparse_source sources[1];
+  char const* argv[] = {"test_control"};
+  veg::argparse_control control;
+  veg::argparse_control_init(
+      &control, options, 1, nullptr, sources, nullptr, 0, 1, argv);
+
+  char socket_path[] = "/tmp/test_control_XXXXXX";
+  int tmp = mkstemp(socket_path);
+  REQUIRE(tmp >= 0);
+  close(tmp);
+  REQUIRE(veg::argparse_control_listen(&control, socket_path));
+  CHECK(request(&control, socket_path, "set -vvv -v") == "ok\n");
+  CHECK(verbosity == 4);
+  CHECK(request(&control, socket_path, "set --no-verbose -v") == "ok\n");
+  CHECK(verbosity == 1);
+  veg::argparse_control_close(&control);
+  unlink(socket_path);
+}
+
+TEST_CASE("control: a client not reading its response is dropped") {
+  // a response far larger than the socket buffer
+  std::string long_value(1000, 'x');
+  char const* value = long_value.c_str();
+  std::vector<veg::argparse_option> options(
+      1000, veg::argparse_option{&value, "value"});
+  std::vector<veg::argparse_source> sources(options.size());
+  char const* argv[] = {"test_control"};
+  veg::argparse_control control;
+  veg::argparse_control_init(
+      &control,
+      options.data(),
+      options.size(),
+      nullptr,
+      sources.data(),
+      nullptr,
+      0,
+      1,
+      argv);
+
+  char socket_path[] = "/tmp/test_control_XXXXXX";
+  int tmp = mkstemp(socket_path);
+  REQUIRE(tmp >= 0);
+  close(tmp);
+  REQUIRE(veg::argparse_control_listen(&control, socket_path));
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  REQUIRE(fd >= 0);
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path);
+  REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+  REQUIRE(send(fd, "get\n", 4, 0) == 4);
+  auto start = std::chrono::steady_clock::now();
+  CHECK(veg::argparse_control_serve(&control, 100) == 1);
+  CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+  // the response is cut short
+  std::size_t received = 0;
+  char buf[4096];
+  for (ssize_t n; (n = recv(fd, buf, sizeof(buf), 0)) > 0;) {
+    received += std::size_t(n);
+  }
+  CHECK(received > 0);
+  CHECK(received < options.size() * long_value.size());
+  close(fd);
+
+  veg::argparse_control_close(&control);
+  unlink(socket_path);
+}
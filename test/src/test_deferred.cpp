@@ -0,0 +1,177 @@
+#include "doctest.h"
+#include "argparse_deferred.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+char const* const usages[] = {"test_deferred"};
+
+// parses `args` with a deferred parser over `options`
+void parse(
+    veg::argparse_deferred* deferred,
+    veg::argparse_option const* options,
+    std::size_t n_options,
+    std::vector<char const*> args) {
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>("test_deferred"));
+  for (char const* arg : args) {
+    argv.push_back(const_cast<char*>(arg));
+  }
+  argv.push_back(nullptr);
+  int argc = int(argv.size() - 1);
+  veg::parse_args_deferred(
+      deferred,
+      &argc,
+      argv.data(),
+      options,
+      n_options,
+      nullptr,
+      usages,
+      1);
+}
+
+// executor running the submitted functions when waited for, and recording
+// `s` for each submission and `w` for each wait
+struct recorder {
+  std::string log;
+  std::vector<std::pair<void (*)(void*), void*>> pending;
+
+  static void submit(void* context, void (*fn)(void*), void* arg) {
+    auto* self = static_cast<recorder*>(context);
+    self->log += 's';
+    self->pending.emplace_back(fn, arg);
+  }
+  static void wait(void* context) {
+    auto* self = static_cast<recorder*>(context);
+    self->log += 'w';
+    for (auto const& p : self->pending) {
+      p.first(p.second);
+    }
+    self->pending.clear();
+  }
+};
+
+} // namespace
+
+TEST_CASE("deferred: callbacks are recorded, not run") {
+  std::string order;
+  long num = 0;
+  long seen = -1;
+  auto on_num = [&](veg::argparse* parser, veg::argparse_option const*) {
+    CHECK(parser == nullptr);
+    order += 'n';
+    seen = num;
+    return 0;
+  };
+  auto on_flag = [&](veg::argparse* parser, veg::argparse_option const*) {
+    CHECK(parser == nullptr);
+    order += 'f';
+    return 0;
+  };
+  veg::argparse_option const options[] = {
+      {&num, 'n', "num", "", on_num},
+      {nullptr, 'f', "flag", "", on_flag},
+  };
+  veg::argparse_deferred_call calls[4];
+  veg::argparse_deferred deferred = {calls, 4, 0};
+  parse(&deferred, options, 2, {"-n", "1", "-f", "--num=2"});
+  CHECK(order.empty());
+  REQUIRE(deferred.len == 3);
+  CHECK(calls[0].option == options + 0);
+  CHECK(calls[1].option == options + 1);
+  CHECK(calls[2].option == options + 0);
+
+  CHECK(veg::argparse_run_deferred(&deferred, 1) == 0);
+  CHECK(order == "nfn");
+  // callbacks see the final values
+  CHECK(seen == 2);
+}
+
+TEST_CASE("deferred: exceeding the capacity fails the parse") {
+  std::fflush(stdout);
+  pid_t pid = fork();
+  REQUIRE(pid >= 0);
+  if (pid == 0) {
+    std::freopen("/dev/null", "w", stdout);
+    std::freopen("/dev/null", "w", stderr);
+    auto noop = [](veg::argparse*, veg::argparse_option const*) { return 0; };
+    veg::argparse_option const options[] = {{nullptr, 'f', "flag", "", noop}};
+    veg::argparse_deferred_call calls[2];
+    veg::argparse_deferred deferred = {calls, 2, 0};
+    parse(&deferred, options, 1, {"-fff"});
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  REQUIRE(WIFEXITED(status));
+  CHECK(WEXITSTATUS(status) == 1);
+}
+
+TEST_CASE("deferred: results are kept and failures counted") {
+  auto ok = [](veg::argparse*, veg::argparse_option const*) { return 0; };
+  auto fail = [](veg::argparse*, veg::argparse_option const*) { return 3; };
+  veg::argparse_option const options[] = {
+      {nullptr, 'o', "ok", "", ok},
+      veg::with_flags({nullptr, 'f', "fail", "", fail}, veg::OPT_INDEPENDENT),
+  };
+  veg::argparse_deferred_call calls[8];
+  veg::argparse_deferred deferred = {calls, 8, 0};
+  parse(&deferred, options, 2, {"-fofff"});
+  REQUIRE(deferred.len == 5);
+  CHECK(veg::argparse_run_deferred(&deferred, 4) == 4);
+  CHECK(calls[0].result == 3);
+  CHECK(calls[1].result == 0);
+  CHECK(calls[4].result == 3);
+}
+
+TEST_CASE("deferred: a dependent call waits for all the earlier ones") {
+  std::atomic<int> n_done{0};
+  int done_before = -1;
+  int done_after = -1;
+  auto slow = [&](veg::argparse*, veg::argparse_option const*) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    n_done.fetch_add(1);
+    return 0;
+  };
+  auto dependent = [&](veg::argparse*, veg::argparse_option const*) {
+    done_before = n_done.load();
+    return 0;
+  };
+  auto last = [&](veg::argparse*, veg::argparse_option const*) {
+    done_after = n_done.load();
+    return 0;
+  };
+  veg::argparse_option const options[] = {
+      veg::with_flags({nullptr, 's', "slow", "", slow}, veg::OPT_INDEPENDENT),
+      {nullptr, 'd', "dependent", "", dependent},
+      veg::with_flags({nullptr, 'l', "last", "", last}, veg::OPT_INDEPENDENT),
+  };
+  veg::argparse_deferred_call calls[8];
+  veg::argparse_deferred deferred = {calls, 8, 0};
+  parse(&deferred, options, 3, {"-sss", "-d", "-sl"});
+
+  SUBCASE("on threads") {
+    CHECK(veg::argparse_run_deferred(&deferred, 4) == 0);
+  }
+  SUBCASE("through an executor") {
+    recorder r;
+    veg::argparse_executor executor = {
+        &r, &recorder::submit, &recorder::wait};
+    CHECK(veg::argparse_run_deferred(&deferred, executor) == 0);
+    // each run of independent calls is submitted, then waited for, and the
+    // dependent call runs in between
+    CHECK(r.log == "ssswssw");
+  }
+  CHECK(done_before == 3);
+  // the calls following the dependent one may run concurrently with each
+  // other, but after it
+  CHECK(done_after >= 3);
+  CHECK(n_done.load() == 4);
+}
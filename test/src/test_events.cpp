@@ -0,0 +1,152 @@
+#include "doctest.h"
+#include "argparse_events.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+bool verbose = false;
+long num = 0;
+char const* path = nullptr;
+
+veg::argparse_option const options[] = {
+    {&verbose, 'v', "verbose"},
+    {&num, 'n', "num"},
+    {&path, 'p', "path"},
+};
+
+struct event {
+  veg::argparse_event_kind kind;
+  int option; // position in `options`, -1 if none
+  std::string value;
+  int index;
+  int n_args;
+};
+
+auto operator==(event const& a, event const& b) -> bool {
+  return a.kind == b.kind && a.option == b.option && a.value == b.value &&
+         a.index == b.index && a.n_args == b.n_args;
+}
+
+// reads the events of `args`, following the program name, and checks that
+// they cover the arguments exactly once
+auto events(std::vector<char const*> args, int flags = 0)
+    -> std::vector<event> {
+  args.insert(args.begin(), "test_events");
+  int argc = int(args.size());
+  std::vector<event> out;
+  int covered = 1;
+  veg::argparse_events range(options, argc, args.data(), flags);
+  for (auto const& e : range) {
+    CHECK(e.index == covered);
+    covered += e.n_args;
+    if (e.kind == veg::ARGPARSE_EVENT_ERROR) {
+      REQUIRE(e.error != nullptr);
+    } else {
+      CHECK(e.error == nullptr);
+    }
+    out.push_back(
+        {e.kind,
+         e.option != nullptr ? int(e.option - options) : -1,
+         e.value != nullptr ? e.value : "",
+         e.index,
+         e.n_args});
+  }
+  CHECK(covered == argc);
+  return out;
+}
+
+constexpr auto option = veg::ARGPARSE_EVENT_OPTION;
+constexpr auto positional = veg::ARGPARSE_EVENT_POSITIONAL;
+constexpr auto separator = veg::ARGPARSE_EVENT_SEPARATOR;
+constexpr auto error = veg::ARGPARSE_EVENT_ERROR;
+
+} // namespace
+
+TEST_CASE("events: options in every form") {
+  CHECK(
+      events({"-vn3", "-n", "4", "--num=5", "--path", "out", "--no-verbose"}) ==
+      std::vector<event>{
+          {option, 0, "1", 1, 0},
+          {option, 1, "3", 1, 1},
+          {option, 1, "4", 2, 2},
+          {option, 1, "5", 4, 1},
+          {option, 2, "out", 5, 2},
+          {option, 0, "0", 7, 1},
+      });
+  CHECK(
+      events({"-vv", "-vn", "6"}) == std::vector<event>{
+                                         {option, 0, "1", 1, 0},
+                                         {option, 0, "1", 1, 1},
+                                         {option, 0, "1", 2, 0},
+                                         {option, 1, "6", 2, 2},
+                                     });
+}
+
+TEST_CASE("events: positional arguments and separators") {
+  CHECK(
+      events({"in", "-v", "--", "-n", "3"}) == std::vector<event>{
+                                                   {positional, -1, "in", 1, 1},
+                                                   {option, 0, "1", 2, 1},
+                                                   {separator, -1, "", 3, 1},
+                                                   {positional, -1, "-n", 4, 1},
+                                                   {positional, -1, "3", 5, 1},
+                                               });
+  // a single dash is positional
+  CHECK(events({"-"}) == std::vector<event>{{positional, -1, "-", 1, 1}});
+}
+
+TEST_CASE("events: ARGPARSE_STOP_AT_NON_OPTION") {
+  CHECK(
+      events({"-v", "run", "-n", "--"}, veg::ARGPARSE_STOP_AT_NON_OPTION) ==
+      std::vector<event>{
+          {option, 0, "1", 1, 1},
+          {positional, -1, "run", 2, 1},
+          {positional, -1, "-n", 3, 1},
+          {positional, -1, "--", 4, 1},
+      });
+}
+
+TEST_CASE("events: errors") {
+  CHECK(
+      events({"-vx", "--unknown", "--verbose=1", "in"}) ==
+      std::vector<event>{
+          {option, 0, "1", 1, 0},
+          {error, -1, "x", 1, 1},
+          {error, -1, "unknown", 2, 1},
+          {error, 0, "verbose=1", 3, 1},
+          {positional, -1, "in", 4, 1},
+      });
+  CHECK(
+      events({"-v", "--num"}) == std::vector<event>{
+                                     {option, 0, "1", 1, 1},
+                                     {error, 1, "num", 2, 1},
+                                 });
+  CHECK(
+      events({"-vn"}) == std::vector<event>{
+                             {option, 0, "1", 1, 0},
+                             {error, 1, "n", 1, 1},
+                         });
+
+  char const* argv[] = {"test_events", "--num"};
+  veg::argparse_cursor cursor;
+  veg::argparse_cursor_init(&cursor, options, 3, nullptr, 0, 2, argv);
+  veg::argparse_event e{};
+  REQUIRE(veg::argparse_cursor_next(&cursor, &e));
+  CHECK(std::string(e.error) == "requires a value");
+  CHECK_FALSE(veg::argparse_cursor_next(&cursor, &e));
+}
+
+TEST_CASE("events: the range stops where the consumer does") {
+  char const* argv[] = {"test_events", "-v", "run", "-n", "3"};
+  veg::argparse_events range(options, 5, argv);
+  int run = 0;
+  for (auto const& e : range) {
+    if (e.kind == veg::ARGPARSE_EVENT_POSITIONAL) {
+      run = e.index;
+      break;
+    }
+  }
+  CHECK(run == 2);
+  CHECK(range.cursor().pos == 3);
+}
@@ -0,0 +1,171 @@
+#include "doctest.h"
+#include "argparse_incremental.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+bool force = false;
+veg::ternary color;
+long num = 0;
+double ratio = 0;
+char letter = 0;
+char const* path = nullptr;
+int verbosity = 0;
+
+veg::argparse_option const options[] = {
+    {&force, 'f', "force"},
+    {&color, 'c', "color"},
+    {&num, 'n', "num"},
+    {&ratio, "ratio"},
+    {&letter, 'l', "letter"},
+    {&path, 'p', "path"},
+    veg::counter(&verbosity, 'v', "verbose"),
+};
+constexpr std::size_t n_options = sizeof(options) / sizeof(options[0]);
+
+// options and their values, in all the forms they take, and words that
+// change the classification of the words after them
+char const* const words[] = {
+    "-f", "-v", "-vv", "-fv", "-n", "-fn", "-fn5", "-n7", "-l", "-lx", "-lxy",
+    "-p", "-z", "-fz", "--num", "--num=4", "--num=", "--num=x", "--nu",
+    "--force", "--no-force", "--force=1", "--color", "--no-color", "--ratio",
+    "--ratio=2", "--path", "--path=out", "--unknown", "--", "-", "3", "x",
+    "0.5", "input", "-3",
+};
+constexpr std::size_t n_words = sizeof(words) / sizeof(words[0]);
+
+constexpr std::size_t capacity = 24;
+
+struct parser {
+  veg::argparse_token tokens[capacity];
+  std::uint32_t last[n_options];
+  veg::argparse_incremental inc;
+
+  explicit parser(int flags) {
+    veg::argparse_incremental_init(
+        &inc, options, n_options, nullptr, flags, tokens, capacity, last);
+  }
+};
+
+// checks that `edited` reports what a parser given the whole line at once
+// does
+void check_fresh(
+    veg::argparse_incremental const* edited,
+    std::vector<char const*> const& line,
+    int flags) {
+  parser fresh(flags);
+  REQUIRE(veg::argparse_incremental_edit(
+      &fresh.inc, 0, 0, line.data(), line.size()));
+  REQUIRE(edited->len == line.size());
+
+  for (std::size_t i = 0; i < line.size(); ++i) {
+    CAPTURE(i);
+    CHECK(edited->tokens[i].arg == line[i]);
+    CHECK(edited->tokens[i].kind == fresh.tokens[i].kind);
+    CHECK(edited->tokens[i].option == fresh.tokens[i].option);
+    CHECK(edited->tokens[i].error == fresh.tokens[i].error);
+  }
+
+  std::size_t edited_token = 0;
+  std::size_t fresh_token = 0;
+  char const* edited_error =
+      veg::argparse_incremental_error(edited, &edited_token);
+  char const* fresh_error =
+      veg::argparse_incremental_error(&fresh.inc, &fresh_token);
+  CHECK(edited_error == fresh_error);
+  if (fresh_error != nullptr) {
+    CHECK(edited_token == fresh_token);
+  }
+
+  for (std::size_t i = 0; i < n_options; ++i) {
+    CAPTURE(i);
+    CHECK(edited->last[i] == fresh.last[i]);
+    CHECK(
+        veg::argparse_incremental_value(edited, i) ==
+        veg::argparse_incremental_value(&fresh.inc, i));
+  }
+}
+
+// applies random edits, checking the parser against a fresh one after each
+void run_random_edits(int flags, unsigned seed) {
+  std::mt19937 rng(seed);
+  auto pick = [&](std::size_t n) {
+    return std::uniform_int_distribution<std::size_t>(0, n)(rng);
+  };
+
+  parser edited(flags);
+  std::vector<char const*> line;
+  for (int step = 0; step < 400; ++step) {
+    CAPTURE(step);
+    std::size_t begin = pick(line.size());
+    std::size_t end =
+        begin + pick(std::min<std::size_t>(line.size() - begin, 3));
+    std::size_t room = capacity - (line.size() - (end - begin));
+    std::size_t n_args = pick(std::min<std::size_t>(room, 4));
+    char const* args[4];
+    for (std::size_t i = 0; i < n_args; ++i) {
+      args[i] = words[pick(n_words - 1)];
+    }
+
+    REQUIRE(veg::argparse_incremental_edit(
+        &edited.inc, begin, end, args, n_args));
+    line.erase(line.begin() + long(begin), line.begin() + long(end));
+    line.insert(line.begin() + long(begin), args, args + n_args);
+    check_fresh(&edited.inc, line, flags);
+  }
+}
+
+} // namespace
+
+TEST_CASE("incremental: random edits parse as the whole line") {
+  int const flags[] = {
+      0,
+      veg::ARGPARSE_STOP_AT_NON_OPTION,
+      veg::ARGPARSE_KEEP_UNKNOWN,
+      veg::ARGPARSE_STOP_AT_NON_OPTION | veg::ARGPARSE_KEEP_UNKNOWN,
+  };
+  for (int f : flags) {
+    for (unsigned seed = 1; seed <= 8; ++seed) {
+      CAPTURE(f);
+      CAPTURE(seed);
+      run_random_edits(f, seed);
+    }
+  }
+}
+
+TEST_CASE("incremental: edits past the capacity are rejected") {
+  parser inc(0);
+  char const* full[capacity + 1];
+  for (auto& word : full) {
+    word = "-v";
+  }
+  CHECK_FALSE(
+      veg::argparse_incremental_edit(&inc.inc, 0, 0, full, capacity + 1));
+  CHECK(inc.inc.len == 0);
+  REQUIRE(veg::argparse_incremental_edit(&inc.inc, 0, 0, full, capacity));
+  CHECK_FALSE(veg::argparse_incremental_edit(&inc.inc, 2, 1, full, 0));
+  CHECK_FALSE(
+      veg::argparse_incremental_edit(&inc.inc, 0, capacity + 1, full, 0));
+  CHECK(inc.inc.len == capacity);
+}
+
+TEST_CASE("incremental: counters count every occurrence") {
+  parser line(0);
+  char const* args[] = {"-vvv", "-n", "2", "-fv", "--verbose"};
+  REQUIRE(veg::argparse_incremental_edit(&line.inc, 0, 0, args, 5));
+  verbosity = 0;
+  num = 0;
+  veg::argparse_option const* failed = nullptr;
+  CHECK(veg::argparse_incremental_apply(&line.inc, &failed) == nullptr);
+  CHECK(verbosity == 5);
+  CHECK(num == 2);
+
+  // the last occurrence alone does not reset the count
+  char const* reset[] = {"--no-verbose", "-v"};
+  REQUIRE(veg::argparse_incremental_edit(&line.inc, 0, 1, reset, 2));
+  verbosity = 0;
+  CHECK(veg::argparse_incremental_apply(&line.inc, &failed) == nullptr);
+  CHECK(verbosity == 3);
+}
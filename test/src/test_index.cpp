@@ -0,0 +1,166 @@
+#include "doctest.h"
+#include "argparse.hpp"
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+char const* const usages[] = {"test_index"};
+
+// parses the null-terminated `args`, following a program name, with `options`
+// through an index if `indexed`, and returns the number of arguments left
+auto parse(
+    veg::argparse_option const* options,
+    std::size_t n_options,
+    bool indexed,
+    std::vector<char const*> args) -> int {
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>("test_index"));
+  for (char const* arg : args) {
+    argv.push_back(const_cast<char*>(arg));
+  }
+  argv.push_back(nullptr);
+  int argc = int(argv.size() - 1);
+
+  if (!indexed) {
+    veg::parse_args(&argc, argv.data(), options, n_options, usages, 1);
+    return argc;
+  }
+  std::vector<std::uint32_t> storage(
+      veg::argparse_index_storage_size(options, n_options) /
+          sizeof(std::uint32_t) +
+      1);
+  veg::argparse_index index;
+  REQUIRE(veg::argparse_index_build(
+      &index,
+      options,
+      n_options,
+      storage.data(),
+      storage.size() * sizeof(std::uint32_t)));
+  veg::parse_args(&argc, argv.data(), index, usages, 1);
+  return argc;
+}
+
+} // namespace
+
+TEST_CASE("index: exact names are matched before negations") {
+  for (bool indexed : {false, true}) {
+    CAPTURE(indexed);
+    bool foo = true;
+    bool no_foo = false;
+
+    SUBCASE("negatable option first") {
+      veg::argparse_option const options[] = {
+          {&foo, "foo"},
+          {&no_foo, "no-foo"},
+      };
+      parse(options, 2, indexed, {"--no-foo"});
+      CHECK(foo);
+      CHECK(no_foo);
+    }
+    SUBCASE("negatable option last") {
+      veg::argparse_option const options[] = {
+          {&no_foo, "no-foo"},
+          {&foo, "foo"},
+      };
+      parse(options, 2, indexed, {"--no-foo"});
+      CHECK(foo);
+      CHECK(no_foo);
+    }
+    SUBCASE("negation without an exact match") {
+      veg::argparse_option const options[] = {
+          {&no_foo, "no-bar"},
+          {&foo, "foo"},
+      };
+      parse(options, 2, indexed, {"--no-foo"});
+      CHECK_FALSE(foo);
+      CHECK_FALSE(no_foo);
+    }
+  }
+}
+
+TEST_CASE("index: argparse_find_long agrees with the linear lookup") {
+  bool a = false;
+  bool b = false;
+  long n = 0;
+  veg::argparse_option const options[] = {
+      "Group",
+      {&a, 'a', "alpha"},
+      {&b, "no-alpha"},
+      veg::with_flags({&b, "beta"}, veg::OPT_NONEG),
+      {&n, 'n', "num"},
+      {&a, "alpha"}, // shadowed by the first one
+  };
+  std::size_t const n_options = sizeof(options) / sizeof(options[0]);
+  std::vector<std::uint32_t> storage(
+      veg::argparse_index_storage_size(options, n_options) /
+          sizeof(std::uint32_t) +
+      1);
+  veg::argparse_index index;
+  REQUIRE(veg::argparse_index_build(
+      &index,
+      options,
+      n_options,
+      storage.data(),
+      storage.size() * sizeof(std::uint32_t)));
+
+  char const* const names[] = {
+      "alpha", "no-alpha", "beta", "no-beta", "num", "no-num", "gamma",
+      "no-", "no-alpha-x", "Group", "",
+  };
+  for (char const* name : names) {
+    CAPTURE(name);
+    bool linear_negated = false;
+    bool indexed_negated = false;
+    auto const* linear = veg::argparse_find_long(
+        options,
+        n_options,
+        nullptr,
+        name,
+        std::strlen(name),
+        &linear_negated);
+    auto const* indexed = veg::argparse_find_long(
+        options,
+        n_options,
+        &index,
+        name,
+        std::strlen(name),
+        &indexed_negated);
+    CHECK(linear == indexed);
+    CHECK(linear_negated == indexed_negated);
+  }
+  for (char c : {'a', 'n', 'x', '\0'}) {
+    CAPTURE(c);
+    CHECK(
+        veg::argparse_find_short(options, n_options, nullptr, c) ==
+        veg::argparse_find_short(options, n_options, &index, c));
+  }
+}
+
+TEST_CASE("index: parses as the linear lookup") {
+  for (bool indexed : {false, true}) {
+    CAPTURE(indexed);
+    bool force = false;
+    veg::ternary tern;
+    long num = 0;
+    char const* path = nullptr;
+    veg::argparse_option const options[] = {
+        veg::help,
+        {&force, 'f', "force"},
+        {&tern, 't', "tern"},
+        {&num, 'n', "num"},
+        {&path, 'p', "path"},
+    };
+    int argc = parse(
+        options,
+        5,
+        indexed,
+        {"-fn", "3", "in", "--no-tern", "--path=out", "--", "-f"});
+    CHECK(argc == 2);
+    CHECK(force);
+    CHECK(tern == veg::ternary::no);
+    CHECK(num == 3);
+    CHECK(std::strcmp(path, "out") == 0);
+  }
+}
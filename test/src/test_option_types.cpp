@@ -0,0 +1,130 @@
+#include "doctest.h"
+#include "argparse.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+template <typename T, typename = void>
+struct supported : std::false_type {};
+template <typename T>
+struct supported<T, veg::_argparse::is_supported<T>> : std::true_type {};
+
+struct derived_ternary : veg::ternary {};
+
+// converts to a supported pointer type
+struct int_handle {
+  constexpr int_handle(std::nullptr_t /*unused*/) noexcept {}
+  constexpr operator int*() const noexcept { return nullptr; }
+};
+
+struct endpoint {
+  int port;
+};
+
+// parses `-ab --no-a` into `word`, which has a bit set that no option owns,
+// and returns the formatted value of `a` and `b`
+template <typename Word>
+auto parse_bits(Word* word) -> std::string {
+  veg::argparse_option const options[] = {
+      veg::bit<1U>(word, 'a', "alpha"),
+      veg::bit<2U>(word, 'b', "beta"),
+  };
+  char const* const usages[] = {"test_option_types"};
+  char const* const args[] = {"test_option_types", "-ab", "--no-alpha"};
+  char* argv[] = {
+      const_cast<char*>(args[0]),
+      const_cast<char*>(args[1]),
+      const_cast<char*>(args[2]),
+      nullptr};
+  int argc = 3;
+  veg::parse_args(&argc, argv, options, usages);
+  CHECK(argc == 0);
+
+  std::string formatted;
+  for (auto const& option : options) {
+    char buf[8];
+    CHECK(veg::argparse_format_value(&option, buf, sizeof(buf)) == 1);
+    formatted += buf;
+  }
+  return formatted;
+}
+
+} // namespace
+
+namespace veg {
+template <>
+struct option_traits<endpoint> {
+  static constexpr char const* placeholder = "<port>";
+  static auto parse(endpoint& out, char const* arg) -> char const* {
+    out.port = arg[0];
+    return nullptr;
+  }
+};
+} // namespace veg
+
+static_assert(supported<bool*>::value, "");
+static_assert(supported<veg::ternary*>::value, "");
+static_assert(supported<char*>::value, "");
+static_assert(supported<char signed*>::value, "");
+static_assert(supported<char unsigned*>::value, "");
+static_assert(supported<int*>::value, "");
+static_assert(supported<long long unsigned*>::value, "");
+static_assert(supported<long double*>::value, "");
+static_assert(supported<char const**>::value, "");
+
+static_assert(!supported<derived_ternary*>::value, "");
+static_assert(!supported<int_handle>::value, "");
+static_assert(!supported<int const*>::value, "");
+static_assert(!supported<char**>::value, "");
+static_assert(!supported<void*>::value, "");
+static_assert(!supported<endpoint*>::value, "");
+static_assert(!supported<int>::value, "");
+
+static_assert(
+    std::is_constructible<veg::argparse_option, int*, char const*>::value,
+    "");
+static_assert(
+    std::is_constructible<veg::argparse_option, endpoint*, char const*>::value,
+    "");
+static_assert(
+    !std::is_constructible<veg::argparse_option, derived_ternary*, char const*>::
+        value,
+    "");
+static_assert(
+    !std::is_constructible<veg::argparse_option, int_handle, char const*>::value,
+    "");
+
+TEST_CASE("option types: exact types map to their option type") {
+  using veg::_argparse::argparse_option_type;
+  CHECK(
+      veg::_argparse::to_option_type<char>::value ==
+      argparse_option_type::ARGPARSE_OPT_CHAR);
+  CHECK(
+      veg::_argparse::to_option_type<char signed>::value ==
+      argparse_option_type::ARGPARSE_OPT_SCHAR);
+  CHECK(
+      veg::_argparse::to_option_type<char const*>::value ==
+      argparse_option_type::ARGPARSE_OPT_STRING);
+
+  int n = 0;
+  endpoint server{};
+  veg::argparse_option const options[] = {
+      {&n, 'n', "num"},
+      {&server, "server"},
+  };
+  CHECK(options[0].type == argparse_option_type::ARGPARSE_OPT_SINT);
+  CHECK(options[1].type == argparse_option_type::ARGPARSE_OPT_CUSTOM);
+}
+
+TEST_CASE("option types: bits set and clear their own mask only") {
+  std::uint8_t word = 0x80;
+  CHECK(parse_bits(&word) == "01");
+  CHECK(word == 0x82);
+
+  std::atomic<std::uint8_t> atomic_word{0x80};
+  CHECK(parse_bits(&atomic_word) == "01");
+  CHECK(atomic_word.load() == 0x82);
+}
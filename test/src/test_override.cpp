@@ -0,0 +1,143 @@
+#include "doctest.h"
+#include "argparse_override.hpp"
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct extent {
+  long width;
+  long height;
+};
+
+} // namespace
+
+namespace veg {
+template <>
+struct option_traits<extent> {
+  static constexpr char const* placeholder = "<w>x<h>";
+  static auto parse(extent& out, char const* arg) -> char const* {
+    char* end = nullptr;
+    out.width = std::strtol(arg, &end, 10);
+    if (*end != 'x') {
+      return "expects <w>x<h>";
+    }
+    out.height = std::strtol(end + 1, &end, 10);
+    return *end == '\0' ? nullptr : "expects <w>x<h>";
+  }
+};
+} // namespace veg
+
+TEST_CASE("override: nested overrides are seen by their thread only") {
+  long num = 1;
+  veg::argparse_option const options[] = {
+      {&num, 'n', "num"},
+  };
+  CHECK(veg::argparse_get(num) == 1);
+  {
+    veg::argparse_override<long> outer(options, "num", "2");
+    REQUIRE(outer.error() == nullptr);
+    CHECK(veg::argparse_get(num) == 2);
+    {
+      veg::argparse_override<long> inner(&num, 3);
+      CHECK(veg::argparse_get(num) == 3);
+
+      long seen = 0;
+      std::thread other([&] { seen = veg::argparse_get(num); });
+      other.join();
+      CHECK(seen == 1);
+    }
+    CHECK(veg::argparse_get(num) == 2);
+  }
+  CHECK(veg::argparse_get(num) == 1);
+
+  veg::argparse_override<long> invalid(options, "num", "x");
+  CHECK(invalid.error() != nullptr);
+  CHECK(veg::argparse_get(num) == 1);
+}
+
+TEST_CASE("override: options are found through an index") {
+  long num = 1;
+  char const* path = "in";
+  veg::argparse_option const options[] = {
+      {&num, 'n', "num"},
+      {&path, 'p', "path"},
+  };
+  std::uint32_t storage[512];
+  veg::argparse_index index;
+  REQUIRE(veg::argparse_index_build(
+      &index, options, 2, storage, sizeof(storage)));
+  {
+    char const arg[] = "out";
+    veg::argparse_override<char const*> path_override(index, "path", arg);
+    REQUIRE(path_override.error() == nullptr);
+    // points into the argument
+    CHECK(veg::argparse_get(path) == arg);
+    CHECK(path == std::string("in"));
+  }
+  CHECK(veg::argparse_get(path) == std::string("in"));
+}
+
+TEST_CASE("override: failures override nothing") {
+  long num = 1;
+  bool verbose = false;
+  veg::argparse_option const options[] = {
+      {&num, 'n', "num"},
+      {&verbose, 'v', "verbose"},
+  };
+  auto error_of = [&](auto const& override) {
+    return std::string(override.error() != nullptr ? override.error() : "");
+  };
+  veg::argparse_override<int> mismatch(options, "num", "2");
+  CHECK(error_of(mismatch) == "does not hold a value of the given type");
+  veg::argparse_override<long> unknown(options, "number", "2");
+  CHECK(error_of(unknown) == "unknown option");
+  veg::argparse_override<long> missing(options, "num", nullptr);
+  CHECK(error_of(missing) == "requires a value");
+  veg::argparse_override<bool> negated(options, "no-verbose", "1");
+  CHECK(error_of(negated) == "takes no value");
+  CHECK(veg::argparse_get(num) == 1);
+  CHECK_FALSE(veg::argparse_get(verbose));
+}
+
+TEST_CASE("override: flags are set, or unset when negated") {
+  bool verbose = false;
+  veg::argparse_option const options[] = {
+      {&verbose, 'v', "verbose"},
+  };
+  veg::argparse_override<bool> set(options, "verbose", nullptr);
+  REQUIRE(set.error() == nullptr);
+  CHECK(veg::argparse_get(verbose));
+  {
+    veg::argparse_override<bool> unset(options, "no-verbose", nullptr);
+    REQUIRE(unset.error() == nullptr);
+    CHECK_FALSE(veg::argparse_get(verbose));
+    {
+      veg::argparse_override<bool> given(options, "verbose", "1");
+      REQUIRE(given.error() == nullptr);
+      CHECK(veg::argparse_get(verbose));
+    }
+    CHECK_FALSE(veg::argparse_get(verbose));
+  }
+  CHECK(veg::argparse_get(verbose));
+  CHECK_FALSE(verbose);
+}
+
+TEST_CASE("override: user-defined types are parsed by their traits") {
+  extent window = {640, 480};
+  veg::argparse_option const options[] = {
+      {&window, "window"},
+  };
+  {
+    veg::argparse_override<extent> larger(options, "window", "1280x720");
+    REQUIRE(larger.error() == nullptr);
+    CHECK(veg::argparse_get(window).width == 1280);
+    CHECK(veg::argparse_get(window).height == 720);
+
+    veg::argparse_override<extent> invalid(options, "window", "1280");
+    CHECK(std::string(invalid.error()) == "expects <w>x<h>");
+    CHECK(veg::argparse_get(window).width == 1280);
+  }
+  CHECK(veg::argparse_get(window).width == 640);
+}
@@ -0,0 +1,91 @@
+#include "doctest.h"
+#include "argparse.hpp"
+#include <cstring>
+
+TEST_CASE("parse: unknown short options are kept whole") {
+  for (bool indexed : {false, true}) {
+    CAPTURE(indexed);
+    bool verbose = false;
+    bool force = false;
+    veg::argparse_option const options[] = {
+        {&verbose, 'v', "verbose"},
+        {&force, 'f', "force"},
+    };
+    std::uint32_t storage[512];
+    veg::argparse_index index;
+    REQUIRE(veg::argparse_index_build(
+        &index, options, 2, storage, sizeof(storage)));
+
+    char const* const usages[] = {"test_parse"};
+    // read-only, as string literals, so that any write faults
+    char const* const args[] = {"test_parse", "-vxf", "in", "-y"};
+    char* argv[] = {
+        const_cast<char*>(args[0]),
+        const_cast<char*>(args[1]),
+        const_cast<char*>(args[2]),
+        const_cast<char*>(args[3]),
+        nullptr};
+    int argc = 4;
+    if (indexed) {
+      veg::parse_known_args(&argc, argv, index, usages);
+    } else {
+      veg::parse_known_args(&argc, argv, options, usages);
+    }
+    REQUIRE(argc == 3);
+    CHECK(std::strcmp(argv[0], "-vxf") == 0);
+    CHECK(argv[0] == args[1]);
+    CHECK(std::strcmp(argv[1], "in") == 0);
+    CHECK(std::strcmp(argv[2], "-y") == 0);
+    CHECK(verbose);
+    CHECK_FALSE(force);
+  }
+}
+
+TEST_CASE("parse: arguments are split as documented") {
+  bool verbose = false;
+  long num = 0;
+  veg::argparse_option const options[] = {
+      {&verbose, 'v', "verbose"},
+      {&num, 'n', "num"},
+  };
+  CHECK(veg::argparse_arg_kind_of("in") == veg::ARGPARSE_ARG_POSITIONAL);
+  CHECK(veg::argparse_arg_kind_of("-") == veg::ARGPARSE_ARG_POSITIONAL);
+  CHECK(veg::argparse_arg_kind_of("--") == veg::ARGPARSE_ARG_SEPARATOR);
+  CHECK(veg::argparse_arg_kind_of("-vn3") == veg::ARGPARSE_ARG_SHORT);
+  CHECK(veg::argparse_arg_kind_of("--num") == veg::ARGPARSE_ARG_LONG);
+  // bounded by their size rather than a null character
+  CHECK(veg::argparse_arg_kind_of("-v", 1) == veg::ARGPARSE_ARG_POSITIONAL);
+  CHECK(veg::argparse_arg_kind_of("--num", 2) == veg::ARGPARSE_ARG_SEPARATOR);
+
+  char const* cluster = "-vn3";
+  veg::argparse_read read =
+      veg::argparse_read_short(options, 2, nullptr, cluster + 1);
+  CHECK(read.option == options);
+  CHECK(std::strcmp(read.value, "1") == 0);
+  CHECK(read.next == cluster + 2);
+  read = veg::argparse_read_short(options, 2, nullptr, read.next);
+  CHECK(read.option == options + 1);
+  CHECK(read.value == cluster + 3);
+  CHECK(read.next == nullptr);
+  read = veg::argparse_read_short(options, 2, nullptr, cluster + 2, 1);
+  CHECK(read.option == options + 1);
+  CHECK(read.value == nullptr);
+  read = veg::argparse_read_short(options, 2, nullptr, "xv");
+  CHECK(read.option == nullptr);
+  CHECK(std::strcmp(read.error, "unknown option") == 0);
+  CHECK(read.next == nullptr);
+
+  read = veg::argparse_read_long(options, 2, nullptr, "no-verbose");
+  CHECK(read.option == options);
+  CHECK(read.negated);
+  CHECK(std::strcmp(read.value, "0") == 0);
+  read = veg::argparse_read_long(options, 2, nullptr, "verbose=1");
+  CHECK(read.option == options);
+  CHECK(std::strcmp(read.error, "takes no value") == 0);
+  read = veg::argparse_read_long(options, 2, nullptr, "num=4,5", 5);
+  CHECK(read.option == options + 1);
+  CHECK(std::strcmp(read.value, "4,5") == 0);
+  read = veg::argparse_read_long(options, 2, nullptr, "num");
+  CHECK(read.value == nullptr);
+  CHECK(read.error == nullptr);
+}
@@ -0,0 +1,248 @@
+#include "doctest.h"
+#include "argparse_incremental.hpp"
+#include "argparse_pattern.hpp"
+#include "argparse_reload.hpp"
+#include "argparse_span.hpp"
+#include "argparse_std.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+namespace {
+
+struct config {
+  char const* tenant;
+  long num;
+  bool force;
+};
+
+config values = {"default", 1, false};
+
+veg::argparse_option const options[] = {
+    {&values.tenant, 't', "tenant"},
+    {&values.num, 'n', "num"},
+    {&values.force, 'f', "force"},
+};
+constexpr std::size_t n_options = sizeof(options) / sizeof(options[0]);
+
+constexpr veg::argparse_pattern patterns[] = {
+    {"tenant", "[a-z][a-z0-9-]{2,8}"},
+};
+
+constexpr char const* mismatch = "does not match `[a-z][a-z0-9-]{2,8}`";
+
+// an index over `table`, `options` by default, with `patterns` attached
+struct indexed {
+  std::uint32_t index_storage[512];
+  void* pattern_storage[512];
+  veg::argparse_index index;
+
+  explicit indexed(
+      veg::argparse_option const* table = options, std::size_t n = n_options) {
+    REQUIRE(veg::argparse_index_build(
+        &index, table, n, index_storage, sizeof(index_storage)));
+    REQUIRE(
+        veg::argparse_patterns_storage_size(n, patterns, 1) <=
+        sizeof(pattern_storage));
+    REQUIRE(veg::argparse_index_match(
+        &index, patterns, 1, pattern_storage, sizeof(pattern_storage)));
+  }
+};
+
+// compiles `regex` as the pattern of `--tenant`, and returns the error it
+// reports, empty if the pattern is valid
+auto compile_error(char const* regex) -> std::string {
+  std::uint32_t index_storage[512];
+  void* pattern_storage[512];
+  veg::argparse_index index;
+  REQUIRE(veg::argparse_index_build(
+      &index, options, n_options, index_storage, sizeof(index_storage)));
+  veg::argparse_pattern const pattern[] = {{"tenant", regex}};
+
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  std::fflush(stderr);
+  int saved = dup(2);
+  dup2(fds[1], 2);
+  close(fds[1]);
+  bool matched = veg::argparse_index_match(
+      &index, pattern, 1, pattern_storage, sizeof(pattern_storage));
+  std::fflush(stderr);
+  dup2(saved, 2);
+  close(saved);
+  std::string error;
+  char buf[256];
+  for (ssize_t n; (n = read(fds[0], buf, sizeof(buf))) > 0;) {
+    error.append(buf, std::size_t(n));
+  }
+  close(fds[0]);
+  CHECK(matched == error.empty());
+  return error;
+}
+
+} // namespace
+
+TEST_CASE("pattern: POSIX brackets in sets are rejected") {
+  for (char const* regex :
+       {"[[:alpha:]]+", "[a[=a=]]", "[[.-.]]", "[^[:digit:]]", "[a-[:z:]]"}) {
+    CAPTURE(regex);
+    CHECK(
+        compile_error(regex) ==
+        "error: pattern `" + std::string(regex) +
+            "` of option `--tenant` has an unsupported `[:`, `[=` or `[.` in "
+            "a set\n");
+  }
+  // `[` bytes are accepted, alone or escaped
+  for (char const* regex : {"[[]", "[a[]:", "[\\[:]", "[[a]"}) {
+    CAPTURE(regex);
+    CHECK(compile_error(regex).empty());
+  }
+}
+
+TEST_CASE("pattern: the whole value must match") {
+  indexed patterned;
+  auto const* tenant = options + 0;
+  for (char const* arg : {"abc", "a-1", "abcdefghi", "z0-0-0"}) {
+    CAPTURE(arg);
+    CHECK(veg::argparse_index_check(
+              &patterned.index, tenant, arg, std::strlen(arg)) == nullptr);
+  }
+  for (char const* arg : {"", "ab", "1abc", "abcdefghij", "abc_", "Abc"}) {
+    CAPTURE(arg);
+    CHECK(
+        std::string(veg::argparse_index_check(
+            &patterned.index, tenant, arg, std::strlen(arg))) == mismatch);
+  }
+  // the bytes past the size are not read
+  CHECK(
+      veg::argparse_index_check(&patterned.index, tenant, "abc_", 3) ==
+      nullptr);
+  // options without a pattern accept anything
+  CHECK(
+      veg::argparse_index_check(&patterned.index, options + 1, "x", 1) ==
+      nullptr);
+}
+
+TEST_CASE("pattern: values are checked before they are set") {
+  indexed patterned;
+  values = {"default", 1, false};
+  auto const* tenant = options + 0;
+  CHECK(
+      std::string(veg::argparse_check_value(tenant, "A", &patterned.index)) ==
+      mismatch);
+  CHECK(
+      std::string(veg::argparse_set_value(tenant, "A", &patterned.index)) ==
+      mismatch);
+  CHECK(std::string(values.tenant) == "default");
+  CHECK(veg::argparse_check_value(tenant, "acme", &patterned.index) == nullptr);
+  CHECK(veg::argparse_set_value(tenant, "acme", &patterned.index) == nullptr);
+  CHECK(std::string(values.tenant) == "acme");
+  // without the index, the pattern is not known
+  CHECK(veg::argparse_set_value(tenant, "A") == nullptr);
+  CHECK(std::string(values.tenant) == "A");
+}
+
+TEST_CASE("pattern: spans are checked") {
+  // `char const*` targets cannot be set from spans
+  std::string_view tenant = "default";
+  long num = 1;
+  bool force = false;
+  veg::argparse_option const viewed[] = {
+      {&tenant, 't', "tenant"},
+      {&num, 'n', "num"},
+      {&force, 'f', "force"},
+  };
+  indexed patterned(viewed, 3);
+  std::string_view args[] = {"-f", "--tenant=Acme", "-n", "2"};
+  std::size_t rest[4];
+  auto result = veg::parse_span(patterned.index, args, 4, rest);
+  REQUIRE(result.error != nullptr);
+  CHECK(std::string(result.error) == mismatch);
+  CHECK(result.failed == 1);
+  CHECK(tenant == "default");
+
+  args[1] = "--tenant=acme";
+  result = veg::parse_span(patterned.index, args, 4, rest);
+  CHECK(result.error == nullptr);
+  CHECK(tenant == "acme");
+  CHECK(num == 2);
+  CHECK(force);
+}
+
+TEST_CASE("pattern: incremental lines are checked when edited and applied") {
+  indexed patterned;
+  values = {"default", 1, false};
+  veg::argparse_token tokens[8];
+  std::uint32_t last[n_options];
+  veg::argparse_incremental line;
+  veg::argparse_incremental_init(
+      &line, options, n_options, &patterned.index, 0, tokens, 8, last);
+  char const* args[] = {"-t", "A", "-n3"};
+  REQUIRE(veg::argparse_incremental_edit(&line, 0, 0, args, 3));
+  std::size_t token = 0;
+  char const* reason = veg::argparse_incremental_error(&line, &token);
+  REQUIRE(reason != nullptr);
+  CHECK(std::string(reason) == mismatch);
+  CHECK(token == 1);
+  veg::argparse_option const* failed = nullptr;
+  reason = veg::argparse_incremental_apply(&line, &failed);
+  REQUIRE(reason != nullptr);
+  CHECK(std::string(reason) == mismatch);
+  CHECK(failed == options + 0);
+
+  // values given along with their option are checked as well
+  char const* joined[] = {"--tenant=A"};
+  REQUIRE(veg::argparse_incremental_edit(&line, 0, 2, joined, 1));
+  reason = veg::argparse_incremental_error(&line, &token);
+  REQUIRE(reason != nullptr);
+  CHECK(std::string(reason) == mismatch);
+  CHECK(token == 0);
+
+  char const* fixed[] = {"-t", "acme"};
+  REQUIRE(veg::argparse_incremental_edit(&line, 0, 1, fixed, 2));
+  CHECK(veg::argparse_incremental_error(&line, &token) == nullptr);
+  CHECK(veg::argparse_incremental_apply(&line, &failed) == nullptr);
+  CHECK(std::string(values.tenant) == "acme");
+  CHECK(values.num == 3);
+}
+
+TEST_CASE("pattern: reloaded files are checked") {
+  indexed patterned;
+  veg::argparse_reload_reader readers[1];
+  alignas(std::max_align_t) char storage[1024];
+  veg::argparse_reload reload;
+  REQUIRE(veg::argparse_reload_init(
+      &reload,
+      options,
+      &patterned.index,
+      &values,
+      256,
+      readers,
+      storage,
+      sizeof(storage)));
+
+  char path[] = "/tmp/test_pattern_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+  auto reload_with = [&](char const* text) {
+    std::FILE* file = std::fopen(path, "w");
+    REQUIRE(file != nullptr);
+    std::fputs(text, file);
+    std::fclose(file);
+    return veg::argparse_reload_file(&reload, path);
+  };
+
+  char const* reason = reload_with("num=5\ntenant=Acme\n");
+  REQUIRE(reason != nullptr);
+  CHECK(std::string(reason) == mismatch);
+  CHECK(reload.error_line == 2);
+  CHECK(reload_with("num=5\ntenant=acme\n") == nullptr);
+  auto const* current = veg::argparse_reload_snapshot<config>(&reload);
+  CHECK(std::string(current->tenant) == "acme");
+  CHECK(current->num == 5);
+  unlink(path);
+}
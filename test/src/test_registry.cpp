@@ -0,0 +1,148 @@
+#include "doctest.h"
+#include "argparse.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+// calls `fn`, and returns what it wrote to stderr
+template <typename Fn>
+auto capture_stderr(Fn fn) -> std::string {
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  std::fflush(stderr);
+  int saved = dup(2);
+  dup2(fds[1], 2);
+  close(fds[1]);
+  fn();
+  std::fflush(stderr);
+  dup2(saved, 2);
+  close(saved);
+  std::string out;
+  char buf[256];
+  for (ssize_t n; (n = read(fds[0], buf, sizeof(buf))) > 0;) {
+    out.append(buf, std::size_t(n));
+  }
+  close(fds[0]);
+  return out;
+}
+
+long log_level = 0;
+veg::argparse_option const log_options[] = {
+    "Log options",
+    {&log_level, "log-level"},
+};
+// registered before the cache module, merged after it
+ARGPARSE_MODULE(log, log_options);
+
+long cache_size = 64;
+bool cache_enabled = false;
+veg::argparse_option const cache_options[] = {
+    "Cache options",
+    {&cache_size, "cache-size"},
+    {&cache_enabled, 'c', "cache"},
+};
+ARGPARSE_MODULE(cache, cache_options);
+
+} // namespace
+
+TEST_CASE("registry: modules are merged by name") {
+  alignas(veg::argparse_option) static unsigned char storage[2048];
+  std::size_t size = veg::argparse_registry_storage_size();
+  REQUIRE(size <= sizeof(storage));
+  veg::argparse_index index;
+  REQUIRE(veg::argparse_registry_build(&index, storage, size));
+  REQUIRE(index.len == 5);
+  CHECK(std::strcmp(index.options[0].help, "Cache options") == 0);
+  CHECK(std::strcmp(index.options[3].help, "Log options") == 0);
+
+  char const* const usages[] = {"test_registry"};
+  char args[][16] = {"test_registry", "-c", "--log-level=2", "--cache-size=8"};
+  char* argv[] = {args[0], args[1], args[2], args[3], nullptr};
+  int argc = 4;
+  veg::parse_args(&argc, argv, index, usages);
+  CHECK(argc == 0);
+  CHECK(cache_enabled);
+  CHECK(cache_size == 8);
+  CHECK(log_level == 2);
+}
+
+TEST_CASE("registry: tables are parsed in a single pass") {
+  bool verbose = false;
+  long port = 0;
+  char const* host = nullptr;
+  long level = 0;
+  veg::argparse_option const app_options[] = {
+      {&verbose, 'v', "verbose"},
+  };
+  veg::argparse_option const net_options[] = {
+      "Network options",
+      {&port, 'p', "port"},
+      {&host, "host"},
+  };
+  veg::argparse_option const log_options_[] = {
+      {&level, "level"},
+  };
+  veg::argparse_table const tables[] = {
+      {"app", app_options},
+      {"net", net_options},
+      {"log", log_options_},
+  };
+  alignas(veg::argparse_option) unsigned char storage[2048];
+  std::size_t size = veg::argparse_tables_storage_size(tables, 3);
+  REQUIRE(size <= sizeof(storage));
+  veg::argparse_index index;
+  CHECK_FALSE(
+      veg::argparse_tables_build(&index, tables, 3, storage, size - 1));
+  REQUIRE(veg::argparse_tables_build(&index, tables, 3, storage, size));
+  CHECK(index.len == 5);
+
+  char const* const usages[] = {"test_registry"};
+  char args[][16] = {
+      "test_registry", "--level=3", "-vp", "80", "--host", "h", "in"};
+  char* argv[] = {
+      args[0], args[1], args[2], args[3], args[4], args[5], args[6], nullptr};
+  int argc = 7;
+  veg::parse_args(&argc, argv, index, usages);
+  REQUIRE(argc == 1);
+  CHECK(std::strcmp(argv[0], "in") == 0);
+  CHECK(verbose);
+  CHECK(port == 80);
+  CHECK(std::strcmp(host, "h") == 0);
+  CHECK(level == 3);
+}
+
+TEST_CASE("registry: names shared by tables are reported with both tables") {
+  bool verbose = false;
+  bool version = false;
+  long level = 0;
+  veg::argparse_option const app_options[] = {
+      {&verbose, 'v', "verbose"},
+  };
+  veg::argparse_option const net_options[] = {
+      {&verbose, "verbose"},
+  };
+  veg::argparse_option const log_options_[] = {
+      {&level, "level"},
+      {&version, 'v', "version"},
+  };
+  veg::argparse_table const tables[] = {
+      {"app", app_options},
+      {"net", net_options},
+      {"log", log_options_},
+  };
+  alignas(veg::argparse_option) unsigned char storage[2048];
+  std::size_t size = veg::argparse_tables_storage_size(tables, 3);
+  REQUIRE(size <= sizeof(storage));
+  veg::argparse_index index;
+  bool built = true;
+  std::string errors = capture_stderr([&] {
+    built = veg::argparse_tables_build(&index, tables, 3, storage, size);
+  });
+  CHECK_FALSE(built);
+  CHECK(errors ==
+        "error: option `--verbose` of `net` is already declared by `app`\n"
+        "error: option `-v` of `log` is already declared by `app`\n");
+}
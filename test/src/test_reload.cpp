@@ -0,0 +1,165 @@
+#include "doctest.h"
+#include "argparse_reload.hpp"
+#include <csignal>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+struct tunables {
+  long num;
+  bool verbose;
+};
+
+tunables defaults = {1, false};
+
+veg::argparse_option const options[] = {
+    {&defaults.num, 'n', "num"},
+    {&defaults.verbose, 'v', "verbose"},
+};
+
+constexpr std::size_t text_size = 64;
+
+// a reload over two slots, reading a temporary config file
+struct reloader {
+  alignas(std::max_align_t) char storage[1024];
+  veg::argparse_reload_reader readers[2];
+  veg::argparse_reload reload;
+  char path[32] = "/tmp/test_reload_XXXXXX";
+
+  reloader() {
+    std::size_t size =
+        veg::argparse_reload_storage_size(sizeof(tunables), text_size, 2);
+    REQUIRE(size <= sizeof(storage));
+    REQUIRE(veg::argparse_reload_init(
+        &reload,
+        options,
+        nullptr,
+        &defaults,
+        text_size,
+        readers,
+        storage,
+        size));
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+  }
+  ~reloader() { unlink(path); }
+  reloader(reloader const&) = delete;
+  auto operator=(reloader const&) -> reloader& = delete;
+
+  auto current() const -> tunables const* {
+    return veg::argparse_reload_snapshot<tunables>(&reload);
+  }
+
+  void write(char const* text) const {
+    std::FILE* file = std::fopen(path, "w");
+    REQUIRE(file != nullptr);
+    std::fputs(text, file);
+    std::fclose(file);
+  }
+
+  auto load(char const* text) -> char const* {
+    write(text);
+    return veg::argparse_reload_file(&reload, path);
+  }
+};
+
+} // namespace
+
+TEST_CASE("reload: a new snapshot is published") {
+  reloader r;
+  tunables const* first = r.current();
+  CHECK(first->num == 1);
+  CHECK_FALSE(first->verbose);
+
+  CHECK(r.load("# tunables\n--num=5\n\nverbose\n") == nullptr);
+  tunables const* second = r.current();
+  CHECK(second != first);
+  CHECK(second->num == 5);
+  CHECK(second->verbose);
+  // each reload starts from the prototype, which is left untouched
+  CHECK(r.load("no-verbose") == nullptr);
+  CHECK(r.current()->num == 1);
+  CHECK_FALSE(r.current()->verbose);
+  CHECK(defaults.num == 1);
+}
+
+TEST_CASE("reload: a rejected file keeps the snapshot") {
+  reloader r;
+  REQUIRE(r.load("num=5") == nullptr);
+  tunables const* published = r.current();
+
+  char const* reason = r.load("verbose\nnum=x\n");
+  REQUIRE(reason != nullptr);
+  CHECK(std::string(reason) == "expects an integer value");
+  CHECK(r.reload.error_line == 2);
+  CHECK(r.current() == published);
+  CHECK(r.current()->num == 5);
+  CHECK_FALSE(r.current()->verbose);
+
+  CHECK(std::string(r.load("size=2")) == "unknown option");
+  CHECK(std::string(r.load("verbose=1")) == "flag does not take a value");
+  CHECK(std::string(r.load("num")) == "option requires a value");
+  std::string large(text_size, '#');
+  CHECK(std::string(r.load(large.c_str())) == "config file is too large");
+  unlink(r.path);
+  CHECK(veg::argparse_reload_file(&r.reload, r.path) != nullptr);
+  CHECK(r.current() == published);
+}
+
+TEST_CASE("reload: slots held by online readers are not reused") {
+  reloader r;
+  auto* reader = &r.readers[0];
+  veg::argparse_reload_online(&r.reload, reader);
+  tunables const* held = r.current();
+
+  // the free slot is used, and the one held is retired
+  REQUIRE(r.load("num=2") == nullptr);
+  tunables const* second = r.current();
+  CHECK(
+      std::string(r.load("num=3")) == "all the snapshots are still in use");
+  CHECK(r.current() == second);
+  CHECK(held->num == 1);
+
+  SUBCASE("until the reader goes through a quiescent state") {
+    veg::argparse_reload_quiescent(&r.reload, reader);
+    CHECK(r.load("num=3") == nullptr);
+    CHECK(r.current() == held);
+    CHECK(r.current()->num == 3);
+    // the second snapshot was retired after the reader's last quiescent state
+    CHECK(
+        std::string(r.load("num=4")) == "all the snapshots are still in use");
+  }
+  SUBCASE("until the reader goes offline") {
+    veg::argparse_reload_offline(reader);
+    CHECK(r.load("num=3") == nullptr);
+    CHECK(r.current()->num == 3);
+    CHECK(r.load("num=4") == nullptr);
+    CHECK(r.current()->num == 4);
+  }
+}
+
+TEST_CASE("reload: requests are polled") {
+  reloader r;
+  r.write("num=7");
+  tunables const* first = r.current();
+  CHECK(veg::argparse_reload_poll(&r.reload, r.path) == nullptr);
+  CHECK(r.current() == first);
+
+  veg::argparse_reload_request(&r.reload);
+  CHECK(veg::argparse_reload_poll(&r.reload, r.path) == nullptr);
+  CHECK(r.current()->num == 7);
+
+  r.write("num=8");
+  REQUIRE(veg::argparse_reload_on_signal(&r.reload, SIGUSR1));
+  std::raise(SIGUSR1);
+  std::signal(SIGUSR1, SIG_DFL);
+  CHECK(veg::argparse_reload_poll(&r.reload, r.path) == nullptr);
+  CHECK(r.current()->num == 8);
+  // the request is consumed
+  r.write("num=9");
+  CHECK(veg::argparse_reload_poll(&r.reload, r.path) == nullptr);
+  CHECK(r.current()->num == 8);
+}
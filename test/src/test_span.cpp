@@ -0,0 +1,68 @@
+#include "doctest.h"
+#include "argparse_span.hpp"
+#include "argparse_std.hpp"
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// keeps a pointer to its argument, as `char const*` does
+struct label {
+  char const* text = nullptr;
+};
+
+} // namespace
+
+template <>
+struct veg::option_traits<label> {
+  static constexpr char const* placeholder = "<label>";
+  static auto parse(label& out, char const* arg) -> char const* {
+    out.text = arg;
+    return nullptr;
+  }
+};
+
+TEST_CASE("span: wrappers forward to the parse_view of their type") {
+  std::optional<std::string_view> name;
+  std::optional<long> num;
+  std::atomic<int> jobs{1};
+  std::chrono::milliseconds timeout{};
+  veg::argparse_option const options[] = {
+      {&name, "name"},
+      {&num, 'n', "num"},
+      {&jobs, 'j', "jobs"},
+      {&timeout, "timeout"},
+  };
+  // a single buffer, so that no value is null-terminated
+  std::string_view const line = "--name=db-n16-j4--timeout=2s";
+  std::string_view const args[] = {
+      line.substr(0, 9),
+      line.substr(9, 4),
+      line.substr(13, 3),
+      line.substr(16, 12),
+  };
+  std::size_t rest[4];
+  auto result = veg::parse_span(options, args, 4, rest);
+  CHECK(result.error == nullptr);
+  REQUIRE(name.has_value());
+  CHECK(*name == "db");
+  CHECK(name->data() == line.data() + 7);
+  CHECK(num == 16);
+  CHECK(jobs.load() == 4);
+  CHECK(timeout == std::chrono::seconds(2));
+}
+
+TEST_CASE("span: user-defined types without parse_view are rejected") {
+  label tag;
+  veg::argparse_option const options[] = {
+      {&tag, "tag"},
+  };
+  std::string_view const args[] = {"--tag=x"};
+  std::size_t rest[1];
+  auto result = veg::parse_span(options, args, 1, rest);
+  CHECK(std::string(result.error) == "requires a null-terminated argument");
+  CHECK(tag.text == nullptr);
+}
@@ -0,0 +1,123 @@
+#include "doctest.h"
+#include "argparse_std.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+template <typename T>
+auto parse(T& out, char const* arg) -> std::string {
+  char const* reason = veg::option_traits<T>::parse(out, arg);
+  return reason != nullptr ? reason : "";
+}
+
+} // namespace
+
+TEST_CASE("std: duration units") {
+  std::chrono::milliseconds ms{};
+  CHECK(parse(ms, "250ms") == "");
+  CHECK(ms.count() == 250);
+  CHECK(parse(ms, "1.5s") == "");
+  CHECK(ms.count() == 1500);
+  CHECK(parse(ms, "2min") == "");
+  CHECK(ms.count() == 120000);
+  CHECK(parse(ms, "1h") == "");
+  CHECK(ms.count() == 3600000);
+  CHECK(parse(ms, "1500us") == "");
+  CHECK(ms.count() == 1);
+  CHECK(parse(ms, "999999ns") == "");
+  CHECK(ms.count() == 0);
+  CHECK(parse(ms, "-3ms") == "");
+  CHECK(ms.count() == -3);
+
+  std::chrono::duration<double> seconds{};
+  CHECK(parse(seconds, "250ms") == "");
+  CHECK(seconds.count() == doctest::Approx(0.25));
+}
+
+TEST_CASE("std: duration without unit is counted in its period") {
+  std::chrono::milliseconds ms{};
+  CHECK(parse(ms, "42") == "");
+  CHECK(ms.count() == 42);
+
+  std::chrono::minutes minutes{};
+  CHECK(parse(minutes, "3") == "");
+  CHECK(minutes.count() == 3);
+  CHECK(parse(minutes, "90s") == "");
+  CHECK(minutes.count() == 1);
+}
+
+TEST_CASE("std: invalid durations") {
+  std::chrono::milliseconds ms{7};
+  CHECK(parse(ms, "") == "expects a duration");
+  CHECK(parse(ms, "ms") == "expects a duration");
+  CHECK(parse(ms, "3 ms") == "expects one of the ns, us, ms, s, min or h units");
+  CHECK(parse(ms, "3days") == "expects one of the ns, us, ms, s, min or h units");
+  CHECK(ms.count() == 7);
+}
+
+TEST_CASE("std: non-finite and out of range durations") {
+  char const* const reason = "expects a finite duration in range";
+  std::chrono::milliseconds ms{7};
+  CHECK(parse(ms, "inf") == reason);
+  CHECK(parse(ms, "-infs") == reason);
+  CHECK(parse(ms, "nanms") == reason);
+  CHECK(parse(ms, "1e5000s") == reason);
+  CHECK(parse(ms, "1e300h") == reason);
+  CHECK(ms.count() == 7);
+
+  std::chrono::duration<std::int8_t> small{};
+  CHECK(parse(small, "127s") == "");
+  CHECK(small.count() == 127);
+  CHECK(parse(small, "-128") == "");
+  CHECK(small.count() == -128);
+  CHECK(parse(small, "128") == reason);
+  CHECK(parse(small, "3min") == reason);
+  CHECK(parse(small, "-129s") == reason);
+
+  std::chrono::duration<std::uint16_t, std::milli> unsigned_ms{};
+  CHECK(parse(unsigned_ms, "65.535s") == "");
+  CHECK(unsigned_ms.count() == 65535);
+  CHECK(parse(unsigned_ms, "66s") == reason);
+  CHECK(parse(unsigned_ms, "-1ms") == reason);
+
+  std::chrono::duration<float> seconds{};
+  CHECK(parse(seconds, "1e39s") == reason);
+  CHECK(parse(seconds, "1e30s") == "");
+}
+
+TEST_CASE("std: ordered_atomic is parsed as its own type") {
+  using relaxed_int = veg::ordered_atomic<int, std::memory_order_relaxed>;
+  static_assert(
+      std::is_same<
+          decltype(&veg::option_traits<relaxed_int>::parse),
+          auto (*)(relaxed_int&, char const*)->char const*>::value,
+      "");
+  static_assert(
+      std::is_same<
+          decltype(&veg::option_traits<std::atomic<int>>::parse),
+          auto (*)(std::atomic<int>&, char const*)->char const*>::value,
+      "");
+
+  relaxed_int jobs{1};
+  std::atomic<bool> verbose{false};
+  veg::argparse_option const options[] = {
+      {&jobs, 'j', "jobs"},
+      {&verbose, "verbose"},
+  };
+  char const* const usages[] = {"test_std"};
+  char args[][10] = {"test_std", "-j", "8", "--verbose"};
+  char* argv[] = {args[0], args[1], args[2], args[3], nullptr};
+  int argc = 4;
+  veg::parse_args(&argc, argv, options, usages);
+  CHECK(argc == 0);
+  CHECK(jobs.load() == 8);
+  CHECK(verbose.load());
+
+  char buf[16];
+  CHECK(veg::option_traits<relaxed_int>::format(jobs, buf, sizeof(buf)) == 1);
+  CHECK(std::string(buf) == "8");
+}
@@ -0,0 +1,59 @@
+// starting a thread fails: `pthread_create` is interposed, and fails once a
+// budget of threads is exhausted. built as its own executable, as the
+// interposition applies to every thread of the process
+#include "doctest.h"
+#include "argparse_deferred.hpp"
+#include <atomic>
+#include <cerrno>
+#include <dlfcn.h>
+#include <pthread.h>
+
+namespace {
+
+// number of threads left to start before `pthread_create` fails, or -1
+std::atomic<int> thread_budget{-1};
+
+} // namespace
+
+// interposed, so that starting a thread can be made to fail
+extern "C" auto pthread_create(
+    pthread_t* thread,
+    pthread_attr_t const* attr,
+    void* (*start)(void*),
+    void* arg) -> int {
+  using create_fn = auto (*)(
+      pthread_t*, pthread_attr_t const*, void* (*)(void*), void*)->int;
+  static auto const next =
+      reinterpret_cast<create_fn>(dlsym(RTLD_NEXT, "pthread_create"));
+  int budget = thread_budget.load();
+  if (budget == 0) {
+    return EAGAIN;
+  }
+  if (budget > 0) {
+    thread_budget.store(budget - 1);
+  }
+  return next(thread, attr, start, arg);
+}
+
+TEST_CASE("deferred: calls of threads that fail to start run on the others") {
+  std::atomic<int> n_calls{0};
+  // the option refers to the callback, which must outlive it
+  auto count = [&](veg::argparse* /*unused*/,
+                   veg::argparse_option const* /*unused*/) {
+    n_calls.fetch_add(1);
+    return 0;
+  };
+  int dummy = 0;
+  veg::argparse_option const option = veg::with_flags(
+      {&dummy, "dummy", "", count}, veg::OPT_INDEPENDENT);
+
+  veg::argparse_deferred_call calls[8];
+  for (auto& call : calls) {
+    call = {&option, 1};
+  }
+  veg::argparse_deferred deferred = {calls, 8, 8};
+  thread_budget.store(1);
+  CHECK(veg::argparse_run_deferred(&deferred, 4) == 0);
+  thread_budget.store(-1);
+  CHECK(n_calls.load() == 8);
+}